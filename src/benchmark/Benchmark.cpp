@@ -0,0 +1,409 @@
+// Headless benchmark for the RasterTileExtractor and VectorExtractor processing libraries.
+// Generates synthetic GeoTIFF and GeoPackage fixtures with GDAL, times the most common operations
+// across sizes and thread counts, and prints the results as JSON so that they can be compared
+// between commits.
+//
+// Usage: geodot-benchmark [sizes=256,512,1024] [threads=1,2,4] [iterations=50]
+//                         [features=100000] [output=results.json] [workdir=.]
+//
+// Sizes are the edge lengths of the queried squares in pixels (and meters), from 1 to 4096.
+
+#include "NativeDataset.h"
+#include "NativeLayer.h"
+#include "PointFeature.h"
+#include "RasterTileExtractor.h"
+#include "VectorExtractor.h"
+#include "gdal-includes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int RASTER_SIZE_PIXELS = 4096;
+const double RASTER_PIXEL_SIZE = 1.0;
+const double RASTER_ORIGIN_X = 500000.0;
+const double RASTER_ORIGIN_Y = 5000000.0;
+
+struct BenchmarkSettings {
+    std::vector<int> sizes{256, 512, 1024};
+    std::vector<int> thread_counts{1, 2, 4};
+    int iterations = 50;
+    int feature_count = 100000;
+    std::string output_path;
+    std::string working_directory = ".";
+};
+
+struct BenchmarkResult {
+    std::string name;
+    int size;
+    int threads;
+    int operations;
+    double total_seconds;
+    double mean_milliseconds;
+    double min_milliseconds;
+    double max_milliseconds;
+};
+
+std::vector<int> parse_int_list(const std::string &value) {
+    std::vector<int> result;
+    std::stringstream stream(value);
+    std::string entry;
+
+    while (std::getline(stream, entry, ',')) {
+        if (!entry.empty()) { result.emplace_back(std::stoi(entry)); }
+    }
+
+    return result;
+}
+
+BenchmarkSettings parse_arguments(int argc, char **argv) {
+    BenchmarkSettings settings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        size_t separator = argument.find('=');
+        if (separator == std::string::npos) {
+            std::cerr << "Ignoring malformed argument: " << argument << std::endl;
+            continue;
+        }
+
+        std::string key = argument.substr(0, separator);
+        std::string value = argument.substr(separator + 1);
+
+        if (key == "sizes") {
+            settings.sizes.clear();
+
+            // Squares must fit into the raster fixture so that random offsets stay within it
+            for (int size : parse_int_list(value)) {
+                if (size > 0 && size <= RASTER_SIZE_PIXELS) {
+                    settings.sizes.emplace_back(size);
+                } else {
+                    std::cerr << "Ignoring size outside of 1 to " << RASTER_SIZE_PIXELS << ": "
+                              << size << std::endl;
+                }
+            }
+        } else if (key == "threads") {
+            settings.thread_counts = parse_int_list(value);
+        } else if (key == "iterations") {
+            settings.iterations = std::stoi(value);
+        } else if (key == "features") {
+            settings.feature_count = std::stoi(value);
+        } else if (key == "output") {
+            settings.output_path = value;
+        } else if (key == "workdir") {
+            settings.working_directory = value;
+        } else {
+            std::cerr << "Ignoring unknown argument: " << key << std::endl;
+        }
+    }
+
+    return settings;
+}
+
+/// Create a Float32 GeoTIFF heightmap with smooth synthetic terrain.
+bool create_raster_fixture(const std::string &path) {
+    GDALDriver *driver = (GDALDriver *)GDALGetDriverByName("GTiff");
+    if (driver == nullptr) { return false; }
+
+    CPLStringList options;
+    options.AddString("TILED=YES");
+    options.AddString("BLOCKXSIZE=256");
+    options.AddString("BLOCKYSIZE=256");
+
+    GDALDataset *dataset = driver->Create(path.c_str(), RASTER_SIZE_PIXELS, RASTER_SIZE_PIXELS, 1,
+                                          GDT_Float32, options.List());
+    if (dataset == nullptr) { return false; }
+
+    double transform[6] = {RASTER_ORIGIN_X, RASTER_PIXEL_SIZE, 0.0,
+                           RASTER_ORIGIN_Y, 0.0,               -RASTER_PIXEL_SIZE};
+    dataset->SetGeoTransform(transform);
+
+    GDALRasterBand *band = dataset->GetRasterBand(1);
+    std::vector<float> row(RASTER_SIZE_PIXELS);
+
+    for (int y = 0; y < RASTER_SIZE_PIXELS; y++) {
+        for (int x = 0; x < RASTER_SIZE_PIXELS; x++) {
+            row[x] = 500.0f + 100.0f * std::sin(x * 0.01f) * std::cos(y * 0.013f) +
+                     10.0f * std::sin(x * 0.1f + y * 0.07f);
+        }
+
+        band->RasterIO(GF_Write, 0, y, RASTER_SIZE_PIXELS, 1, row.data(), RASTER_SIZE_PIXELS, 1,
+                       GDT_Float32, 0, 0);
+    }
+
+    GDALClose(dataset);
+    return true;
+}
+
+/// Create a GeoPackage with a point layer of uniformly distributed points within the raster extent.
+bool create_vector_fixture(const std::string &path, int feature_count) {
+    GDALDriver *driver = (GDALDriver *)GDALGetDriverByName("GPKG");
+    if (driver == nullptr) { return false; }
+
+    GDALDataset *dataset = driver->Create(path.c_str(), 0, 0, 0, GDT_Unknown, nullptr);
+    if (dataset == nullptr) { return false; }
+
+    OGRLayer *layer = dataset->CreateLayer("points", nullptr, wkbPoint, nullptr);
+    OGRFieldDefn value_field("value", OFTInteger);
+    layer->CreateField(&value_field);
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> offset(0.0, RASTER_SIZE_PIXELS * RASTER_PIXEL_SIZE);
+
+    dataset->StartTransaction();
+
+    for (int i = 0; i < feature_count; i++) {
+        OGRFeature *feature = OGRFeature::CreateFeature(layer->GetLayerDefn());
+        feature->SetField("value", i % 100);
+
+        OGRPoint point(RASTER_ORIGIN_X + offset(generator), RASTER_ORIGIN_Y - offset(generator));
+        feature->SetGeometry(&point);
+
+        layer->CreateFeature(feature);
+        OGRFeature::DestroyFeature(feature);
+    }
+
+    dataset->CommitTransaction();
+
+    GDALClose(dataset);
+    return true;
+}
+
+/// Run the given operation `operations_per_thread` times on each of `thread_count` threads.
+/// The operation is given the index of its thread and a random number generator.
+/// `setup` is called once per thread before timing starts and may open per-thread resources.
+BenchmarkResult run_benchmark(const std::string &name, int size, int thread_count,
+                              int operations_per_thread,
+                              const std::function<std::function<void(std::mt19937 &)>(int)> &setup) {
+    std::vector<std::function<void(std::mt19937 &)>> operations;
+    for (int thread_index = 0; thread_index < thread_count; thread_index++) {
+        operations.emplace_back(setup(thread_index));
+    }
+
+    std::vector<std::vector<double>> durations(thread_count);
+    std::vector<std::thread> threads;
+    std::atomic<bool> start{false};
+
+    for (int thread_index = 0; thread_index < thread_count; thread_index++) {
+        threads.emplace_back([&, thread_index]() {
+            std::mt19937 generator(1337 + thread_index);
+
+            while (!start.load()) { std::this_thread::yield(); }
+
+            for (int i = 0; i < operations_per_thread; i++) {
+                auto before = std::chrono::steady_clock::now();
+                operations[thread_index](generator);
+                auto after = std::chrono::steady_clock::now();
+
+                durations[thread_index].emplace_back(
+                    std::chrono::duration<double, std::milli>(after - before).count());
+            }
+        });
+    }
+
+    auto total_before = std::chrono::steady_clock::now();
+    start = true;
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    auto total_after = std::chrono::steady_clock::now();
+
+    std::vector<double> all_durations;
+    for (const std::vector<double> &thread_durations : durations) {
+        all_durations.insert(all_durations.end(), thread_durations.begin(), thread_durations.end());
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.size = size;
+    result.threads = thread_count;
+    result.operations = all_durations.size();
+    result.total_seconds = std::chrono::duration<double>(total_after - total_before).count();
+    result.mean_milliseconds = 0.0;
+    result.min_milliseconds = all_durations.empty() ? 0.0 : all_durations.front();
+    result.max_milliseconds = 0.0;
+
+    for (double duration : all_durations) {
+        result.mean_milliseconds += duration;
+        result.min_milliseconds = std::min(result.min_milliseconds, duration);
+        result.max_milliseconds = std::max(result.max_milliseconds, duration);
+    }
+
+    if (!all_durations.empty()) { result.mean_milliseconds /= all_durations.size(); }
+
+    std::cerr << name << " size=" << size << " threads=" << thread_count << ": "
+              << result.mean_milliseconds << " ms mean" << std::endl;
+
+    return result;
+}
+
+std::string escape_json(const std::string &value) {
+    std::string escaped;
+
+    for (char character : value) {
+        if (character == '"' || character == '\\') { escaped += '\\'; }
+        escaped += character;
+    }
+
+    return escaped;
+}
+
+void write_json(std::ostream &stream, const BenchmarkSettings &settings,
+                const std::vector<BenchmarkResult> &results) {
+    stream << "{\n";
+    stream << "  \"gdal_version\": \"" << escape_json(GDALVersionInfo("RELEASE_NAME")) << "\",\n";
+    stream << "  \"iterations\": " << settings.iterations << ",\n";
+    stream << "  \"feature_count\": " << settings.feature_count << ",\n";
+    stream << "  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult &result = results[i];
+
+        stream << "    {\"benchmark\": \"" << escape_json(result.name) << "\", "
+               << "\"size\": " << result.size << ", "
+               << "\"threads\": " << result.threads << ", "
+               << "\"operations\": " << result.operations << ", "
+               << "\"total_seconds\": " << result.total_seconds << ", "
+               << "\"operations_per_second\": "
+               << (result.total_seconds > 0.0 ? result.operations / result.total_seconds : 0.0)
+               << ", "
+               << "\"mean_ms\": " << result.mean_milliseconds << ", "
+               << "\"min_ms\": " << result.min_milliseconds << ", "
+               << "\"max_ms\": " << result.max_milliseconds << "}"
+               << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    stream << "  ]\n";
+    stream << "}\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchmarkSettings settings = parse_arguments(argc, argv);
+
+    RasterTileExtractor::initialize();
+    VectorExtractor::initialize();
+
+    std::string raster_path = settings.working_directory + "/geodot-benchmark-heightmap.tif";
+    std::string vector_path = settings.working_directory + "/geodot-benchmark-points.gpkg";
+
+    // Start from fresh fixtures so that results are comparable between runs
+    VSIUnlink(raster_path.c_str());
+    VSIUnlink(vector_path.c_str());
+
+    if (!create_raster_fixture(raster_path) ||
+        !create_vector_fixture(vector_path, settings.feature_count)) {
+        std::cerr << "Could not create benchmark fixtures in " << settings.working_directory
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<BenchmarkResult> results;
+    double raster_extent = RASTER_SIZE_PIXELS * RASTER_PIXEL_SIZE;
+
+    for (int thread_count : settings.thread_counts) {
+        // Every thread uses its own dataset objects, as recommended for multithreaded GDAL access
+        std::vector<std::shared_ptr<NativeDataset>> rasters;
+        std::vector<std::shared_ptr<NativeDataset>> vectors;
+        std::vector<std::shared_ptr<NativeLayer>> layers;
+
+        for (int thread_index = 0; thread_index < thread_count; thread_index++) {
+            rasters.emplace_back(VectorExtractor::open_dataset(raster_path.c_str(), false));
+            vectors.emplace_back(VectorExtractor::open_dataset(vector_path.c_str(), true));
+            layers.emplace_back(vectors.back()->get_layer("points"));
+        }
+
+        for (int size : settings.sizes) {
+            results.emplace_back(run_benchmark(
+                "tile_extraction", size, thread_count, settings.iterations,
+                [&](int thread_index) {
+                    GDALDataset *dataset = rasters[thread_index]->dataset;
+
+                    return [dataset, size, raster_extent](std::mt19937 &generator) {
+                        std::uniform_real_distribution<double> offset(0.0, raster_extent - size);
+
+                        GeoRaster *raster = RasterTileExtractor::get_tile_from_dataset(
+                            dataset, RASTER_ORIGIN_X + offset(generator),
+                            RASTER_ORIGIN_Y - offset(generator), size, size, 1);
+
+                        delete[] static_cast<float *>(raster->get_as_array());
+                        delete raster;
+                    };
+                }));
+
+            results.emplace_back(run_benchmark(
+                "spatial_query", size, thread_count, settings.iterations,
+                [&](int thread_index) {
+                    std::shared_ptr<NativeLayer> layer = layers[thread_index];
+
+                    return [layer, size, raster_extent](std::mt19937 &generator) {
+                        std::uniform_real_distribution<double> offset(0.0, raster_extent - size);
+
+                        layer->get_features_in_square(RASTER_ORIGIN_X + offset(generator),
+                                                      RASTER_ORIGIN_Y - offset(generator), size,
+                                                      1000000);
+                    };
+                }));
+        }
+
+        results.emplace_back(run_benchmark(
+            "point_sampling", 1, thread_count, settings.iterations * 20,
+            [&](int thread_index) {
+                GDALDataset *dataset = rasters[thread_index]->dataset;
+
+                return [dataset, raster_extent](std::mt19937 &generator) {
+                    std::uniform_real_distribution<double> offset(0.0, raster_extent);
+
+                    // Equivalent to GeoRasterLayer::get_value_at_position
+                    GeoRaster *raster = RasterTileExtractor::get_tile_from_dataset(
+                        dataset, RASTER_ORIGIN_X + offset(generator),
+                        RASTER_ORIGIN_Y - offset(generator), 0.0001, 1, 1);
+
+                    delete[] static_cast<float *>(raster->get_as_array());
+                    delete raster;
+                };
+            }));
+
+        results.emplace_back(run_benchmark(
+            "feature_creation", 1, thread_count, settings.iterations * 20,
+            [&](int thread_index) {
+                std::shared_ptr<NativeLayer> layer = layers[thread_index];
+
+                return [layer, raster_extent](std::mt19937 &generator) {
+                    std::uniform_real_distribution<double> offset(0.0, raster_extent);
+
+                    std::shared_ptr<PointFeature> point =
+                        std::dynamic_pointer_cast<PointFeature>(layer->create_feature());
+                    point->set_vector(RASTER_ORIGIN_X + offset(generator),
+                                      RASTER_ORIGIN_Y - offset(generator), 0.0);
+                };
+            }));
+    }
+
+    if (settings.output_path.empty()) {
+        write_json(std::cout, settings, results);
+    } else {
+        std::ofstream output(settings.output_path);
+        write_json(output, settings, results);
+    }
+
+    VSIUnlink(raster_path.c_str());
+    VSIUnlink(vector_path.c_str());
+
+    return 0;
+}
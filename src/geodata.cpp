@@ -1,7 +1,13 @@
 #include "geodata.h"
 #include "NativeLayer.h"
+#include "Polygonizer.h"
+#include "RasterSampler.h"
 #include "RasterTileExtractor.h"
+#include "Visibility.h"
+#include "ZonalStatistics.h"
 #include "geofeatures.h"
+#include "performance-counters.h"
+#include "trace.h"
 #include "godot_cpp/core/error_macros.hpp"
 #include "godot_cpp/variant/dictionary.hpp"
 #include "godot_cpp/variant/variant.hpp"
@@ -199,13 +205,50 @@ void GeoFeatureLayer::_bind_methods() {
                          &GeoFeatureLayer::get_features_near_position);
     ClassDB::bind_method(D_METHOD("get_features_in_square", "top_left_x", "top_left_x", "size_meters"),
                          &GeoFeatureLayer::get_features_in_square);
+    ClassDB::bind_method(D_METHOD("get_all_feature_columns"),
+                         &GeoFeatureLayer::get_all_feature_columns);
+    ClassDB::bind_method(D_METHOD("get_feature_columns_near_position", "pos_x", "pos_y", "radius",
+                                  "max_features"),
+                         &GeoFeatureLayer::get_feature_columns_near_position);
+    ClassDB::bind_method(D_METHOD("get_feature_columns_in_square", "top_left_x", "top_left_y",
+                                  "size_meters", "max_features"),
+                         &GeoFeatureLayer::get_feature_columns_in_square);
+    ClassDB::bind_method(D_METHOD("get_feature_cursor"), &GeoFeatureLayer::get_feature_cursor);
+    ClassDB::bind_method(D_METHOD("get_feature_cursor_near_position", "pos_x", "pos_y", "radius",
+                                  "max_features"),
+                         &GeoFeatureLayer::get_feature_cursor_near_position);
+    ClassDB::bind_method(D_METHOD("get_feature_cursor_in_square", "top_left_x", "top_left_y",
+                                  "size_meters", "max_features"),
+                         &GeoFeatureLayer::get_feature_cursor_in_square);
+    ClassDB::bind_method(D_METHOD("get_feature_cursor_by_attribute_filter", "filter"),
+                         &GeoFeatureLayer::get_feature_cursor_by_attribute_filter);
     ClassDB::bind_method(D_METHOD("get_features_by_attribute_filter", "filter"), &GeoFeatureLayer::get_features_by_attribute_filter);
     ClassDB::bind_method(D_METHOD("has_attribute", "attribute_name"), &GeoFeatureLayer::has_attribute);
     ClassDB::bind_method(D_METHOD("get_attribute_names"), &GeoFeatureLayer::get_attribute_names);
+    ClassDB::bind_method(D_METHOD("get_attribute_index", "attribute_name"),
+                         &GeoFeatureLayer::get_attribute_index);
+    ClassDB::bind_method(D_METHOD("get_attribute_values", "attribute_name"),
+                         &GeoFeatureLayer::get_attribute_values);
+    ClassDB::bind_method(D_METHOD("set_attribute_cache_enabled", "enabled"),
+                         &GeoFeatureLayer::set_attribute_cache_enabled);
+    ClassDB::bind_method(D_METHOD("is_attribute_cache_enabled"),
+                         &GeoFeatureLayer::is_attribute_cache_enabled);
+    ClassDB::bind_method(D_METHOD("create_attribute_index", "attribute_name"),
+                         &GeoFeatureLayer::create_attribute_index);
+    ClassDB::bind_method(D_METHOD("has_attribute_index", "attribute_name"),
+                         &GeoFeatureLayer::has_attribute_index);
     ClassDB::bind_method(D_METHOD("create_feature"), &GeoFeatureLayer::create_feature);
     ClassDB::bind_method(D_METHOD("remove_feature", "feature"), &GeoFeatureLayer::remove_feature);
     ClassDB::bind_method(D_METHOD("clear_cache"), &GeoFeatureLayer::clear_cache);
+    ClassDB::bind_method(D_METHOD("set_max_cached_features", "max_features"),
+                         &GeoFeatureLayer::set_max_cached_features);
+    ClassDB::bind_method(D_METHOD("get_max_cached_features"),
+                         &GeoFeatureLayer::get_max_cached_features);
     ClassDB::bind_method(D_METHOD("save_override"), &GeoFeatureLayer::save_override);
+    ClassDB::bind_method(D_METHOD("save_override_in_background"),
+                         &GeoFeatureLayer::save_override_in_background);
+    ClassDB::bind_method(D_METHOD("is_saving"), &GeoFeatureLayer::is_saving);
+    ClassDB::bind_method(D_METHOD("get_save_progress"), &GeoFeatureLayer::get_save_progress);
     ClassDB::bind_method(D_METHOD("save_new", "file_path"), &GeoFeatureLayer::save_new);
 
     ADD_SIGNAL(MethodInfo("feature_added", PropertyInfo(Variant::OBJECT, "new_feature")));
@@ -266,11 +309,85 @@ bool GeoFeatureLayer::has_attribute(String attribute_name) {
     return layer->field_exists(attribute_name.utf8().get_data());
 }
 
+int GeoFeatureLayer::get_attribute_index(String attribute_name) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), -1, "Can't get attribute index in invalid GeoFeatureLayer!");
+#endif
+
+    return layer->get_field_index(attribute_name.utf8().get_data());
+}
+
+Dictionary GeoFeatureLayer::get_attribute_values(String attribute_name) {
+    Dictionary result;
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), result,
+                          "Can't get attribute values in invalid GeoFeatureLayer!");
+    ERR_FAIL_COND_V_EDMSG(!has_attribute(attribute_name), result,
+                          "GeoFeatureLayer has no attribute with the given name!");
+#endif
+
+    AttributeValues values = layer->get_attribute_values(attribute_name.utf8().get_data());
+
+    PackedInt64Array ids;
+    ids.resize(values.ids.size());
+    memcpy(ids.ptrw(), values.ids.data(), values.ids.size() * sizeof(int64_t));
+
+    result["ids"] = ids;
+    result["values"] = get_attribute_array(values.column);
+
+    return result;
+}
+
+void GeoFeatureLayer::set_attribute_cache_enabled(bool enabled) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't set attribute cache of invalid GeoFeatureLayer!");
+#endif
+
+    layer->set_attribute_cache_enabled(enabled);
+}
+
+bool GeoFeatureLayer::is_attribute_cache_enabled() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), false,
+                          "Can't get attribute cache of invalid GeoFeatureLayer!");
+#endif
+
+    return layer->is_attribute_cache_enabled();
+}
+
+void GeoFeatureLayer::create_attribute_index(String attribute_name) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), ,
+                          "Can't create attribute index in invalid GeoFeatureLayer!");
+    ERR_FAIL_COND_V_EDMSG(!has_attribute(attribute_name), ,
+                          "GeoFeatureLayer has no attribute with the given name!");
+#endif
+
+    layer->create_attribute_index(attribute_name.utf8().get_data());
+}
+
+bool GeoFeatureLayer::has_attribute_index(String attribute_name) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), false,
+                          "Can't get attribute index of invalid GeoFeatureLayer!");
+#endif
+
+    return layer->has_attribute_index(attribute_name.utf8().get_data());
+}
+
 
 // Utility function for converting a Processing Library Feature to the appropriate GeoFeature
 Ref<GeoFeature> GeoFeatureLayer::get_specialized_feature(std::shared_ptr<Feature> raw_feature) {
-    if (feature_cache.count(raw_feature)) {
-        return feature_cache[raw_feature];
+    auto cached = feature_cache.find(raw_feature.get());
+
+    if (cached != feature_cache.end()) {
+        // A GeoFeature which is still alive also keeps its Feature alive, so the Feature's address
+        // can't have been reused for another one
+        Ref<GeoFeature> cached_feature =
+            Object::cast_to<GeoFeature>(ObjectDB::get_instance(cached->second));
+
+        if (cached_feature.is_valid()) { return cached_feature; }
     }
 
     // Not cached -> instantiate and cache
@@ -316,11 +433,26 @@ Ref<GeoFeature> GeoFeatureLayer::get_specialized_feature(std::shared_ptr<Feature
         new_feature = feature;
     }
 
-    feature_cache[raw_feature] = new_feature;
+    feature_cache[raw_feature.get()] = new_feature->get_instance_id();
+
+    if (feature_cache.size() > feature_cache_prune_size) { prune_feature_cache(); }
 
     return new_feature;
 }
 
+void GeoFeatureLayer::prune_feature_cache() {
+    for (auto entry = feature_cache.begin(); entry != feature_cache.end();) {
+        if (ObjectDB::get_instance(entry->second) == nullptr) {
+            entry = feature_cache.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+
+    // Entries of living GeoFeatures remain, so only prune again once as many new ones were added
+    feature_cache_prune_size = std::max(feature_cache.size() * 2, MIN_FEATURE_CACHE_PRUNE_SIZE);
+}
+
 Ref<GeoFeature> GeoFeatureLayer::get_feature_by_id(int id) {
 #ifdef DEBUG_ENABLED
     ERR_FAIL_COND_V_EDMSG(!is_valid(), nullptr, "Can't get feature in invalid GeoFeatureLayer!");
@@ -386,6 +518,24 @@ void GeoFeatureLayer::clear_cache() {
 #endif
 
     layer->clear_feature_cache();
+    feature_cache.clear();
+    feature_cache_prune_size = MIN_FEATURE_CACHE_PRUNE_SIZE;
+}
+
+void GeoFeatureLayer::set_max_cached_features(int max_features) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't set the cache size of invalid GeoFeatureLayer!");
+#endif
+
+    layer->set_max_cached_features(max_features);
+}
+
+int GeoFeatureLayer::get_max_cached_features() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), 0, "Can't get the cache size of invalid GeoFeatureLayer!");
+#endif
+
+    return layer->get_max_cached_features();
 }
 
 void GeoFeatureLayer::save_override() {
@@ -399,6 +549,35 @@ void GeoFeatureLayer::save_override() {
     layer->save_override();
 }
 
+void GeoFeatureLayer::save_override_in_background() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't save invalid GeoFeatureLayer!");
+    ERR_FAIL_COND_V_EDMSG(!origin_dataset->is_valid(), ,
+                          "Can't save in GeoFeatureLayer with invalid origin dataset!");
+    ERR_FAIL_COND_MSG(!origin_dataset->write_access,
+        "Cannot override a layer whose dataset was not opened with write access!");
+#endif
+
+    layer->save_override_in_background();
+}
+
+bool GeoFeatureLayer::is_saving() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), false, "Can't get saving state of invalid GeoFeatureLayer!");
+#endif
+
+    return layer->is_saving();
+}
+
+float GeoFeatureLayer::get_save_progress() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), 1.0f,
+                          "Can't get save progress of invalid GeoFeatureLayer!");
+#endif
+
+    return layer->get_save_progress();
+}
+
 void GeoFeatureLayer::save_new(String file_path) {
 #ifdef DEBUG_ENABLED
     ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't save invalid GeoFeatureLayer!");
@@ -442,6 +621,171 @@ Array GeoFeatureLayer::get_features_in_square(double top_left_x, double top_left
     return features;
 }
 
+Dictionary GeoFeatureLayer::get_columns_dictionary(const FeatureColumns &columns) {
+    Dictionary result;
+
+    auto to_int64_array = [](const std::vector<int64_t> &values) {
+        PackedInt64Array array;
+        array.resize(values.size());
+        memcpy(array.ptrw(), values.data(), values.size() * sizeof(int64_t));
+        return array;
+    };
+
+    PackedFloat64Array coordinates;
+    coordinates.resize(columns.coordinates.size());
+    memcpy(coordinates.ptrw(), columns.coordinates.data(),
+           columns.coordinates.size() * sizeof(double));
+
+    PackedByteArray geometry_types;
+    geometry_types.resize(columns.geometry_types.size());
+
+    for (size_t i = 0; i < columns.geometry_types.size(); i++) {
+        geometry_types.set(i, columns.geometry_types[i]);
+    }
+
+    result["ids"] = to_int64_array(columns.ids);
+    result["geometry_types"] = geometry_types;
+    result["coordinates"] = coordinates;
+    result["ring_offsets"] = to_int64_array(columns.ring_offsets);
+    result["row_offsets"] = to_int64_array(columns.row_offsets);
+
+    Dictionary attributes;
+
+    for (const AttributeColumn &column : columns.attributes) {
+        attributes[String::utf8(column.name.c_str())] = get_attribute_array(column);
+    }
+
+    result["attributes"] = attributes;
+
+    return result;
+}
+
+Variant GeoFeatureLayer::get_attribute_array(const AttributeColumn &column) {
+    if (column.type == AttributeColumn::INTEGER) {
+        PackedInt32Array values;
+        values.resize(column.integers.size());
+
+        for (size_t i = 0; i < column.integers.size(); i++) {
+            values.set(i, static_cast<int32_t>(column.integers[i]));
+        }
+
+        return values;
+    } else if (column.type == AttributeColumn::INTEGER64) {
+        PackedInt64Array values;
+        values.resize(column.integers.size());
+        memcpy(values.ptrw(), column.integers.data(), column.integers.size() * sizeof(int64_t));
+
+        return values;
+    } else if (column.type == AttributeColumn::REAL) {
+        PackedFloat64Array values;
+        values.resize(column.reals.size());
+        memcpy(values.ptrw(), column.reals.data(), column.reals.size() * sizeof(double));
+
+        return values;
+    } else {
+        PackedStringArray values;
+        values.resize(column.strings.size());
+
+        for (size_t i = 0; i < column.strings.size(); i++) {
+            values.set(i, String::utf8(column.strings[i].c_str()));
+        }
+
+        return values;
+    }
+}
+
+Dictionary GeoFeatureLayer::get_all_feature_columns() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Dictionary(),
+                          "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    return get_columns_dictionary(layer->get_feature_columns());
+}
+
+Dictionary GeoFeatureLayer::get_feature_columns_near_position(double pos_x, double pos_y,
+                                                              double radius, int max_features) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Dictionary(),
+                          "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    return get_columns_dictionary(
+        layer->get_feature_columns_near_position(pos_x, pos_y, radius, max_features));
+}
+
+Dictionary GeoFeatureLayer::get_feature_columns_in_square(double top_left_x, double top_left_y,
+                                                          double size_meters, int max_features) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Dictionary(),
+                          "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    return get_columns_dictionary(
+        layer->get_feature_columns_in_square(top_left_x, top_left_y, size_meters, max_features));
+}
+
+Ref<GeoFeatureCursor> GeoFeatureLayer::get_feature_cursor() {
+    Ref<GeoFeatureCursor> cursor;
+    cursor.instantiate();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), cursor, "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    cursor->set_native_cursor(std::make_shared<FeatureCursor>(layer, nullptr, "", -1), this);
+
+    return cursor;
+}
+
+Ref<GeoFeatureCursor> GeoFeatureLayer::get_feature_cursor_near_position(double pos_x,
+                                                                        double pos_y,
+                                                                        double radius,
+                                                                        int max_features) {
+    Ref<GeoFeatureCursor> cursor;
+    cursor.instantiate();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), cursor, "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    cursor->set_native_cursor(
+        FeatureCursor::near_position(layer, pos_x, pos_y, radius, max_features), this);
+
+    return cursor;
+}
+
+Ref<GeoFeatureCursor> GeoFeatureLayer::get_feature_cursor_in_square(double top_left_x,
+                                                                    double top_left_y,
+                                                                    double size_meters,
+                                                                    int max_features) {
+    Ref<GeoFeatureCursor> cursor;
+    cursor.instantiate();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), cursor, "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    cursor->set_native_cursor(
+        FeatureCursor::in_square(layer, top_left_x, top_left_y, size_meters, max_features), this);
+
+    return cursor;
+}
+
+Ref<GeoFeatureCursor> GeoFeatureLayer::get_feature_cursor_by_attribute_filter(String filter) {
+    Ref<GeoFeatureCursor> cursor;
+    cursor.instantiate();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), cursor, "Can't get features in invalid GeoFeatureLayer!");
+#endif
+
+    cursor->set_native_cursor(
+        std::make_shared<FeatureCursor>(layer, nullptr, filter.utf8().get_data(), -1), this);
+
+    return cursor;
+}
+
 Array GeoFeatureLayer::get_features_by_attribute_filter(String filter) {
     Array features = Array();
 
@@ -464,10 +808,67 @@ void GeoFeatureLayer::set_native_layer(std::shared_ptr<NativeLayer> new_layer) {
     extent_data = layer->get_extent();
 }
 
+std::shared_ptr<NativeLayer> GeoFeatureLayer::get_native_layer() {
+    return layer;
+}
+
 void GeoFeatureLayer::set_origin_dataset(Ref<GeoDataset> dataset) {
     this->origin_dataset = dataset;
 }
 
+void GeoFeatureCursor::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_next_page"), &GeoFeatureCursor::get_next_page);
+    ClassDB::bind_method(D_METHOD("is_finished"), &GeoFeatureCursor::is_finished);
+    ClassDB::bind_method(D_METHOD("cancel"), &GeoFeatureCursor::cancel);
+    ClassDB::bind_method(D_METHOD("get_returned_count"), &GeoFeatureCursor::get_returned_count);
+    ClassDB::bind_method(D_METHOD("set_page_size", "page_size"), &GeoFeatureCursor::set_page_size);
+    ClassDB::bind_method(D_METHOD("get_page_size"), &GeoFeatureCursor::get_page_size);
+}
+
+Array GeoFeatureCursor::get_next_page() {
+    Array features = Array();
+
+    // An invalid layer results in an empty and finished cursor
+    if (cursor == nullptr) { return features; }
+
+    std::list<std::shared_ptr<Feature>> raw_features = cursor->get_next_page(page_size);
+
+    for (std::shared_ptr<Feature> raw_feature : raw_features) {
+        features.push_back(layer->get_specialized_feature(raw_feature));
+    }
+
+    return features;
+}
+
+bool GeoFeatureCursor::is_finished() {
+    return cursor == nullptr || cursor->is_finished();
+}
+
+void GeoFeatureCursor::cancel() {
+    if (cursor != nullptr) { cursor->cancel(); }
+}
+
+int GeoFeatureCursor::get_returned_count() {
+    return cursor != nullptr ? cursor->get_returned_count() : 0;
+}
+
+void GeoFeatureCursor::set_page_size(int new_page_size) {
+    // Rejected in release builds too, since get_next_page would never finish with such a size
+    ERR_FAIL_COND_V_MSG(new_page_size < 1, , "The page size must be at least 1!");
+
+    page_size = new_page_size;
+}
+
+int GeoFeatureCursor::get_page_size() {
+    return page_size;
+}
+
+void GeoFeatureCursor::set_native_cursor(std::shared_ptr<FeatureCursor> new_cursor,
+                                         Ref<GeoFeatureLayer> new_layer) {
+    cursor = new_cursor;
+    layer = new_layer;
+}
+
 void GeoRasterLayer::_bind_methods() {
     ClassDB::bind_method(D_METHOD("is_valid"), &GeoRasterLayer::is_valid);
     ClassDB::bind_method(D_METHOD("has_write_access"), &GeoRasterLayer::has_write_access);
@@ -483,6 +884,14 @@ void GeoRasterLayer::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_band_image", "top_left_x", "top_left_y", "size_meters",
                                   "img_size", "interpolation_type"),
                          &GeoRasterLayer::get_band_image);
+    ClassDB::bind_method(D_METHOD("get_rect_image", "top_left_x", "top_left_y", "size_meters_x",
+                                  "size_meters_y", "img_size_x", "img_size_y",
+                                  "interpolation_type"),
+                         &GeoRasterLayer::get_rect_image);
+    ClassDB::bind_method(D_METHOD("get_rect_band_image", "top_left_x", "top_left_y",
+                                  "size_meters_x", "size_meters_y", "img_size_x", "img_size_y",
+                                  "interpolation_type", "band_index"),
+                         &GeoRasterLayer::get_rect_band_image);
     ClassDB::bind_method(D_METHOD("get_value_at_position", "pos_x", "pos_y"),
                          &GeoRasterLayer::get_value_at_position);
     ClassDB::bind_method(D_METHOD("get_value_at_position_with_resolution"),
@@ -494,11 +903,46 @@ void GeoRasterLayer::_bind_methods() {
         &GeoRasterLayer::smooth_add_value_at_position);
     ClassDB::bind_method(D_METHOD("overlay_image_at_position", "pos_x", "pos_y", "image", "scale"),
                          &GeoRasterLayer::overlay_image_at_position);
+    ClassDB::bind_method(D_METHOD("begin_edit_operation"), &GeoRasterLayer::begin_edit_operation);
+    ClassDB::bind_method(D_METHOD("end_edit_operation"), &GeoRasterLayer::end_edit_operation);
+    ClassDB::bind_method(D_METHOD("undo_edit"), &GeoRasterLayer::undo_edit);
+    ClassDB::bind_method(D_METHOD("redo_edit"), &GeoRasterLayer::redo_edit);
+    ClassDB::bind_method(D_METHOD("get_undo_count"), &GeoRasterLayer::get_undo_count);
+    ClassDB::bind_method(D_METHOD("get_redo_count"), &GeoRasterLayer::get_redo_count);
+    ClassDB::bind_method(D_METHOD("squash_edit_history", "operation_count"),
+                         &GeoRasterLayer::squash_edit_history);
+    ClassDB::bind_method(D_METHOD("clear_edit_history"), &GeoRasterLayer::clear_edit_history);
+    ClassDB::bind_method(D_METHOD("get_edit_history_size"), &GeoRasterLayer::get_edit_history_size);
+    ClassDB::bind_method(D_METHOD("get_lines_of_sight", "observers", "targets", "correct_curvature"),
+                         &GeoRasterLayer::get_lines_of_sight);
+    ClassDB::bind_method(D_METHOD("get_viewshed", "observer_x", "observer_y", "observer_height",
+                                  "radius", "target_height", "img_size", "correct_curvature"),
+                         &GeoRasterLayer::get_viewshed);
+    ClassDB::bind_method(D_METHOD("get_contours", "top_left_x", "top_left_y", "size_meters",
+                                  "img_size", "interval", "base"),
+                         &GeoRasterLayer::get_contours);
+    ClassDB::bind_method(D_METHOD("get_contour_layer", "top_left_x", "top_left_y", "size_meters",
+                                  "img_size", "interval", "base"),
+                         &GeoRasterLayer::get_contour_layer);
+    ClassDB::bind_method(D_METHOD("polygonize", "top_left_x", "top_left_y", "size_meters",
+                                  "img_size", "simplify_tolerance"),
+                         &GeoRasterLayer::polygonize);
+    ClassDB::bind_method(D_METHOD("get_zonal_statistics", "polygons"),
+                         &GeoRasterLayer::get_zonal_statistics);
+    ClassDB::bind_method(D_METHOD("get_zonal_statistics_for_layer", "layer"),
+                         &GeoRasterLayer::get_zonal_statistics_for_layer);
+    ClassDB::bind_method(D_METHOD("drape_features", "features", "max_segment_length", "offset_x",
+                                  "offset_y", "offset_z"),
+                         &GeoRasterLayer::drape_features);
     ClassDB::bind_method(D_METHOD("get_extent"), &GeoRasterLayer::get_extent);
     ClassDB::bind_method(D_METHOD("get_center"), &GeoRasterLayer::get_center);
     ClassDB::bind_method(D_METHOD("get_min"), &GeoRasterLayer::get_min);
     ClassDB::bind_method(D_METHOD("get_max"), &GeoRasterLayer::get_max);
     ClassDB::bind_method(D_METHOD("get_pixel_size"), &GeoRasterLayer::get_pixel_size);
+    ClassDB::bind_method(D_METHOD("set_num_threads", "num_threads"),
+                         &GeoRasterLayer::set_num_threads);
+    ClassDB::bind_method(D_METHOD("get_num_threads"), &GeoRasterLayer::get_num_threads);
+    ClassDB::bind_method(D_METHOD("evict_cache"), &GeoRasterLayer::evict_cache);
     ClassDB::bind_method(D_METHOD("clone"), &GeoRasterLayer::clone);
     ClassDB::bind_method(D_METHOD("load_from_file", "file_path", "write_access"),
                          &GeoRasterLayer::load_from_file);
@@ -598,45 +1042,107 @@ return origin_dataset;
 
 Ref<GeoImage> GeoRasterLayer::get_image(double top_left_x, double top_left_y, double size_meters,
                                         int img_size, GeoImage::INTERPOLATION interpolation_type) {
+    return get_rect_image(top_left_x, top_left_y, size_meters, size_meters, img_size, img_size,
+                          interpolation_type);
+}
 
-    Ref<GeoImage> image;
-    image.instantiate();
+Ref<GeoImage> GeoRasterLayer::get_band_image(double top_left_x, double top_left_y, double size_meters,
+                                        int img_size, GeoImage::INTERPOLATION interpolation_type, int band_index) {
+    return get_rect_band_image(top_left_x, top_left_y, size_meters, size_meters, img_size,
+                               img_size, interpolation_type, band_index);
+}
+
+Ref<GeoImage> GeoRasterLayer::get_rect_image(double top_left_x, double top_left_y,
+                                             double size_meters_x, double size_meters_y,
+                                             int img_size_x, int img_size_y,
+                                             GeoImage::INTERPOLATION interpolation_type) {
+    ScopedPerformanceTimer timer(PerformanceCounters::GET_IMAGE);
+    ScopedTrace trace("GeoRasterLayer::get_rect_image");
 
 #ifdef DEBUG_ENABLED
-    ERR_FAIL_COND_V_EDMSG(!is_valid(), image, "Can't get image in invalid GeoRasterLayer!");
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Ref<GeoImage>(memnew(GeoImage)),
+                          "Can't get image in invalid GeoRasterLayer!");
 #endif
 
-    GeoRaster *raster = RasterTileExtractor::get_tile_from_dataset(
-        dataset->dataset, top_left_x, top_left_y, size_meters, img_size, interpolation_type);
-    
+    return get_coalesced_image(TileRequest{top_left_x, top_left_y, size_meters_x, size_meters_y,
+                                           img_size_x, img_size_y, interpolation_type, -1});
+}
+
+Ref<GeoImage> GeoRasterLayer::get_rect_band_image(double top_left_x, double top_left_y,
+                                                  double size_meters_x, double size_meters_y,
+                                                  int img_size_x, int img_size_y,
+                                                  GeoImage::INTERPOLATION interpolation_type,
+                                                  int band_index) {
+    ScopedPerformanceTimer timer(PerformanceCounters::GET_BAND_IMAGE);
+    ScopedTrace trace("GeoRasterLayer::get_rect_band_image");
+
 #ifdef DEBUG_ENABLED
-    // TODO: Set image to invalid
-    ERR_FAIL_COND_V_EDMSG((raster == nullptr), image, "get_image returned an invalid raster!");
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Ref<GeoImage>(memnew(GeoImage)),
+                          "Can't get band image in invalid GeoRasterLayer!");
 #endif
 
-    image->set_raster(raster, interpolation_type);
+    return get_coalesced_image(TileRequest{top_left_x, top_left_y, size_meters_x, size_meters_y,
+                                           img_size_x, img_size_y, interpolation_type,
+                                           band_index});
+}
+
+Ref<GeoImage> GeoRasterLayer::get_coalesced_image(const TileRequest &request) {
+    std::promise<Ref<GeoImage>> promise;
+
+    {
+        std::unique_lock<std::mutex> lock(in_flight_mutex);
+
+        auto in_flight = in_flight_requests.find(request);
+        if (in_flight != in_flight_requests.end()) {
+            // Someone else is already loading this exact tile - wait for their result
+            std::shared_future<Ref<GeoImage>> result = in_flight->second;
+            lock.unlock();
+
+            PerformanceCounters::add_coalesced_request();
+            ScopedTrace trace("GeoRasterLayer::wait_for_coalesced_request");
+
+            return result.get();
+        }
+
+        in_flight_requests.emplace(request, promise.get_future().share());
+    }
+
+    Ref<GeoImage> image = load_image(request);
+
+    {
+        std::lock_guard<std::mutex> lock(in_flight_mutex);
+        in_flight_requests.erase(request);
+    }
+
+    promise.set_value(image);
 
     return image;
 }
 
-Ref<GeoImage> GeoRasterLayer::get_band_image(double top_left_x, double top_left_y, double size_meters,
-                                        int img_size, GeoImage::INTERPOLATION interpolation_type, int band_index) {
+Ref<GeoImage> GeoRasterLayer::load_image(const TileRequest &request) {
     Ref<GeoImage> image;
     image.instantiate();
 
-#ifdef DEBUG_ENABLED
-    ERR_FAIL_COND_V_EDMSG(!is_valid(), 0, "Can't get band image in invalid GeoRasterLayer!");
-#endif
-
     GeoRaster *raster = RasterTileExtractor::get_tile_from_dataset(
-        dataset->dataset, top_left_x, top_left_y, size_meters, img_size, interpolation_type);
+        dataset->dataset, request.top_left_x, request.top_left_y, request.size_meters_x,
+        request.size_meters_y, request.img_size_x, request.img_size_y,
+        request.interpolation_type);
+
+    if (raster == nullptr) {
+        // TODO: Set image to invalid
+        ERR_PRINT_ED("get_image returned an invalid raster!");
+        return image;
+    }
+
+    GeoImage::INTERPOLATION interpolation_type =
+        static_cast<GeoImage::INTERPOLATION>(request.interpolation_type);
+
+    if (request.band_index < 0) {
+        image->set_raster(raster, interpolation_type);
+    } else {
+        image->set_raster_from_band(raster, interpolation_type, request.band_index);
+    }
 
-#ifdef DEBUG_ENABLED
-    // TODO: Set image to invalid
-    ERR_FAIL_COND_V_EDMSG((raster == nullptr), image, "get_band_image returned an invalid raster!");
-#endif
-    
-    image->set_raster_from_band(raster, interpolation_type, band_index);
     return image;
 }
 
@@ -655,6 +1161,9 @@ float GeoRasterLayer::get_value_at_position_with_resolution(double pos_x, double
     ERR_FAIL_COND_V_EDMSG(!is_valid(), 0.0, "Can't get value in invalid GeoRasterLayer!");
 #endif
 
+    ScopedPerformanceTimer timer(PerformanceCounters::GET_VALUE_AT_POSITION);
+    ScopedTrace trace("GeoRasterLayer::get_value_at_position");
+
     // TODO: Figure out what exactly we need to clamp to for precise values
     // pos_x -= std::fmod(pos_x, pixel_size_meters);
     // pos_y -= std::fmod(pos_y, pixel_size_meters);
@@ -682,6 +1191,9 @@ void GeoRasterLayer::set_value_at_position(double pos_x, double pos_y, Variant v
     ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't set value in invalid GeoRasterLayer!");
 #endif
 
+    begin_edit_operation();
+    if (edit_journal) { edit_journal->record_position(pos_x, pos_y); }
+
     // Validate against Raster type to see whether the passed Variant is sensible
     if (value.get_type() == Variant::Type::FLOAT && get_format() == Image::FORMAT_RF) {
         float godot_float = static_cast<float>(value);
@@ -717,6 +1229,8 @@ void GeoRasterLayer::set_value_at_position(double pos_x, double pos_y, Variant v
     }
 
     dataset->dataset->FlushCache();
+
+    end_edit_operation();
 }
 
 void GeoRasterLayer::smooth_add_value_at_position(double pos_x, double pos_y, double summand,
@@ -727,10 +1241,14 @@ void GeoRasterLayer::smooth_add_value_at_position(double pos_x, double pos_y, do
 
     // FIXME: Like overlay_image_at_position, this could be done much more efficiently by batch-reading and writing
 
-    float resolution = get_pixel_size();
+    // Pixels may not be square, so each axis steps by its own pixel size
+    float resolution_x = RasterTileExtractor::get_pixel_size(dataset->dataset);
+    float resolution_y = RasterTileExtractor::get_pixel_size_y(dataset->dataset);
+
+    begin_edit_operation();
 
-    for (float offset_x = -radius; offset_x <= radius; offset_x += resolution) {
-        for (float offset_y = -radius; offset_y <= radius; offset_y += resolution) {
+    for (float offset_x = -radius; offset_x <= radius; offset_x += resolution_x) {
+        for (float offset_y = -radius; offset_y <= radius; offset_y += resolution_y) {
             float distance_to_center = sqrt(offset_x * offset_x + offset_y * offset_y) / radius;
             float summand_factor = 1.0 - distance_to_center;
 
@@ -747,6 +1265,8 @@ void GeoRasterLayer::smooth_add_value_at_position(double pos_x, double pos_y, do
             set_value_at_position(pos_here_x, pos_here_y, new_value);
         }
     }
+
+    end_edit_operation();
 }
 
 void GeoRasterLayer::overlay_image_at_position(double pos_x, double pos_y, Ref<Image> image,
@@ -758,14 +1278,17 @@ void GeoRasterLayer::overlay_image_at_position(double pos_x, double pos_y, Ref<I
     // FIXME: Rough initial implementation, it works but it is very inefficient!
     // Rather than constantly calling set_value_at_position, we'll want to set the entire image data at once.
 
-    float resolution = get_pixel_size();
-    image->resize(ceil(scale / resolution), ceil(scale / resolution));
+    float resolution_x = RasterTileExtractor::get_pixel_size(dataset->dataset);
+    float resolution_y = RasterTileExtractor::get_pixel_size_y(dataset->dataset);
+    image->resize(ceil(scale / resolution_x), ceil(scale / resolution_y));
 
     PackedByteArray data = image->get_data();
 
     int image_width = image->get_width();
     int image_height = image->get_height();
 
+    begin_edit_operation();
+
     if (image->get_format() == Image::FORMAT_R8 && get_format() == Image::FORMAT_R8) {
         // Single-band byte
         for (int i = 0; i < data.size(); i++) {
@@ -815,6 +1338,418 @@ void GeoRasterLayer::overlay_image_at_position(double pos_x, double pos_y, Ref<I
     } else {
         std::cout << "Type mismatch: image of type " << image->get_format() << " and dataset of type " << get_format() << std::endl;
     }
+
+    end_edit_operation();
+}
+
+void GeoRasterLayer::begin_edit_operation() {
+    if (edit_journal) { edit_journal->begin_operation(); }
+}
+
+void GeoRasterLayer::end_edit_operation() {
+    if (edit_journal) { edit_journal->end_operation(); }
+}
+
+bool GeoRasterLayer::undo_edit() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!edit_journal, false, "Can't undo edits in GeoRasterLayer without write access!");
+#endif
+
+    return edit_journal->undo();
+}
+
+bool GeoRasterLayer::redo_edit() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!edit_journal, false, "Can't redo edits in GeoRasterLayer without write access!");
+#endif
+
+    return edit_journal->redo();
+}
+
+int GeoRasterLayer::get_undo_count() {
+    return edit_journal ? edit_journal->get_undo_count() : 0;
+}
+
+int GeoRasterLayer::get_redo_count() {
+    return edit_journal ? edit_journal->get_redo_count() : 0;
+}
+
+void GeoRasterLayer::squash_edit_history(int operation_count) {
+    if (edit_journal) { edit_journal->squash(operation_count); }
+}
+
+void GeoRasterLayer::clear_edit_history() {
+    if (edit_journal) { edit_journal->clear(); }
+}
+
+int64_t GeoRasterLayer::get_edit_history_size() {
+    return edit_journal ? edit_journal->get_memory_usage() : 0;
+}
+
+PackedByteArray GeoRasterLayer::get_lines_of_sight(PackedVector3Array observers,
+                                                   PackedVector3Array targets,
+                                                   bool correct_curvature) {
+    PackedByteArray result;
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), result, "Can't get lines of sight in invalid GeoRasterLayer!");
+#endif
+
+    // Checked in release builds too, since targets would otherwise be read out of bounds
+    ERR_FAIL_COND_V_MSG(observers.size() != targets.size(), result,
+                        "The number of observers and targets must be the same!");
+
+    std::vector<VisibilityPoint> native_observers;
+    std::vector<VisibilityPoint> native_targets;
+    native_observers.reserve(observers.size());
+    native_targets.reserve(targets.size());
+
+    // Translate from Godot's coordinate convention (y up, z south) to projected coordinates
+    for (int i = 0; i < observers.size(); i++) {
+        native_observers.push_back({observers[i].x, -observers[i].z, observers[i].y});
+        native_targets.push_back({targets[i].x, -targets[i].z, targets[i].y});
+    }
+
+    std::vector<uint8_t> visible = Visibility::get_lines_of_sight(
+        dataset->dataset, native_observers, native_targets, correct_curvature);
+
+    result.resize(visible.size());
+    memcpy(result.ptrw(), visible.data(), visible.size());
+
+    return result;
+}
+
+Ref<Image> GeoRasterLayer::get_viewshed(double observer_x, double observer_y,
+                                        double observer_height, double radius,
+                                        double target_height, int img_size,
+                                        bool correct_curvature) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Ref<Image>(), "Can't get viewshed in invalid GeoRasterLayer!");
+    ERR_FAIL_COND_V_EDMSG(img_size <= 0 || radius <= 0.0, Ref<Image>(),
+                          "The viewshed size and radius must be positive!");
+#endif
+
+    std::vector<uint8_t> visible =
+        Visibility::get_viewshed(dataset->dataset, {observer_x, observer_y, observer_height},
+                                 radius, target_height, img_size, correct_curvature);
+
+    PackedByteArray data;
+    data.resize(visible.size());
+    memcpy(data.ptrw(), visible.data(), visible.size());
+
+    return Image::create_from_data(img_size, img_size, false, Image::FORMAT_L8, data);
+}
+
+Dictionary GeoRasterLayer::get_contours(double top_left_x, double top_left_y, double size_meters,
+                                        int img_size, double interval, double base) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Dictionary(),
+                          "Can't get contours in invalid GeoRasterLayer!");
+#endif
+
+    // Bilinear interpolation would blend no-data pixels into their neighbours before they are
+    // masked, which results in false lines along the edges of no-data areas
+    Ref<GeoImage> heightmap = get_band_image(top_left_x, top_left_y, size_meters, img_size,
+                                             GeoImage::NEAREST, 1);
+
+    return heightmap->get_contours(interval, base);
+}
+
+Ref<GeoFeatureLayer> GeoRasterLayer::get_contour_layer(double top_left_x, double top_left_y,
+                                                       double size_meters, int img_size,
+                                                       double interval, double base) {
+    Ref<GeoFeatureLayer> feature_layer;
+    feature_layer.instantiate();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), feature_layer,
+                          "Can't get contours in invalid GeoRasterLayer!");
+#endif
+
+    // Not interpolated, like in get_contours
+    Ref<GeoImage> heightmap = get_band_image(top_left_x, top_left_y, size_meters, img_size,
+                                             GeoImage::NEAREST, 1);
+    std::vector<ContourLine> lines = heightmap->get_contour_lines(interval, base);
+
+    Ref<GeoDataset> contour_dataset;
+    contour_dataset.instantiate();
+    contour_dataset->name = name + ":contours";
+    contour_dataset->write_access = true;
+    contour_dataset->set_native_dataset(
+        VectorExtractor::create_memory_dataset(contour_dataset->name.utf8().get_data()));
+
+    std::shared_ptr<NativeLayer> contour_layer = contour_dataset->dataset->create_layer(
+        "contours", Feature::LINE, get_epsg_code(), {"level"});
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(contour_layer == nullptr, feature_layer,
+                          "Could not create an in-memory layer for the contours!");
+#endif
+
+    for (const ContourLine &line : lines) {
+        std::shared_ptr<LineFeature> feature =
+            std::dynamic_pointer_cast<LineFeature>(contour_layer->create_feature());
+
+        int point_count = line.points.size() / 2;
+        feature->set_point_count(point_count);
+
+        for (int point = 0; point < point_count; point++) {
+            feature->set_line_point(point, line.points[point * 2], line.points[point * 2 + 1],
+                                    line.level);
+        }
+
+        feature->set_attribute("level", String::num(line.level).utf8().get_data());
+    }
+
+    // Write the geometry of the new features into the layer so that spatial queries find them
+    contour_layer->write_feature_cache_to_ram_layer();
+
+    feature_layer->name = "contours";
+    feature_layer->set_native_layer(contour_layer);
+    feature_layer->set_origin_dataset(contour_dataset);
+
+    return feature_layer;
+}
+
+Ref<GeoFeatureLayer> GeoRasterLayer::polygonize(double top_left_x, double top_left_y,
+                                                double size_meters, int img_size,
+                                                double simplify_tolerance) {
+    Ref<GeoFeatureLayer> feature_layer;
+    feature_layer.instantiate();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), feature_layer, "Can't polygonize invalid GeoRasterLayer!");
+    ERR_FAIL_COND_V_EDMSG(img_size <= 0, feature_layer, "The image size must be positive!");
+#endif
+
+    std::vector<ClassPolygon> polygons = Polygonizer::polygonize(
+        dataset->dataset, top_left_x, top_left_y, size_meters, img_size, simplify_tolerance);
+
+    Ref<GeoDataset> polygon_dataset;
+    polygon_dataset.instantiate();
+    polygon_dataset->name = name + ":polygons";
+    polygon_dataset->write_access = true;
+    polygon_dataset->set_native_dataset(
+        VectorExtractor::create_memory_dataset(polygon_dataset->name.utf8().get_data()));
+
+    std::shared_ptr<NativeLayer> polygon_layer = polygon_dataset->dataset->create_layer(
+        "polygons", Feature::POLYGON, get_epsg_code(), {"value"});
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(polygon_layer == nullptr, feature_layer,
+                          "Could not create an in-memory layer for the polygons!");
+#endif
+
+    for (const ClassPolygon &polygon : polygons) {
+        std::shared_ptr<PolygonFeature> feature =
+            std::dynamic_pointer_cast<PolygonFeature>(polygon_layer->create_feature());
+
+        for (int ring = 0; ring < polygon.rings.size(); ring++) {
+            std::list<std::vector<double>> vertices;
+
+            for (int point = 0; point < polygon.rings[ring].size() / 2; point++) {
+                vertices.emplace_back(std::vector<double>{polygon.rings[ring][point * 2],
+                                                          polygon.rings[ring][point * 2 + 1]});
+            }
+
+            if (ring == 0) {
+                feature->set_outer_vertices(vertices);
+            } else {
+                feature->add_hole(vertices);
+            }
+        }
+
+        feature->set_attribute("value", String::num(polygon.value).utf8().get_data());
+    }
+
+    // Write the geometry of the new features into the layer so that spatial queries find them
+    polygon_layer->write_feature_cache_to_ram_layer();
+
+    feature_layer->name = "polygons";
+    feature_layer->set_native_layer(polygon_layer);
+    feature_layer->set_origin_dataset(polygon_dataset);
+
+    return feature_layer;
+}
+
+/// Computes the statistics of the given zones and returns them as the Array of Dictionaries
+/// described in GeoRasterLayer::get_zonal_statistics, with the given ID for each zone.
+static Array get_zonal_statistics_array(GDALDataset *dataset, const std::vector<Zone> &zones,
+                                        const std::vector<int64_t> &ids) {
+    Array result;
+
+    std::vector<ZoneStatistics> statistics = ZonalStatistics::compute(dataset, zones);
+
+    for (int i = 0; i < statistics.size(); i++) {
+        Dictionary zone_statistics;
+        zone_statistics["id"] = ids[i];
+        zone_statistics["count"] = statistics[i].count;
+        zone_statistics["min"] = statistics[i].min;
+        zone_statistics["max"] = statistics[i].max;
+        zone_statistics["sum"] = statistics[i].sum;
+        zone_statistics["mean"] = statistics[i].mean;
+        zone_statistics["majority"] = statistics[i].majority;
+
+        result.append(zone_statistics);
+    }
+
+    return result;
+}
+
+Array GeoRasterLayer::get_zonal_statistics(Array polygons) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Array(),
+                          "Can't get zonal statistics of invalid GeoRasterLayer!");
+#endif
+
+    std::vector<Zone> zones(polygons.size());
+    std::vector<int64_t> ids(polygons.size());
+
+    for (int i = 0; i < polygons.size(); i++) {
+        Ref<GeoPolygon> polygon = polygons[i];
+
+#ifdef DEBUG_ENABLED
+        ERR_FAIL_COND_V_EDMSG(polygon.is_null(), Array(),
+                              "Zonal statistics can only be computed for GeoPolygons!");
+#endif
+
+        // Use the native double coordinates rather than the real_t Vector2s of the GeoPolygon
+        std::shared_ptr<PolygonFeature> native_polygon =
+            std::dynamic_pointer_cast<PolygonFeature>(polygon->get_gdal_feature());
+
+        std::list<std::list<std::vector<double>>> rings = native_polygon->get_holes();
+        rings.push_front(native_polygon->get_outer_vertices());
+
+        for (const std::list<std::vector<double>> &vertices : rings) {
+            std::vector<double> &ring = zones[i].rings.emplace_back();
+
+            for (const std::vector<double> &vertex : vertices) {
+                ring.push_back(vertex[0]);
+                ring.push_back(vertex[1]);
+            }
+        }
+
+        ids[i] = polygon->get_id();
+    }
+
+    return get_zonal_statistics_array(dataset->dataset, zones, ids);
+}
+
+Array GeoRasterLayer::get_zonal_statistics_for_layer(Ref<GeoFeatureLayer> layer) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), Array(),
+                          "Can't get zonal statistics of invalid GeoRasterLayer!");
+    ERR_FAIL_COND_V_EDMSG(layer.is_null() || !layer->is_valid(), Array(),
+                          "Can't get zonal statistics for invalid GeoFeatureLayer!");
+#endif
+
+    // The columnar query avoids creating a GeoFeature for every feature of the layer
+    FeatureColumns columns = layer->get_native_layer()->get_feature_columns();
+
+    std::vector<Zone> zones;
+    std::vector<int64_t> ids;
+
+    for (size_t row = 0; row < columns.ids.size(); row++) {
+        if (columns.geometry_types[row] != Feature::POLYGON) { continue; }
+
+        Zone zone;
+
+        for (int64_t ring = columns.row_offsets[row]; ring < columns.row_offsets[row + 1]; ring++) {
+            std::vector<double> vertices;
+
+            for (int64_t vertex = columns.ring_offsets[ring];
+                 vertex < columns.ring_offsets[ring + 1]; vertex++) {
+                vertices.push_back(columns.coordinates[vertex * 3]);
+                vertices.push_back(columns.coordinates[vertex * 3 + 1]);
+            }
+
+            zone.rings.emplace_back(std::move(vertices));
+        }
+
+        zones.emplace_back(std::move(zone));
+        ids.push_back(columns.ids[row]);
+    }
+
+    return get_zonal_statistics_array(dataset->dataset, zones, ids);
+}
+
+Array GeoRasterLayer::drape_features(Array features, double max_segment_length, double offset_x,
+                                     double offset_y, double offset_z) {
+    Array result;
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), result, "Can't drape features on invalid GeoRasterLayer!");
+#endif
+
+    ScopedTrace trace("GeoRasterLayer::drape_features");
+
+    RasterSampler sampler(dataset->dataset);
+
+    // The native double coordinates are sampled and the offsets are only applied afterwards, so
+    // that no precision is lost by a round-trip through real_t vectors.
+    // Note: y and z are swapped because of differences in the coordinate system!
+    auto get_vertices = [&](const std::vector<double> &points) {
+        std::vector<double> draped = sampler.drape_line(points, max_segment_length);
+
+        PackedVector3Array draped_vertices;
+        draped_vertices.resize(draped.size() / 3);
+
+        for (int i = 0; i < draped_vertices.size(); i++) {
+            draped_vertices.set(i, Vector3(draped[i * 3] + offset_x, draped[i * 3 + 2] + offset_y,
+                                           -draped[i * 3 + 1] - offset_z));
+        }
+
+        return draped_vertices;
+    };
+
+    for (int i = 0; i < features.size(); i++) {
+        Ref<GeoFeature> feature = features[i];
+
+        if (feature.is_null()) {
+            result.append(Variant());
+            continue;
+        }
+
+        std::shared_ptr<Feature> native_feature = feature->get_gdal_feature();
+
+        if (auto point = std::dynamic_pointer_cast<PointFeature>(native_feature)) {
+            double height = sampler.sample(point->get_x(), point->get_y());
+
+            result.append(Vector3(point->get_x() + offset_x, height + offset_y,
+                                  -point->get_y() - offset_z));
+        } else if (auto line = std::dynamic_pointer_cast<LineFeature>(native_feature)) {
+            std::vector<double> points(line->get_point_count() * 2);
+
+            for (int point_index = 0; point_index < line->get_point_count(); point_index++) {
+                points[point_index * 2] = line->get_line_point_x(point_index);
+                points[point_index * 2 + 1] = line->get_line_point_y(point_index);
+            }
+
+            PackedVector3Array draped_vertices = get_vertices(points);
+
+            Ref<Curve3D> curve;
+            curve.instantiate();
+
+            for (int point_index = 0; point_index < draped_vertices.size(); point_index++) {
+                curve->add_point(draped_vertices[point_index]);
+            }
+
+            result.append(curve);
+        } else if (auto polygon = std::dynamic_pointer_cast<PolygonFeature>(native_feature)) {
+            std::vector<double> points;
+
+            for (const std::vector<double> &vertex : polygon->get_outer_vertices()) {
+                points.push_back(vertex[0]);
+                points.push_back(vertex[1]);
+            }
+
+            result.append(get_vertices(points));
+        } else {
+            result.append(Variant());
+        }
+    }
+
+    return result;
 }
 
 Rect2 GeoRasterLayer::get_extent() {
@@ -859,6 +1794,37 @@ float GeoRasterLayer::get_pixel_size() {
     return RasterTileExtractor::get_pixel_size(dataset->dataset);
 }
 
+void GeoRasterLayer::set_num_threads(int num_threads) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't set number of threads in invalid GeoRasterLayer!");
+    ERR_FAIL_COND_V_EDMSG(num_threads < 0, , "The number of threads must not be negative!");
+#endif
+
+    if (num_threads == dataset->num_threads) { return; }
+
+    // Make sure no pending changes are lost when the old dataset is closed
+    RasterTileExtractor::evict_dataset_cache(dataset->dataset);
+
+    set_native_dataset(
+        std::make_shared<NativeDataset>(dataset->path, dataset->write_access, num_threads));
+}
+
+int GeoRasterLayer::get_num_threads() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), 0, "Can't get number of threads in invalid GeoRasterLayer!");
+#endif
+
+    return dataset->num_threads;
+}
+
+void GeoRasterLayer::evict_cache() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!is_valid(), , "Can't evict cache of invalid GeoRasterLayer!");
+#endif
+
+    RasterTileExtractor::evict_dataset_cache(dataset->dataset);
+}
+
 void GeoRasterLayer::set_origin_dataset(Ref<GeoDataset> dataset) {
     this->origin_dataset = dataset;
 }
@@ -900,6 +1866,42 @@ void GeoRasterLayer::load_from_file(String file_path, bool write_access) {
 void GeoRasterLayer::set_native_dataset(std::shared_ptr<NativeDataset> new_dataset) {
     dataset = new_dataset;
     extent_data = RasterTileExtractor::get_extent_data(new_dataset->dataset);
+
+    // The history refers to the previous dataset object, so it starts over
+    if (new_dataset->write_access && new_dataset->is_valid()) {
+        edit_journal = std::make_unique<RasterEditJournal>(new_dataset->dataset);
+    } else {
+        edit_journal.reset();
+    }
+}
+
+std::shared_ptr<NativeDataset> GeoRasterLayer::get_native_dataset() {
+    return dataset;
+}
+
+void GeoRasterCache::_bind_methods() {
+    ClassDB::bind_static_method("GeoRasterCache", D_METHOD("set_max_size", "bytes"),
+                                &GeoRasterCache::set_max_size);
+    ClassDB::bind_static_method("GeoRasterCache", D_METHOD("get_max_size"),
+                                &GeoRasterCache::get_max_size);
+    ClassDB::bind_static_method("GeoRasterCache", D_METHOD("get_used_size"),
+                                &GeoRasterCache::get_used_size);
+}
+
+void GeoRasterCache::set_max_size(int64_t bytes) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(bytes < 0, , "The block cache size must not be negative!");
+#endif
+
+    RasterTileExtractor::set_block_cache_max(bytes);
+}
+
+int64_t GeoRasterCache::get_max_size() {
+    return RasterTileExtractor::get_block_cache_max();
+}
+
+int64_t GeoRasterCache::get_used_size() {
+    return RasterTileExtractor::get_block_cache_used();
 }
 
-} // namespace godot
\ No newline at end of file
+} // namespace godot
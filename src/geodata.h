@@ -1,6 +1,9 @@
 #ifndef __GEODATA_H__
 #define __GEODATA_H__
 
+#include "FeatureColumns.h"
+#include "FeatureCursor.h"
+#include "RasterEditJournal.h"
 #include "RasterTileExtractor.h"
 #include "VectorExtractor.h"
 #include "defines.h"
@@ -9,10 +12,17 @@
 #include "godot_cpp/variant/dictionary.hpp"
 #include "godot_cpp/variant/variant.hpp"
 
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 namespace godot {
 
 // Forward decaration
 class EXPORT GeoDataset;
+class EXPORT GeoFeatureCursor;
 
 /// A layer which contains any number of features.
 /// These features consist of attributes and usually (but not necessarily)
@@ -66,10 +76,32 @@ class EXPORT GeoFeatureLayer : public Resource {
     /// Note that this will cause newly returned features not to have shared signals and changes with previously returned features.
     void clear_cache();
 
+    /// Sets how many features are kept cached when they are no longer referenced, so that
+    /// querying the same area again is fast. Less recently used ones beyond that are freed.
+    /// Features which are still referenced or have unsaved changes are always kept, so the same
+    /// feature is always returned as the same object while it is in use. Negative values keep
+    /// all features, as long as the layer exists.
+    void set_max_cached_features(int max_features);
+
+    int get_max_cached_features();
+
     /// Applies all changes made to the layer to this layer, overriding the previous data
-    /// permanently.
+    /// permanently. Only features which were created or changed since the last save are written,
+    /// within one transaction if the format supports it (e.g. GeoPackage).
     void save_override();
 
+    /// Like `save_override`, but saves on a background thread so that e.g. autosaving doesn't
+    /// block. The layer can still be queried and edited meanwhile; changes made while saving are
+    /// saved the next time. Use `is_saving` and `get_save_progress` to follow the save.
+    void save_override_in_background();
+
+    /// Returns `true` while a save started with `save_override_in_background` is running.
+    bool is_saving();
+
+    /// Returns the fraction of features which the running save has written, from 0 to 1, or 1 if
+    /// no save is running.
+    float get_save_progress();
+
     /// Applies all changes made to the layer to a copy of the original layer which is created at
     /// the given path. Will be created as a Shapefile.
     void save_new(String file_path);
@@ -81,6 +113,45 @@ class EXPORT GeoFeatureLayer : public Resource {
     /// Returns all features which intersect with the square constructed by the given top-left and size.
     Array get_features_in_square(double top_left_x, double top_left_y, double size_meters,
                                int max_features);
+
+    /// Returns all features in a columnar layout, without creating a GeoFeature for each of them.
+    /// The result is a Dictionary with one row per feature (or per part of a multi-geometry):
+    /// `ids`: PackedInt64Array with the ID of each row.
+    /// `geometry_types`: PackedByteArray with the geometry type of each row: 0 for none, 1 for
+    /// points, 2 for lines, 3 for polygons.
+    /// `coordinates`: PackedFloat64Array with consecutive x, y, z triples in projected meters
+    /// (not in Godot's coordinate system, so that the full precision is kept).
+    /// `ring_offsets`: PackedInt64Array with the index of the first vertex of each ring, followed
+    /// by the vertex count. Points have one ring, polygons their outer ring followed by the holes.
+    /// `row_offsets`: PackedInt64Array with the index of the first ring of each row, followed by
+    /// the ring count.
+    /// `attributes`: Dictionary from attribute name to a PackedInt32Array, PackedInt64Array,
+    /// PackedFloat64Array or PackedStringArray with the value of each row, depending on the type.
+    /// Unsaved changes to features are included.
+    Dictionary get_all_feature_columns();
+
+    /// Like `get_features_near_position`, but in the layout of `get_all_feature_columns`.
+    Dictionary get_feature_columns_near_position(double pos_x, double pos_y, double radius,
+                                                 int max_features);
+
+    /// Like `get_features_in_square`, but in the layout of `get_all_feature_columns`.
+    Dictionary get_feature_columns_in_square(double top_left_x, double top_left_y,
+                                             double size_meters, int max_features);
+
+    /// Returns a cursor over all features, which returns them page by page instead of all at once.
+    Ref<GeoFeatureCursor> get_feature_cursor();
+
+    /// Returns a cursor over the features near the given position (within the given radius).
+    Ref<GeoFeatureCursor> get_feature_cursor_near_position(double pos_x, double pos_y,
+                                                           double radius, int max_features);
+
+    /// Returns a cursor over the features which intersect with the square constructed by the
+    /// given top-left and size.
+    Ref<GeoFeatureCursor> get_feature_cursor_in_square(double top_left_x, double top_left_y,
+                                                       double size_meters, int max_features);
+
+    /// Returns a cursor over the features which fulfill the given SQL-WHERE-like attribute filter.
+    Ref<GeoFeatureCursor> get_feature_cursor_by_attribute_filter(String filter);
     
     /// Returns an Array containing the names of all attributes in this layer and its features.
     Array get_attribute_names();
@@ -88,6 +159,37 @@ class EXPORT GeoFeatureLayer : public Resource {
     /// Returns `true` if there is an attribute with the given name in the layer and its features.
     bool has_attribute(String attribute_name);
 
+    /// Returns the index of the attribute with the given name for the typed getters of
+    /// GeoFeature, such as GeoFeature.get_attribute_as_int_at, or -1 if there is none.
+    /// The index stays valid until attributes are added or removed.
+    int get_attribute_index(String attribute_name);
+
+    /// Returns the values of the attribute with the given name for all features which are not
+    /// deleted, including unsaved changes, without creating a GeoFeature for each of them.
+    /// The result is a Dictionary with `ids`, a PackedInt64Array with the ID of each feature (once
+    /// for multi-geometries), and `values`, a PackedInt32Array, PackedInt64Array,
+    /// PackedFloat64Array or PackedStringArray with the value of each feature (0 or an empty
+    /// string if it is not set), like the attributes in `get_all_feature_columns`.
+    Dictionary get_attribute_values(String attribute_name);
+
+    /// If enabled, the values read by `get_attribute_values` are kept, so that repeated calls
+    /// (e.g. for styling) don't read all features again. Changes to features are still included.
+    /// Disabled by default, since the values of all features are kept in memory.
+    void set_attribute_cache_enabled(bool enabled);
+
+    bool is_attribute_cache_enabled();
+
+    /// Starts building an index of the given attribute in the background. Once it is ready,
+    /// `get_features_by_attribute_filter` answers filters such as "osm_id = 42",
+    /// "type IN ('road', 'path')" or "height BETWEEN 10 AND 20" from the index instead of
+    /// evaluating them for every feature. Other filters are still evaluated by GDAL.
+    /// Only integer, real and string attributes of layers which can read features by ID can be
+    /// indexed. The index is rebuilt in the background after `save_override`.
+    void create_attribute_index(String attribute_name);
+
+    /// Returns `true` if the index of the given attribute is ready to be used.
+    bool has_attribute_index(String attribute_name);
+
     /// Returns all features which fulfill the given SQL-WHERE-like attribute filter, e.g. "attributename < 1000"
     /// Note that syntax errors are printed to the console by GDAL.
     Array get_features_by_attribute_filter(String filter);
@@ -100,6 +202,10 @@ class EXPORT GeoFeatureLayer : public Resource {
     /// is only for internal use.
     void set_native_layer(std::shared_ptr<NativeLayer> new_layer);
 
+    /// Returns the underlying NativeLayer for native processing of its features.
+    /// Not exposed to Godot since Godot doesn't know about the VectorExtractor's types.
+    std::shared_ptr<NativeLayer> get_native_layer();
+
     /// Sets the dataset which this layer was opened from.
     /// Not exposed to Godot since it should never construct GeoFeatureLayers by hand.
     void set_origin_dataset(Ref<GeoDataset> dataset);
@@ -107,12 +213,71 @@ class EXPORT GeoFeatureLayer : public Resource {
     String name;
 
   private:
+    /// Converts the native columns to the Dictionary returned by the feature column queries
+    static Dictionary get_columns_dictionary(const FeatureColumns &columns);
+
+    /// Converts the values of the column to the corresponding packed array
+    static Variant get_attribute_array(const AttributeColumn &column);
+
+    /// Removes the entries of GeoFeatures which have been freed from the feature_cache
+    void prune_feature_cache();
+
+    /// The minimum number of entries in the feature_cache before it is pruned
+    static constexpr size_t MIN_FEATURE_CACHE_PRUNE_SIZE = 1024;
+
     std::shared_ptr<NativeLayer> layer;
-    std::map<std::shared_ptr<Feature>, Ref<GeoFeature>> feature_cache;
+
+    /// The instance IDs of the GeoFeatures which have been returned, so that the same Feature is
+    /// always returned as the same GeoFeature while it is in use. Only the IDs are kept, so that
+    /// unused GeoFeatures (and with them their Features) can be freed.
+    std::map<const Feature *, uint64_t> feature_cache;
+    size_t feature_cache_prune_size = MIN_FEATURE_CACHE_PRUNE_SIZE;
     Ref<GeoDataset> origin_dataset;
     ExtentData extent_data;
 };
 
+/// Iterates over the features of a GeoFeatureLayer page by page, so that large layers can be
+/// processed without loading all of their features at once, e.g. one page per frame. Other
+/// queries on the layer are possible in between pages.
+class EXPORT GeoFeatureCursor : public RefCounted {
+    GDCLASS(GeoFeatureCursor, RefCounted)
+
+  protected:
+    static void _bind_methods();
+
+  public:
+    GeoFeatureCursor() = default;
+    ~GeoFeatureCursor() = default;
+
+    /// Returns the next page of features, continuing where the previous page ended.
+    /// The returned features are the same objects as in all other queries of the layer.
+    Array get_next_page();
+
+    /// Returns true once all features have been returned or the cursor was cancelled.
+    bool is_finished();
+
+    /// Stops the cursor, e.g. when the results are not needed anymore. Following pages are empty.
+    void cancel();
+
+    /// Returns the number of features which have been returned so far.
+    int get_returned_count();
+
+    /// Sets the number of features per page. Defaults to 1000. Sizes below 1 are rejected.
+    void set_page_size(int new_page_size);
+
+    int get_page_size();
+
+    /// Sets the native cursor and the layer whose features it returns.
+    /// Not exposed to Godot since cursors are created by GeoFeatureLayers.
+    void set_native_cursor(std::shared_ptr<FeatureCursor> new_cursor,
+                           Ref<GeoFeatureLayer> new_layer);
+
+  private:
+    std::shared_ptr<FeatureCursor> cursor;
+    Ref<GeoFeatureLayer> layer;
+    int page_size = 1000;
+};
+
 /// A layer which contains raster data.
 /// Corresponds to a Raster GDALDataset or Subdataset.
 /// Its `name` property is either the layer name, or the full path if it wasn't opened from a
@@ -165,6 +330,8 @@ class EXPORT GeoRasterLayer : public Resource {
     /// Returns a GeoImage corresponding to the given position and size.
     /// The requested section is read from this GeoRasterLayer into that GeoImage, so this
     /// operation is costly for large images. (Consider multithreading.)
+    /// If the same image is requested from several threads at once, it is only loaded once and all
+    /// callers receive the same GeoImage, which should therefore not be modified.
     Ref<GeoImage> get_image(double top_left_x, double top_left_y, double size_meters, int img_size,
                             GeoImage::INTERPOLATION interpolation_type);
 
@@ -173,6 +340,18 @@ class EXPORT GeoRasterLayer : public Resource {
     Ref<GeoImage> get_band_image(double top_left_x, double top_left_y, double size_meters, int img_size,
                             GeoImage::INTERPOLATION interpolation_type, int band_index);
 
+    /// Like get_image, but for a rectangular area of size_meters_x * size_meters_y which is
+    /// resampled to an image of img_size_x * img_size_y pixels. Useful for strip-shaped areas such
+    /// as road or river corridors, where a square would read many unneeded pixels.
+    Ref<GeoImage> get_rect_image(double top_left_x, double top_left_y, double size_meters_x,
+                                 double size_meters_y, int img_size_x, int img_size_y,
+                                 GeoImage::INTERPOLATION interpolation_type);
+
+    /// Like get_rect_image but only returns the GeoImage of a single Band.
+    Ref<GeoImage> get_rect_band_image(double top_left_x, double top_left_y, double size_meters_x,
+                                      double size_meters_y, int img_size_x, int img_size_y,
+                                      GeoImage::INTERPOLATION interpolation_type, int band_index);
+
     /// Returns the value in the GeoRasterLayer at exactly the given position.
     /// Note that when reading many values from a confined area, it is more efficient to call
     /// get_image and read the pixels from there.
@@ -203,6 +382,110 @@ class EXPORT GeoRasterLayer : public Resource {
     /// Useful for drawing into datasets with custom brushes, e.g. a pre-defined land-use pattern.
     void overlay_image_at_position(double pos_x, double pos_y, Ref<Image> image, double scale);
 
+    /// Groups all following edits (set_value_at_position, smooth_add_value_at_position and
+    /// overlay_image_at_position) into one operation which is undone and redone as a whole, until
+    /// end_edit_operation is called. Each edit call is an operation of its own otherwise.
+    /// Edits are only recorded for layers with write access.
+    void begin_edit_operation();
+
+    /// Ends an operation started with begin_edit_operation.
+    void end_edit_operation();
+
+    /// Restores the data to its state before the latest edit operation.
+    /// Returns false if there is nothing to undo.
+    bool undo_edit();
+
+    /// Re-applies the latest undone edit operation. Returns false if there is nothing to redo.
+    bool redo_edit();
+
+    /// Returns the number of edit operations which can be undone.
+    int get_undo_count();
+
+    /// Returns the number of edit operations which can be redone.
+    int get_redo_count();
+
+    /// Merges the latest operation_count edit operations into one, e.g. all strokes of a finished
+    /// brushing session. 0 merges the entire history.
+    void squash_edit_history(int operation_count);
+
+    /// Discards the undo and redo history, e.g. after the edits have been accepted.
+    void clear_edit_history();
+
+    /// Returns the memory used by the undo and redo history in bytes.
+    int64_t get_edit_history_size();
+
+    /// Checks whether each target can be seen from the observer with the same index, with this
+    /// layer as the terrain. Points use the same convention as GeoPoint.get_vector3, i.e.
+    /// Vector3(easting, height, -northing) in projected meters, except that the height is relative
+    /// to the terrain below the point (e.g. the eye level of an observer).
+    /// Returns 1 for each visible and 0 for each hidden target.
+    /// All lines of sight are checked at once on multiple threads, so batching many checks into one
+    /// call is much faster than calling this for each pair.
+    PackedByteArray get_lines_of_sight(PackedVector3Array observers, PackedVector3Array targets,
+                                       bool correct_curvature);
+
+    /// Returns a FORMAT_L8 image of img_size * img_size pixels centered on the observer and
+    /// covering 2 * radius meters, which is white where a target at target_height above the
+    /// terrain would be visible from the observer at observer_height above the terrain.
+    Ref<Image> get_viewshed(double observer_x, double observer_y, double observer_height,
+                            double radius, double target_height, int img_size,
+                            bool correct_curvature);
+
+    /// Returns contour lines at every multiple of interval (offset by base) within the given
+    /// square, traced in a heightmap of img_size * img_size pixels read from the first band.
+    /// The heightmap is read with nearest-neighbour sampling, so that no-data pixels aren't
+    /// blended into their neighbours.
+    /// The result is formatted like GeoImage.get_contours, ready for drawing the lines.
+    Dictionary get_contours(double top_left_x, double top_left_y, double size_meters,
+                            int img_size, double interval, double base);
+
+    /// Like get_contours, but returns the lines as LineFeatures (with a `level` attribute) in a
+    /// new GeoFeatureLayer which only exists in memory. Its lines can be queried and saved like
+    /// those of any other layer.
+    Ref<GeoFeatureLayer> get_contour_layer(double top_left_x, double top_left_y,
+                                           double size_meters, int img_size, double interval,
+                                           double base);
+
+    /// Converts the classes (e.g. land-use values) of the first band within the given square, read
+    /// at img_size * img_size pixels, into PolygonFeatures with a `value` attribute in a new
+    /// GeoFeatureLayer which only exists in memory. No-data pixels are left out.
+    /// If simplify_tolerance (in meters) is larger than 0, the polygons are simplified to have
+    /// fewer vertices; small gaps between neighbouring polygons are possible then.
+    Ref<GeoFeatureLayer> polygonize(double top_left_x, double top_left_y, double size_meters,
+                                    int img_size, double simplify_tolerance);
+
+    /// Returns statistics of the values of the first band within each of the given GeoPolygons, as
+    /// an Array with one Dictionary per polygon (in the same order) containing
+    /// `id`: the ID of the polygon feature,
+    /// `count`: the number of pixels (excluding no-data) whose centers are inside the polygon,
+    /// `min`, `max`, `sum` and `mean`: statistics of the values of those pixels,
+    /// `majority`: the most common value; only computed for integer bands such as land-use
+    /// classifications, 0 otherwise.
+    /// Polygons are processed in spatially close batches sharing one read of the data, on
+    /// multiple threads, so passing all polygons in one call is much faster than calling this for
+    /// each polygon. Polygons spanning more than 2048 pixels are read at a lower resolution.
+    Array get_zonal_statistics(Array polygons);
+
+    /// Like get_zonal_statistics, for all polygons in the given layer (the parts of
+    /// multi-polygons are separate zones with their part IDs).
+    Array get_zonal_statistics_for_layer(Ref<GeoFeatureLayer> layer);
+
+    /// Places the given features (e.g. the result of a query on a GeoFeatureLayer) on the terrain
+    /// described by this layer, with heights interpolated bilinearly from the first band.
+    /// Returns an Array with, for each feature in the same order,
+    /// a Vector3 for GeoPoints (like GeoPoint.get_float_offset_vector3),
+    /// a Curve3D for GeoLines (like GeoLine.get_float_offset_curve3d),
+    /// a PackedVector3Array with the outer vertices for GeoPolygons,
+    /// and null for other features.
+    /// If max_segment_length is larger than 0, points are inserted into longer segments of lines
+    /// and polygon outlines, so that they follow the terrain in between the original vertices.
+    /// The data is read once per block for all features, so draping all features of an area in
+    /// one call is much faster than calling get_value_at_position for each vertex.
+    /// No-data pixels are left out of the interpolation; vertices with only no-data pixels around
+    /// them get a NaN height (plus offset_y), which callers should check for with is_nan.
+    Array drape_features(Array features, double max_segment_length, double offset_x,
+                         double offset_y, double offset_z);
+
     /// Returns the extent of the layer in projected meters (assuming it is rectangular).
     Rect2 get_extent();
 
@@ -221,6 +504,18 @@ class EXPORT GeoRasterLayer : public Resource {
     /// Returns the length of a side of a pixel in the dataset, in meters.
     float get_pixel_size();
 
+    /// Reopens the dataset with the given number of threads for decoding blocks (GDAL_NUM_THREADS),
+    /// e.g. for large compressed GeoTIFFs. 0 uses GDAL's global setting. Only drivers which support
+    /// multi-threaded reading (such as GTiff) make use of this.
+    /// Must not be called while other threads read from this layer. Clears the edit history.
+    void set_num_threads(int num_threads);
+
+    int get_num_threads();
+
+    /// Writes pending changes of this layer to disk and evicts its blocks from GDAL's block cache.
+    /// Useful when streaming moves away from the area covered by this layer.
+    void evict_cache();
+
     /// Load a raster dataset file such as a GeoTIFF into this object.
     void load_from_file(String file_path, bool write_access);
 
@@ -229,6 +524,10 @@ class EXPORT GeoRasterLayer : public Resource {
     /// GDALDatasets - this is only for internal use.
     void set_native_dataset(std::shared_ptr<NativeDataset> new_dataset);
 
+    /// Returns the underlying NativeDataset, e.g. for sampling heights natively.
+    /// Not exposed to Godot since Godot doesn't know about the RasterTileExtractor's types.
+    std::shared_ptr<NativeDataset> get_native_dataset();
+
     /// Sets the dataset which this layer was opened from.
     /// Not exposed to Godot since it should never construct GeoFeatureLayers by hand.
     void set_origin_dataset(Ref<GeoDataset> dataset);
@@ -238,9 +537,44 @@ class EXPORT GeoRasterLayer : public Resource {
     String name;
 
   private:
+    /// Identifies a tile request, so that identical requests which arrive while the first one is
+    /// still being loaded can share its result. band_index is -1 for requests of all bands.
+    struct TileRequest {
+        double top_left_x;
+        double top_left_y;
+        double size_meters_x;
+        double size_meters_y;
+        int img_size_x;
+        int img_size_y;
+        int interpolation_type;
+        int band_index;
+
+        bool operator<(const TileRequest &other) const {
+            return std::tie(top_left_x, top_left_y, size_meters_x, size_meters_y, img_size_x,
+                            img_size_y, interpolation_type, band_index) <
+                   std::tie(other.top_left_x, other.top_left_y, other.size_meters_x,
+                            other.size_meters_y, other.img_size_x, other.img_size_y,
+                            other.interpolation_type, other.band_index);
+        }
+    };
+
+    /// Returns the GeoImage for the given request. If an identical request is already being
+    /// loaded by another thread, waits for it and returns the same GeoImage instead of decoding
+    /// the data again.
+    Ref<GeoImage> get_coalesced_image(const TileRequest &request);
+
+    /// Reads the data for the given request from the dataset into a new GeoImage.
+    Ref<GeoImage> load_image(const TileRequest &request);
+
     Ref<GeoDataset> origin_dataset;
     std::shared_ptr<NativeDataset> dataset;
     ExtentData extent_data;
+
+    /// Records edits for undo and redo; only exists for layers with write access
+    std::unique_ptr<RasterEditJournal> edit_journal;
+
+    std::mutex in_flight_mutex;
+    std::map<TileRequest, std::shared_future<Ref<GeoImage>>> in_flight_requests;
 };
 
 /// A dataset which contains layers of geodata.
@@ -301,6 +635,26 @@ class EXPORT GeoDataset : public Resource {
     String name;
 };
 
+/// Controls GDAL's global raster block cache, through which all raster reads go.
+/// Its size defaults to GDAL_CACHEMAX (5% of RAM unless configured otherwise).
+class EXPORT GeoRasterCache : public Object {
+    GDCLASS(GeoRasterCache, Object)
+
+  protected:
+    static void _bind_methods();
+
+  public:
+    /// Sets the maximum size of the block cache in bytes. Blocks exceeding the new size are
+    /// evicted immediately.
+    static void set_max_size(int64_t bytes);
+
+    /// Returns the maximum size of the block cache in bytes.
+    static int64_t get_max_size();
+
+    /// Returns the number of bytes which are currently cached.
+    static int64_t get_used_size();
+};
+
 } // namespace godot
 
 #endif // __GEODATA_H__
@@ -7,6 +7,22 @@ using namespace godot;
 void GeoFeature::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_attribute", "name"), &GeoFeature::get_attribute);
     ClassDB::bind_method(D_METHOD("get_binary_attribute", "name"), &GeoFeature::get_binary_attribute);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_int", "name"),
+                         &GeoFeature::get_attribute_as_int);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_float", "name"),
+                         &GeoFeature::get_attribute_as_float);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_bool", "name"),
+                         &GeoFeature::get_attribute_as_bool);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_datetime", "name"),
+                         &GeoFeature::get_attribute_as_datetime);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_int_at", "index"),
+                         &GeoFeature::get_attribute_as_int_at);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_float_at", "index"),
+                         &GeoFeature::get_attribute_as_float_at);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_bool_at", "index"),
+                         &GeoFeature::get_attribute_as_bool_at);
+    ClassDB::bind_method(D_METHOD("get_attribute_as_datetime_at", "index"),
+                         &GeoFeature::get_attribute_as_datetime_at);
     ClassDB::bind_method(D_METHOD("set_attribute", "name", "value"), &GeoFeature::set_attribute);
     ClassDB::bind_method(D_METHOD("set_binary_attribute", "name", "value"), &GeoFeature::set_binary_attribute);
     ClassDB::bind_method(D_METHOD("get_attributes"), &GeoFeature::get_attributes);
@@ -30,6 +46,50 @@ PackedByteArray GeoFeature::get_binary_attribute(String name) const {
     return ret;
 }
 
+int64_t GeoFeature::get_attribute_as_int(String name) const {
+    return get_attribute_as_int_at(gdal_feature->get_field_index(name.utf8().get_data()));
+}
+
+double GeoFeature::get_attribute_as_float(String name) const {
+    return get_attribute_as_float_at(gdal_feature->get_field_index(name.utf8().get_data()));
+}
+
+bool GeoFeature::get_attribute_as_bool(String name) const {
+    return get_attribute_as_bool_at(gdal_feature->get_field_index(name.utf8().get_data()));
+}
+
+Dictionary GeoFeature::get_attribute_as_datetime(String name) const {
+    return get_attribute_as_datetime_at(gdal_feature->get_field_index(name.utf8().get_data()));
+}
+
+int64_t GeoFeature::get_attribute_as_int_at(int index) const {
+    return gdal_feature->get_attribute_as_integer(index);
+}
+
+double GeoFeature::get_attribute_as_float_at(int index) const {
+    return gdal_feature->get_attribute_as_real(index);
+}
+
+bool GeoFeature::get_attribute_as_bool_at(int index) const {
+    return gdal_feature->get_attribute_as_bool(index);
+}
+
+Dictionary GeoFeature::get_attribute_as_datetime_at(int index) const {
+    Dictionary datetime;
+    AttributeDateTime value;
+
+    if (gdal_feature->get_attribute_as_date_time(index, value)) {
+        datetime["year"] = value.year;
+        datetime["month"] = value.month;
+        datetime["day"] = value.day;
+        datetime["hour"] = value.hour;
+        datetime["minute"] = value.minute;
+        datetime["second"] = static_cast<int>(value.second);
+    }
+
+    return datetime;
+}
+
 void GeoFeature::set_attribute(String name, String value) {
     gdal_feature->set_attribute(name.utf8().get_data(), value.utf8().get_data());
     emit_signal("feature_changed");
@@ -63,6 +123,10 @@ void GeoFeature::set_gdal_feature(std::shared_ptr<Feature> gdal_feature) {
     this->gdal_feature = gdal_feature;
 }
 
+std::shared_ptr<Feature> GeoFeature::get_gdal_feature() {
+    return gdal_feature;
+}
+
 void GeoFeature::set_deleted(bool is_deleted) {
     this->gdal_feature->is_deleted = is_deleted;
 }
@@ -290,5 +354,14 @@ Array GeoPolygon::get_offset_holes(int offset_x, int offset_y) {
 }
 
 void GeoPolygon::add_hole(PackedVector2Array hole) {
-    // TODO: Implement
+    std::list<std::vector<double>> hole_vertices;
+
+    for (int i = 0; i < hole.size(); i++) {
+        hole_vertices.emplace_back(std::vector<double>{hole[i].x, hole[i].y});
+    }
+
+    std::shared_ptr<PolygonFeature> polygon = std::dynamic_pointer_cast<PolygonFeature>(gdal_feature);
+    polygon->add_hole(hole_vertices);
+
+    emit_signal("feature_changed");
 }
@@ -30,6 +30,26 @@ class EXPORT GeoFeature : public Resource {
     ///Gets a binary data attribute as a PackedByteArray
     PackedByteArray get_binary_attribute(String name) const;
 
+    /// Typed getters, which read the value without converting it to a String and back.
+    /// Unset attributes result in 0 or false.
+    int64_t get_attribute_as_int(String name) const;
+    double get_attribute_as_float(String name) const;
+
+    /// Numbers other than 0 and the strings "true", "yes" and "1" (in any case) are true.
+    bool get_attribute_as_bool(String name) const;
+
+    /// Returns a Dictionary with the year, month, day, hour, minute and second, like
+    /// Time.get_datetime_dict_from_unix_time, or an empty Dictionary if the attribute is not set
+    /// or not a date.
+    Dictionary get_attribute_as_datetime(String name) const;
+
+    /// Like the typed getters above, but with an index from GeoFeatureLayer.get_attribute_index,
+    /// so that the name doesn't need to be looked up again for each feature.
+    int64_t get_attribute_as_int_at(int index) const;
+    double get_attribute_as_float_at(int index) const;
+    bool get_attribute_as_bool_at(int index) const;
+    Dictionary get_attribute_as_datetime_at(int index) const;
+
     void set_attribute(String name, String value);
 
     ///Sets a binary data attribute to the PackedByteArray provided
@@ -41,6 +61,10 @@ class EXPORT GeoFeature : public Resource {
 
     void set_gdal_feature(std::shared_ptr<Feature> gdal_feature);
 
+    /// Returns the underlying feature for native processing.
+    /// Not exposed to Godot since Godot doesn't know about the VectorExtractor's types.
+    std::shared_ptr<Feature> get_gdal_feature();
+
     void set_deleted(bool is_deleted);
 
     bool intersects_with(Ref<GeoFeature> other);
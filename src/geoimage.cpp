@@ -1,5 +1,6 @@
 #include "geoimage.h"
 #include "GeoRaster.h"
+#include "TerrainAnalysis.h"
 
 #include <algorithm>
 
@@ -9,6 +10,7 @@ using namespace godot;
 
 GeoImage::GeoImage() {
     normalmap_load_mutex.instantiate();
+    raycaster_load_mutex.instantiate();
 }
 
 GeoImage::~GeoImage() {
@@ -25,6 +27,14 @@ void GeoImage::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_normalmap_texture_for_heightmap", "scale"),
                          &GeoImage::get_normalmap_texture_for_heightmap);
     ClassDB::bind_method(D_METHOD("get_shape_for_heightmap"), &GeoImage::get_shape_for_heightmap);
+    ClassDB::bind_method(D_METHOD("get_slope", "z_factor"), &GeoImage::get_slope);
+    ClassDB::bind_method(D_METHOD("get_aspect"), &GeoImage::get_aspect);
+    ClassDB::bind_method(D_METHOD("get_hillshade", "z_factor", "azimuth", "altitude"),
+                         &GeoImage::get_hillshade);
+    ClassDB::bind_method(D_METHOD("get_curvature"), &GeoImage::get_curvature);
+    ClassDB::bind_method(D_METHOD("raycast", "origins", "directions", "max_distance"),
+                         &GeoImage::raycast);
+    ClassDB::bind_method(D_METHOD("get_contours", "interval", "base"), &GeoImage::get_contours);
     ClassDB::bind_method(D_METHOD("is_valid"), &GeoImage::is_valid);
 
     BIND_ENUM_CONSTANT(AVG);
@@ -48,6 +58,10 @@ bool GeoImage::is_valid() {
 void GeoImage::set_raster(GeoRaster *raster, INTERPOLATION interpolation) {
     this->raster = raster;
     this->interpolation = interpolation;
+    this->pixel_size_x = raster->get_pixel_size_meters_x();
+    this->pixel_size_y = raster->get_pixel_size_meters_y();
+    this->top_left_x = raster->get_top_left_x();
+    this->top_left_y = raster->get_top_left_y();
 
     int size = raster->get_size_in_bytes();
 
@@ -63,6 +77,10 @@ void GeoImage::set_raster(GeoRaster *raster, INTERPOLATION interpolation) {
     GeoRaster::FORMAT format = raster->get_format();
     Image::Format image_format;
 
+    if ((format == GeoRaster::RF || format == GeoRaster::BYTE) && raster->has_no_data_value(1)) {
+        no_data_value = raster->get_no_data_value(1);
+    }
+
     if (format == GeoRaster::RF) {
         image_format = Image::FORMAT_RF;
     } else if (format == GeoRaster::BYTE) {
@@ -94,6 +112,10 @@ void GeoImage::set_raster(GeoRaster *raster, INTERPOLATION interpolation) {
 void GeoImage::set_raster_from_band(GeoRaster *raster, INTERPOLATION interpolation, int band_index) {
     this->raster = raster;
     this->interpolation = interpolation;
+    this->pixel_size_x = raster->get_pixel_size_meters_x();
+    this->pixel_size_y = raster->get_pixel_size_meters_y();
+    this->top_left_x = raster->get_top_left_x();
+    this->top_left_y = raster->get_top_left_y();
     int size = raster->get_pixel_size_x() * raster->get_pixel_size_y();
     GeoRaster::FORMAT band_format = raster->get_band_format(band_index);
     if (band_format == GeoRaster::RF) {
@@ -123,6 +145,10 @@ void GeoImage::set_raster_from_band(GeoRaster *raster, INTERPOLATION interpolati
         return;
     }
 
+    if (raster->has_no_data_value(band_index)) {
+        no_data_value = raster->get_no_data_value(band_index);
+    }
+
     uint8_t *data = (uint8_t *)raster->get_as_array();
     if (data == nullptr) return;
 
@@ -139,6 +165,25 @@ void GeoImage::set_raster_from_band(GeoRaster *raster, INTERPOLATION interpolati
 
 }
 
+std::vector<float> GeoImage::get_heights() {
+    PackedByteArray data = image->get_data();
+    std::vector<float> heights;
+
+    if (image->get_format() == Image::FORMAT_RF) {
+        const float *values = reinterpret_cast<const float *>(data.ptr());
+        heights.assign(values, values + data.size() / 4);
+    } else {
+        heights.assign(data.ptr(), data.ptr() + data.size());
+    }
+
+    // NaN is not equal to anything, so nothing is replaced if there is no no-data value
+    for (float &value : heights) {
+        if (value == no_data_value) { value = NAN; }
+    }
+
+    return heights;
+}
+
 Ref<Image> GeoImage::get_image() {
     return image;
 }
@@ -260,6 +305,191 @@ Ref<ImageTexture> GeoImage::get_image_texture() {
     return ImageTexture::create_from_image(image);
 }
 
+Ref<Image> GeoImage::get_slope(float z_factor) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!validity || image->get_format() != Image::FORMAT_RF, Ref<Image>(),
+                          "The slope can only be computed for valid Float heightmaps!");
+#endif
+
+    int width = image->get_width();
+    int height = image->get_height();
+    std::vector<float> heights = get_heights();
+
+    PackedByteArray slope;
+    slope.resize(width * height * 4);
+
+    TerrainAnalysis::compute_slope(heights.data(), width, height, pixel_size_x, pixel_size_y,
+                                   z_factor, reinterpret_cast<float *>(slope.ptrw()));
+
+    return Image::create_from_data(width, height, false, Image::FORMAT_RF, slope);
+}
+
+Ref<Image> GeoImage::get_aspect() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!validity || image->get_format() != Image::FORMAT_RF, Ref<Image>(),
+                          "The aspect can only be computed for valid Float heightmaps!");
+#endif
+
+    int width = image->get_width();
+    int height = image->get_height();
+    std::vector<float> heights = get_heights();
+
+    PackedByteArray aspect;
+    aspect.resize(width * height * 4);
+
+    TerrainAnalysis::compute_aspect(heights.data(), width, height, pixel_size_x, pixel_size_y,
+                                    reinterpret_cast<float *>(aspect.ptrw()));
+
+    return Image::create_from_data(width, height, false, Image::FORMAT_RF, aspect);
+}
+
+Ref<Image> GeoImage::get_hillshade(float z_factor, float azimuth, float altitude) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!validity || image->get_format() != Image::FORMAT_RF, Ref<Image>(),
+                          "The hillshade can only be computed for valid Float heightmaps!");
+#endif
+
+    int width = image->get_width();
+    int height = image->get_height();
+    std::vector<float> heights = get_heights();
+
+    PackedByteArray hillshade;
+    hillshade.resize(width * height);
+
+    TerrainAnalysis::compute_hillshade(heights.data(), width, height, pixel_size_x, pixel_size_y,
+                                       z_factor, azimuth, altitude, hillshade.ptrw());
+
+    return Image::create_from_data(width, height, false, Image::FORMAT_L8, hillshade);
+}
+
+Ref<Image> GeoImage::get_curvature() {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!validity || image->get_format() != Image::FORMAT_RF, Ref<Image>(),
+                          "The curvature can only be computed for valid Float heightmaps!");
+#endif
+
+    int width = image->get_width();
+    int height = image->get_height();
+    std::vector<float> heights = get_heights();
+
+    PackedByteArray curvature;
+    curvature.resize(width * height * 4);
+
+    TerrainAnalysis::compute_curvature(heights.data(), width, height, pixel_size_x, pixel_size_y,
+                                       reinterpret_cast<float *>(curvature.ptrw()));
+
+    return Image::create_from_data(width, height, false, Image::FORMAT_RF, curvature);
+}
+
+Dictionary GeoImage::raycast(PackedVector3Array origins, PackedVector3Array directions,
+                             float max_distance) {
+    Dictionary result;
+
+    // Checked in release builds too, since the data would otherwise be read out of bounds
+    ERR_FAIL_COND_V_MSG(!validity || image->get_format() != Image::FORMAT_RF, result,
+                        "Raycasts are only possible against valid Float heightmaps!");
+    ERR_FAIL_COND_V_MSG(origins.size() != directions.size(), result,
+                        "The number of ray origins and directions must be the same!");
+
+    raycaster_load_mutex->lock();
+
+    if (!raycaster) {
+        PackedByteArray heights = image->get_data();
+
+        raycaster = std::make_unique<HeightfieldRaycaster>(
+            reinterpret_cast<const float *>(heights.ptr()), image->get_width(),
+            image->get_height(), top_left_x, top_left_y, pixel_size_x, pixel_size_y);
+    }
+
+    raycaster_load_mutex->unlock();
+
+    // Translate from Godot's coordinate convention (y up, z south) to projected coordinates
+    std::vector<HeightfieldRay> rays;
+    rays.reserve(origins.size());
+
+    for (int i = 0; i < origins.size(); i++) {
+        rays.push_back({origins[i].x, -origins[i].z, origins[i].y, directions[i].x,
+                        -directions[i].z, directions[i].y});
+    }
+
+    std::vector<HeightfieldHit> hits = raycaster->cast_all(rays, max_distance);
+
+    PackedByteArray is_hit;
+    PackedVector3Array positions;
+    PackedVector3Array normals;
+    is_hit.resize(hits.size());
+    positions.resize(hits.size());
+    normals.resize(hits.size());
+
+    for (int i = 0; i < hits.size(); i++) {
+        const HeightfieldHit &hit = hits[i];
+
+        is_hit.set(i, hit.is_hit);
+
+        if (hit.is_hit) {
+            positions.set(i, Vector3(hit.x, hit.z, -hit.y));
+            normals.set(i, Vector3(hit.normal_x, hit.normal_z, -hit.normal_y));
+        }
+    }
+
+    result["hits"] = is_hit;
+    result["positions"] = positions;
+    result["normals"] = normals;
+
+    return result;
+}
+
+std::vector<ContourLine> GeoImage::get_contour_lines(double interval, double base) {
+    Image::Format format = image->get_format();
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!validity || (format != Image::FORMAT_RF && format != Image::FORMAT_R8 &&
+                                        format != Image::FORMAT_L8),
+                          std::vector<ContourLine>(),
+                          "Contours can only be traced in valid single-band heightmaps!");
+    ERR_FAIL_COND_V_EDMSG(interval <= 0.0, std::vector<ContourLine>(),
+                          "The contour interval must be positive!");
+#endif
+
+    int width = image->get_width();
+    int height = image->get_height();
+
+    // No-data pixels would otherwise stretch the levels and be surrounded by contours
+    std::vector<float> heights = get_heights();
+
+    return Contours::trace(heights.data(), width, height, top_left_x, top_left_y, pixel_size_x,
+                           pixel_size_y, interval, base);
+}
+
+Dictionary GeoImage::get_contours(double interval, double base) {
+    std::vector<ContourLine> contour_lines = get_contour_lines(interval, base);
+
+    PackedFloat32Array levels;
+    Array lines;
+    levels.resize(contour_lines.size());
+
+    for (int i = 0; i < contour_lines.size(); i++) {
+        const ContourLine &contour_line = contour_lines[i];
+
+        PackedVector3Array points;
+        points.resize(contour_line.points.size() / 2);
+
+        for (int point = 0; point < points.size(); point++) {
+            points.set(point, Vector3(contour_line.points[point * 2], contour_line.level,
+                                      -contour_line.points[point * 2 + 1]));
+        }
+
+        levels.set(i, contour_line.level);
+        lines.append(points);
+    }
+
+    Dictionary result;
+    result["levels"] = levels;
+    result["lines"] = lines;
+
+    return result;
+}
+
 Array GeoImage::get_most_common(int number_of_entries) {
     int *most_common = raster->get_most_common(number_of_entries);
     Array ret_array = Array();
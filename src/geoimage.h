@@ -9,9 +9,15 @@
 
 #include <godot_cpp/core/binder_common.hpp>
 
+#include "Contours.h"
 #include "GeoRaster.h"
+#include "HeightfieldRaycaster.h"
 #include "defines.h"
 
+#include <cmath>
+#include <memory>
+#include <vector>
+
 namespace godot {
 
 // Wrapper for a GeoRaster from the RasterTileExtractor.
@@ -77,11 +83,59 @@ class EXPORT GeoImage : public RefCounted {
     /// ImageTexture with the image.
     Ref<ImageTexture> get_normalmap_texture_for_heightmap(float scale);
 
+    /// Assuming the image is a heightmap, returns a FORMAT_RF image with the slope at each pixel in
+    /// degrees, from 0 (flat) to 90 (vertical). Heights are multiplied by z_factor first.
+    /// Like the other terrain products, pixels next to no-data pixels are NaN (0 for the
+    /// hillshade).
+    Ref<Image> get_slope(float z_factor);
+
+    /// Assuming the image is a heightmap, returns a FORMAT_RF image with the direction which the
+    /// slope at each pixel faces, in degrees clockwise from north. Flat pixels are -1.
+    Ref<Image> get_aspect();
+
+    /// Assuming the image is a heightmap, returns a FORMAT_L8 shaded relief image for a light
+    /// source at the given azimuth (degrees clockwise from north, usually 315) and altitude
+    /// (degrees above the horizon, usually 45). Heights are multiplied by z_factor first.
+    Ref<Image> get_hillshade(float z_factor, float azimuth, float altitude);
+
+    /// Assuming the image is a heightmap, returns a FORMAT_RF image with the curvature at each
+    /// pixel in 1/100 meters: positive on convex areas such as ridges, negative in valleys.
+    Ref<Image> get_curvature();
+
+    /// Assuming the image is a heightmap, intersects each ray (given by the origin and direction
+    /// with the same index) with the terrain surface, without using the physics engine.
+    /// Positions use the same convention as GeoPoint.get_vector3: x is the projected easting, y the
+    /// height and z the negative projected northing. Only hits within max_distance meters of the
+    /// origins are reported. Returns a Dictionary with
+    /// `hits`: a PackedByteArray with 1 for each ray which hit the terrain and 0 otherwise,
+    /// `positions`: a PackedVector3Array with the hit positions,
+    /// `normals`: a PackedVector3Array with the terrain normals at the hit positions.
+    /// The first call builds an acceleration structure for this GeoImage, so rays should be cast
+    /// against GeoImages which are kept around, such as the ones of the currently loaded tiles.
+    Dictionary raycast(PackedVector3Array origins, PackedVector3Array directions,
+                       float max_distance);
+
+    /// Assuming the image is a heightmap, returns contour lines at every multiple of interval
+    /// (offset by base) as a Dictionary with
+    /// `levels`: a PackedFloat32Array with the height of each line,
+    /// `lines`: an Array with a PackedVector3Array of points for each line, using the same
+    /// convention as GeoPoint.get_vector3 (the height of the points is the line's level).
+    /// Closed lines end with their first point, so all lines can be drawn as line strips.
+    /// Lines end at no-data pixels.
+    Dictionary get_contours(double interval, double base);
+
+    /// Like get_contours, but returns the lines as they come from the RasterTileExtractor.
+    /// Not exposed to Godot; used by GeoRasterLayer for creating feature layers.
+    std::vector<ContourLine> get_contour_lines(double interval, double base);
+
     /// Get the number_of_entries most common values in the raster.
     /// Only functional for single-band BYTE data!
     Array get_most_common(int number_of_entries);
 
   private:
+    /// Returns the heights of a single-band heightmap as floats, with NaN for no-data pixels
+    std::vector<float> get_heights();
+
     GeoRaster *raster;
 
     Ref<Image> image;
@@ -90,9 +144,25 @@ class EXPORT GeoImage : public RefCounted {
 
     Ref<Mutex> normalmap_load_mutex;
 
+    std::unique_ptr<HeightfieldRaycaster> raycaster;
+
+    Ref<Mutex> raycaster_load_mutex;
+
     INTERPOLATION interpolation;
 
     bool validity = false;
+
+    /// Size of a pixel in meters, used for terrain products
+    double pixel_size_x = 1.0;
+    double pixel_size_y = 1.0;
+
+    /// Projected position of the top left corner
+    double top_left_x = 0.0;
+    double top_left_y = 0.0;
+
+    /// The value of pixels without data, see GeoRaster::get_no_data_value, or NaN if the band
+    /// defines none
+    float no_data_value = NAN;
 };
 
 } // namespace godot
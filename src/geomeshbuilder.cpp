@@ -0,0 +1,498 @@
+#include "geomeshbuilder.h"
+#include "NativeLayer.h"
+#include "RasterSampler.h"
+#include "trace.h"
+
+#include <godot_cpp/classes/mesh.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+using namespace godot;
+
+void GeoMeshBuilder::_bind_methods() {
+    ClassDB::bind_static_method("GeoMeshBuilder",
+                                D_METHOD("build_polygon_mesh", "polygons", "offset_x", "offset_y",
+                                         "offset_z"),
+                                &GeoMeshBuilder::build_polygon_mesh);
+    ClassDB::bind_static_method("GeoMeshBuilder",
+                                D_METHOD("build_polygon_mesh_in_square", "layer", "top_left_x",
+                                         "top_left_y", "size_meters", "max_features", "offset_x",
+                                         "offset_y", "offset_z"),
+                                &GeoMeshBuilder::build_polygon_mesh_in_square);
+    ClassDB::bind_static_method("GeoMeshBuilder",
+                                D_METHOD("build_ribbon_mesh", "lines", "width_attribute",
+                                         "default_width", "height_layer", "max_segment_length",
+                                         "extend_ends", "offset_x", "offset_y", "offset_z"),
+                                &GeoMeshBuilder::build_ribbon_mesh);
+    ClassDB::bind_static_method(
+        "GeoMeshBuilder",
+        D_METHOD("build_ribbon_mesh_in_square", "layer", "top_left_x", "top_left_y", "size_meters",
+                 "max_features", "width_attribute", "default_width", "height_layer",
+                 "max_segment_length", "extend_ends", "offset_x", "offset_y", "offset_z"),
+        &GeoMeshBuilder::build_ribbon_mesh_in_square);
+    ClassDB::bind_static_method(
+        "GeoMeshBuilder",
+        D_METHOD("build_building_meshes_in_square", "layer", "top_left_x", "top_left_y",
+                 "size_meters", "max_features", "chunks_per_side", "height_attribute",
+                 "default_height", "base_layer", "offset_x", "offset_y", "offset_z"),
+        &GeoMeshBuilder::build_building_meshes_in_square);
+}
+
+Array GeoMeshBuilder::build_polygon_mesh(Array polygons, double offset_x, double offset_y,
+                                         double offset_z) {
+    ScopedTrace trace("GeoMeshBuilder::build_polygon_mesh");
+
+    std::vector<PolygonRings> rings;
+    rings.reserve(polygons.size());
+
+    for (int i = 0; i < polygons.size(); i++) {
+        Ref<GeoPolygon> polygon = polygons[i];
+        if (!polygon.is_valid()) { continue; }
+
+        std::shared_ptr<PolygonFeature> native_polygon =
+            std::dynamic_pointer_cast<PolygonFeature>(polygon->get_gdal_feature());
+        if (native_polygon == nullptr) { continue; }
+
+        PolygonRings &polygon_rings = rings.emplace_back();
+
+        // Read the native vertices rather than the Vector2s to keep the full precision
+        std::vector<double> &outer = polygon_rings.emplace_back();
+        for (const std::vector<double> &vertex : native_polygon->get_outer_vertices()) {
+            outer.push_back(vertex[0]);
+            outer.push_back(vertex[1]);
+        }
+
+        for (const std::list<std::vector<double>> &hole : native_polygon->get_holes()) {
+            std::vector<double> &hole_points = polygon_rings.emplace_back();
+
+            for (const std::vector<double> &vertex : hole) {
+                hole_points.push_back(vertex[0]);
+                hole_points.push_back(vertex[1]);
+            }
+        }
+    }
+
+    return get_mesh_arrays(PolygonTriangulator::triangulate_all(rings), offset_x, offset_y,
+                           offset_z);
+}
+
+Array GeoMeshBuilder::build_polygon_mesh_in_square(Ref<GeoFeatureLayer> layer, double top_left_x,
+                                                   double top_left_y, double size_meters,
+                                                   int max_features, double offset_x,
+                                                   double offset_y, double offset_z) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!layer.is_valid() || !layer->is_valid(), Array(),
+                          "Can't build a mesh from an invalid GeoFeatureLayer!");
+#endif
+
+    ScopedTrace trace("GeoMeshBuilder::build_polygon_mesh_in_square");
+
+    FeatureColumns columns = layer->get_native_layer()->get_feature_columns_in_square(
+        top_left_x, top_left_y, size_meters, max_features);
+
+    std::vector<PolygonRings> rings;
+
+    for (size_t row = 0; row < columns.ids.size(); row++) {
+        if (columns.geometry_types[row] != Feature::POLYGON) { continue; }
+
+        PolygonRings &polygon_rings = rings.emplace_back();
+
+        for (int64_t ring = columns.row_offsets[row]; ring < columns.row_offsets[row + 1];
+             ring++) {
+            std::vector<double> &points = polygon_rings.emplace_back();
+
+            for (int64_t vertex = columns.ring_offsets[ring];
+                 vertex < columns.ring_offsets[ring + 1]; vertex++) {
+                points.push_back(columns.coordinates[vertex * 3]);
+                points.push_back(columns.coordinates[vertex * 3 + 1]);
+            }
+        }
+    }
+
+    return get_mesh_arrays(PolygonTriangulator::triangulate_all(rings), offset_x, offset_y,
+                           offset_z);
+}
+
+Array GeoMeshBuilder::build_ribbon_mesh(Array lines, String width_attribute, double default_width,
+                                        Ref<GeoRasterLayer> height_layer,
+                                        double max_segment_length, bool extend_ends,
+                                        double offset_x, double offset_y, double offset_z) {
+    ScopedTrace trace("GeoMeshBuilder::build_ribbon_mesh");
+
+    std::string width_name = width_attribute.utf8().get_data();
+
+    std::vector<RibbonLine> ribbon_lines;
+    ribbon_lines.reserve(lines.size());
+
+    // The index of the width field is only looked up again when the lines come from a layer with
+    // a different definition
+    const OGRFeatureDefn *width_definition = nullptr;
+    int width_index = -1;
+
+    for (int i = 0; i < lines.size(); i++) {
+        Ref<GeoLine> line = lines[i];
+        if (!line.is_valid()) { continue; }
+
+        std::shared_ptr<LineFeature> native_line =
+            std::dynamic_pointer_cast<LineFeature>(line->get_gdal_feature());
+        if (native_line == nullptr) { continue; }
+
+        RibbonLine &ribbon_line = ribbon_lines.emplace_back();
+        ribbon_line.width = default_width;
+
+        if (!width_name.empty()) {
+            if (native_line->feature->GetDefnRef() != width_definition) {
+                width_definition = native_line->feature->GetDefnRef();
+                width_index = native_line->get_field_index(width_name.c_str());
+            }
+
+            double width = native_line->get_attribute_as_real(width_index);
+            if (width > 0.0) { ribbon_line.width = width; }
+        }
+
+        int point_count = native_line->get_point_count();
+        ribbon_line.points.reserve(point_count * 3);
+
+        for (int point = 0; point < point_count; point++) {
+            ribbon_line.points.push_back(native_line->get_line_point_x(point));
+            ribbon_line.points.push_back(native_line->get_line_point_y(point));
+            ribbon_line.points.push_back(native_line->get_line_point_z(point));
+        }
+    }
+
+    if (height_layer.is_valid()) { drape_lines(ribbon_lines, height_layer, max_segment_length); }
+
+    return get_mesh_arrays(RibbonBuilder::build(ribbon_lines, extend_ends), offset_x, offset_y,
+                           offset_z);
+}
+
+Array GeoMeshBuilder::build_ribbon_mesh_in_square(Ref<GeoFeatureLayer> layer, double top_left_x,
+                                                  double top_left_y, double size_meters,
+                                                  int max_features, String width_attribute,
+                                                  double default_width,
+                                                  Ref<GeoRasterLayer> height_layer,
+                                                  double max_segment_length, bool extend_ends,
+                                                  double offset_x, double offset_y,
+                                                  double offset_z) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!layer.is_valid() || !layer->is_valid(), Array(),
+                          "Can't build a mesh from an invalid GeoFeatureLayer!");
+#endif
+
+    ScopedTrace trace("GeoMeshBuilder::build_ribbon_mesh_in_square");
+
+    FeatureColumns columns = layer->get_native_layer()->get_feature_columns_in_square(
+        top_left_x, top_left_y, size_meters, max_features);
+
+    const AttributeColumn *width_column = get_column(columns, width_attribute);
+
+    std::vector<RibbonLine> ribbon_lines;
+
+    for (size_t row = 0; row < columns.ids.size(); row++) {
+        if (columns.geometry_types[row] != Feature::LINE) { continue; }
+
+        RibbonLine &ribbon_line = ribbon_lines.emplace_back();
+        ribbon_line.width = get_positive_value(width_column, row, default_width);
+
+        // Lines consist of a single ring
+        int64_t ring = columns.row_offsets[row];
+        ribbon_line.points.assign(columns.coordinates.begin() + columns.ring_offsets[ring] * 3,
+                                  columns.coordinates.begin() + columns.ring_offsets[ring + 1] * 3);
+    }
+
+    if (height_layer.is_valid()) { drape_lines(ribbon_lines, height_layer, max_segment_length); }
+
+    return get_mesh_arrays(RibbonBuilder::build(ribbon_lines, extend_ends), offset_x, offset_y,
+                           offset_z);
+}
+
+Array GeoMeshBuilder::build_building_meshes_in_square(
+    Ref<GeoFeatureLayer> layer, double top_left_x, double top_left_y, double size_meters,
+    int max_features, int chunks_per_side, String height_attribute, double default_height,
+    Ref<GeoRasterLayer> base_layer, double offset_x, double offset_y, double offset_z) {
+    Array result;
+
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!layer.is_valid() || !layer->is_valid(), result,
+                          "Can't build a mesh from an invalid GeoFeatureLayer!");
+    ERR_FAIL_COND_V_EDMSG(chunks_per_side < 1 || size_meters <= 0.0, result,
+                          "Buildings must be split into at least one chunk of a positive size!");
+    ERR_FAIL_COND_V_EDMSG(base_layer.is_valid() && !base_layer->is_valid(), result,
+                          "Can't place buildings on invalid GeoRasterLayer!");
+#endif
+
+    ScopedTrace trace("GeoMeshBuilder::build_building_meshes_in_square");
+
+    FeatureColumns columns = layer->get_native_layer()->get_feature_columns_in_square(
+        top_left_x, top_left_y, size_meters, max_features);
+
+    const AttributeColumn *height_column = get_column(columns, height_attribute);
+
+    std::unique_ptr<RasterSampler> sampler;
+    if (base_layer.is_valid()) {
+        sampler = std::make_unique<RasterSampler>(base_layer->get_native_dataset()->dataset);
+    }
+
+    double chunk_size = size_meters / chunks_per_side;
+
+    std::vector<BuildingFootprint> footprints;
+
+    for (size_t row = 0; row < columns.ids.size(); row++) {
+        if (columns.geometry_types[row] != Feature::POLYGON) { continue; }
+
+        int64_t first_ring = columns.row_offsets[row];
+        int64_t first_vertex = columns.ring_offsets[first_ring];
+        int64_t outer_end = columns.ring_offsets[first_ring + 1];
+        if (outer_end == first_vertex) { continue; }
+
+        // Buildings are assigned to the chunk containing the center of their bounding box.
+        // Buildings with their center outside of the square are left to the neighbouring square,
+        // so that adjacent tiles don't contain the same building twice.
+        double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+        double min_z = INFINITY;
+
+        for (int64_t vertex = first_vertex; vertex < outer_end; vertex++) {
+            double x = columns.coordinates[vertex * 3];
+            double y = columns.coordinates[vertex * 3 + 1];
+
+            min_x = std::min(min_x, x);
+            max_x = std::max(max_x, x);
+            min_y = std::min(min_y, y);
+            max_y = std::max(max_y, y);
+
+            // Buildings on slopes start at their lowest point, so that they don't float
+            double z = sampler ? sampler->sample(x, y) : columns.coordinates[vertex * 3 + 2];
+            if (!std::isnan(z)) { min_z = std::min(min_z, z); }
+        }
+
+        double center_x = (min_x + max_x) / 2.0 - top_left_x;
+        double center_y = top_left_y - (min_y + max_y) / 2.0;
+
+        if (center_x < 0.0 || center_x >= size_meters || center_y < 0.0 ||
+            center_y >= size_meters) {
+            continue;
+        }
+
+        int chunk_x = std::min(static_cast<int>(center_x / chunk_size), chunks_per_side - 1);
+        int chunk_y = std::min(static_cast<int>(center_y / chunk_size), chunks_per_side - 1);
+
+        BuildingFootprint &footprint = footprints.emplace_back();
+        footprint.base_height = std::isinf(min_z) ? 0.0 : min_z;
+        footprint.height = get_positive_value(height_column, row, default_height);
+        footprint.id = columns.ids[row];
+        footprint.chunk = chunk_y * chunks_per_side + chunk_x;
+
+        for (int64_t ring = first_ring; ring < columns.row_offsets[row + 1]; ring++) {
+            std::vector<double> &points = footprint.rings.emplace_back();
+
+            for (int64_t vertex = columns.ring_offsets[ring];
+                 vertex < columns.ring_offsets[ring + 1]; vertex++) {
+                points.push_back(columns.coordinates[vertex * 3]);
+                points.push_back(columns.coordinates[vertex * 3 + 1]);
+            }
+        }
+    }
+
+    std::vector<BuildingChunk> chunks =
+        BuildingExtruder::extrude(footprints, chunks_per_side * chunks_per_side);
+
+    // The building index is stored as a float, which is exact for up to 2^24 buildings per chunk
+    int64_t format = Mesh::ARRAY_CUSTOM_R_FLOAT << Mesh::ARRAY_FORMAT_CUSTOM0_SHIFT;
+
+    for (const BuildingChunk &chunk : chunks) {
+        Dictionary chunk_dictionary;
+
+        PackedInt64Array ids;
+        ids.resize(chunk.ids.size());
+        memcpy(ids.ptrw(), chunk.ids.data(), chunk.ids.size() * sizeof(int64_t));
+
+        chunk_dictionary["walls"] = get_mesh_arrays(chunk.walls, offset_x, offset_y, offset_z);
+        chunk_dictionary["roofs"] = get_mesh_arrays(chunk.roofs, offset_x, offset_y, offset_z);
+        chunk_dictionary["ids"] = ids;
+        chunk_dictionary["format"] = format;
+
+        result.append(chunk_dictionary);
+    }
+
+    return result;
+}
+
+void GeoMeshBuilder::drape_lines(std::vector<RibbonLine> &lines, Ref<GeoRasterLayer> height_layer,
+                                 double max_segment_length) {
+#ifdef DEBUG_ENABLED
+    ERR_FAIL_COND_V_EDMSG(!height_layer->is_valid(), ,
+                          "Can't drape lines on invalid GeoRasterLayer!");
+#endif
+
+    ScopedTrace trace("GeoMeshBuilder::drape_lines");
+
+    // A single sampler for all lines, so that each block is only read once
+    RasterSampler sampler(height_layer->get_native_dataset()->dataset);
+
+    for (RibbonLine &line : lines) {
+        std::vector<double> points;
+        points.reserve(line.points.size() / 3 * 2);
+
+        for (size_t i = 0; i + 2 < line.points.size(); i += 3) {
+            points.push_back(line.points[i]);
+            points.push_back(line.points[i + 1]);
+        }
+
+        line.points = sampler.drape_line(points, max_segment_length);
+    }
+}
+
+Array GeoMeshBuilder::get_mesh_arrays(const TriangleMesh &mesh, double offset_x, double offset_y,
+                                      double offset_z) {
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+
+    int vertex_count = mesh.vertices.size() / 2;
+
+    PackedVector3Array vertices;
+    PackedVector3Array normals;
+    vertices.resize(vertex_count);
+    normals.resize(vertex_count);
+
+    Vector3 *vertex_data = vertices.ptrw();
+    Vector3 *normal_data = normals.ptrw();
+
+    // Note: y and z are swapped because of differences in the coordinate system!
+    for (int i = 0; i < vertex_count; i++) {
+        vertex_data[i] = Vector3(mesh.vertices[i * 2] + offset_x, offset_y,
+                                 -mesh.vertices[i * 2 + 1] - offset_z);
+        normal_data[i] = Vector3(0.0, 1.0, 0.0);
+    }
+
+    PackedInt32Array indices;
+    indices.resize(mesh.indices.size());
+    memcpy(indices.ptrw(), mesh.indices.data(), mesh.indices.size() * sizeof(int32_t));
+
+    arrays[Mesh::ARRAY_VERTEX] = vertices;
+    arrays[Mesh::ARRAY_NORMAL] = normals;
+
+    // Godot rejects empty index arrays, so they are left out for empty meshes
+    if (!indices.is_empty()) { arrays[Mesh::ARRAY_INDEX] = indices; }
+
+    return arrays;
+}
+
+Array GeoMeshBuilder::get_mesh_arrays(const ExtrudedMesh &mesh, double offset_x, double offset_y,
+                                      double offset_z) {
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+
+    int vertex_count = mesh.vertices.size() / 3;
+
+    PackedVector3Array vertices;
+    PackedVector3Array normals;
+    PackedVector2Array uvs;
+    PackedFloat32Array building_indices;
+    vertices.resize(vertex_count);
+    normals.resize(vertex_count);
+    uvs.resize(vertex_count);
+    building_indices.resize(vertex_count);
+
+    Vector3 *vertex_data = vertices.ptrw();
+    Vector3 *normal_data = normals.ptrw();
+    Vector2 *uv_data = uvs.ptrw();
+    float *building_index_data = building_indices.ptrw();
+
+    // Note: y and z are swapped because of differences in the coordinate system!
+    for (int i = 0; i < vertex_count; i++) {
+        vertex_data[i] =
+            Vector3(mesh.vertices[i * 3] + offset_x, mesh.vertices[i * 3 + 2] + offset_y,
+                    -mesh.vertices[i * 3 + 1] - offset_z);
+        normal_data[i] =
+            Vector3(mesh.normals[i * 3], mesh.normals[i * 3 + 2], -mesh.normals[i * 3 + 1]);
+        uv_data[i] = Vector2(mesh.uvs[i * 2], mesh.uvs[i * 2 + 1]);
+        building_index_data[i] = static_cast<float>(mesh.building_indices[i]);
+    }
+
+    PackedInt32Array indices;
+    indices.resize(mesh.indices.size());
+    memcpy(indices.ptrw(), mesh.indices.data(), mesh.indices.size() * sizeof(int32_t));
+
+    arrays[Mesh::ARRAY_VERTEX] = vertices;
+    arrays[Mesh::ARRAY_NORMAL] = normals;
+    arrays[Mesh::ARRAY_TEX_UV] = uvs;
+    arrays[Mesh::ARRAY_CUSTOM0] = building_indices;
+
+    // Godot rejects empty index arrays, so they are left out for empty meshes
+    if (!indices.is_empty()) { arrays[Mesh::ARRAY_INDEX] = indices; }
+
+    return arrays;
+}
+
+const AttributeColumn *GeoMeshBuilder::get_column(const FeatureColumns &columns, String name) {
+    std::string column_name = name.utf8().get_data();
+    if (column_name.empty()) { return nullptr; }
+
+    for (const AttributeColumn &column : columns.attributes) {
+        if (column.name == column_name) { return &column; }
+    }
+
+    return nullptr;
+}
+
+double GeoMeshBuilder::get_positive_value(const AttributeColumn *column, size_t row,
+                                          double default_value) {
+    if (column == nullptr) { return default_value; }
+
+    double value = 0.0;
+
+    if (column->type == AttributeColumn::REAL) {
+        value = column->reals[row];
+    } else if (column->type == AttributeColumn::STRING) {
+        value = std::atof(column->strings[row].c_str());
+    } else {
+        value = static_cast<double>(column->integers[row]);
+    }
+
+    return value > 0.0 ? value : default_value;
+}
+
+Array GeoMeshBuilder::get_mesh_arrays(const RibbonMesh &mesh, double offset_x, double offset_y,
+                                      double offset_z) {
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+
+    int vertex_count = mesh.vertices.size() / 3;
+
+    PackedVector3Array vertices;
+    PackedVector3Array normals;
+    PackedVector2Array uvs;
+    vertices.resize(vertex_count);
+    normals.resize(vertex_count);
+    uvs.resize(vertex_count);
+
+    Vector3 *vertex_data = vertices.ptrw();
+    Vector3 *normal_data = normals.ptrw();
+    Vector2 *uv_data = uvs.ptrw();
+
+    // Note: y and z are swapped because of differences in the coordinate system!
+    for (int i = 0; i < vertex_count; i++) {
+        vertex_data[i] =
+            Vector3(mesh.vertices[i * 3] + offset_x, mesh.vertices[i * 3 + 2] + offset_y,
+                    -mesh.vertices[i * 3 + 1] - offset_z);
+        normal_data[i] =
+            Vector3(mesh.normals[i * 3], mesh.normals[i * 3 + 2], -mesh.normals[i * 3 + 1]);
+        uv_data[i] = Vector2(mesh.uvs[i * 2], mesh.uvs[i * 2 + 1]);
+    }
+
+    PackedInt32Array indices;
+    indices.resize(mesh.indices.size());
+    memcpy(indices.ptrw(), mesh.indices.data(), mesh.indices.size() * sizeof(int32_t));
+
+    arrays[Mesh::ARRAY_VERTEX] = vertices;
+    arrays[Mesh::ARRAY_NORMAL] = normals;
+    arrays[Mesh::ARRAY_TEX_UV] = uvs;
+
+    // Godot rejects empty index arrays, so they are left out for empty meshes
+    if (!indices.is_empty()) { arrays[Mesh::ARRAY_INDEX] = indices; }
+
+    return arrays;
+}
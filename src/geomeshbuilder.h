@@ -0,0 +1,116 @@
+#ifndef __GEOMESHBUILDER_H__
+#define __GEOMESHBUILDER_H__
+
+#include <godot_cpp/classes/object.hpp>
+
+#include "BuildingExtruder.h"
+#include "FeatureColumns.h"
+#include "PolygonTriangulator.h"
+#include "RibbonBuilder.h"
+#include "defines.h"
+#include "geodata.h"
+
+namespace godot {
+
+/// Builds mesh data from many features at once, natively and in parallel, so that e.g. all
+/// land-use polygons of a tile become one draw call.
+/// All functions return an Array in the layout expected by ArrayMesh.add_surface_from_arrays
+/// (with Mesh.ARRAY_MAX entries), for use with Mesh.PRIMITIVE_TRIANGLES. Vertices are placed in
+/// Godot's coordinate system like GeoPoint.get_float_offset_vector3: (x + offset_x, z + offset_y,
+/// -y - offset_z), with z being 0 for polygons.
+class EXPORT GeoMeshBuilder : public Object {
+    GDCLASS(GeoMeshBuilder, Object)
+
+  protected:
+    static void _bind_methods();
+
+  public:
+    /// Triangulates the given GeoPolygons (including their holes) into one flat mesh facing
+    /// upwards. Other features in the Array are ignored.
+    static Array build_polygon_mesh(Array polygons, double offset_x, double offset_y,
+                                    double offset_z);
+
+    /// Like build_polygon_mesh, but for the polygons in the given layer which intersect with the
+    /// square constructed by the given top-left and size. The features are read directly, without
+    /// creating a GeoPolygon for each of them.
+    static Array build_polygon_mesh_in_square(Ref<GeoFeatureLayer> layer, double top_left_x,
+                                              double top_left_y, double size_meters,
+                                              int max_features, double offset_x,
+                                              double offset_y, double offset_z);
+
+    /// Builds a ribbon mesh, e.g. for roads or rivers, along the given GeoLines. Other features in
+    /// the Array are ignored.
+    /// The width of each ribbon is read from the attribute with the given name; if it is empty,
+    /// missing or not larger than 0, default_width is used instead.
+    /// If a valid height_layer is given, the lines are draped onto it like with
+    /// GeoRasterLayer.drape_features (with the same meaning of max_segment_length); otherwise,
+    /// the heights of the line points are used.
+    /// Consecutive segments are joined with mitres. If extend_ends is true, the ends are extended
+    /// by half the width so that ribbons meeting at an intersection overlap without gaps.
+    /// In addition to vertices and normals, the arrays contain UVs: u goes from 0 on the left to
+    /// 1 on the right side of the line, v is the distance along the line in meters.
+    static Array build_ribbon_mesh(Array lines, String width_attribute, double default_width,
+                                   Ref<GeoRasterLayer> height_layer, double max_segment_length,
+                                   bool extend_ends, double offset_x, double offset_y,
+                                   double offset_z);
+
+    /// Like build_ribbon_mesh, but for the lines in the given layer which intersect with the
+    /// square constructed by the given top-left and size. The features are read directly, without
+    /// creating a GeoLine for each of them.
+    static Array build_ribbon_mesh_in_square(Ref<GeoFeatureLayer> layer, double top_left_x,
+                                             double top_left_y, double size_meters,
+                                             int max_features, String width_attribute,
+                                             double default_width,
+                                             Ref<GeoRasterLayer> height_layer,
+                                             double max_segment_length, bool extend_ends,
+                                             double offset_x, double offset_y, double offset_z);
+
+    /// Extrudes the polygons in the given layer, e.g. building footprints, into walls and flat
+    /// roofs. Only polygons whose bounding box center lies within the square constructed by the
+    /// given top-left and size are used, so that adjacent squares don't share buildings.
+    /// The square is split into chunks_per_side * chunks_per_side chunks, each with its own meshes.
+    /// The height of each building is read from the attribute with the given name; if it is empty,
+    /// missing or not larger than 0, default_height is used instead. Buildings start at the lowest
+    /// height of base_layer (if it is valid) or of the polygon (otherwise) below their outline.
+    /// Returns an Array with a Dictionary for each chunk, row by row from the top-left, with:
+    /// "walls" and "roofs": the mesh arrays, with UVs in meters (along the outline and upwards for
+    /// walls, relative to the first vertex for roofs) and the index of the building in "ids" as a
+    /// float in Mesh.ARRAY_CUSTOM0, e.g. for picking in a shader,
+    /// "ids": a PackedInt64Array with the feature ID of each building,
+    /// "format": the flags to pass to ArrayMesh.add_surface_from_arrays for the custom channel.
+    static Array build_building_meshes_in_square(Ref<GeoFeatureLayer> layer, double top_left_x,
+                                                 double top_left_y, double size_meters,
+                                                 int max_features, int chunks_per_side,
+                                                 String height_attribute, double default_height,
+                                                 Ref<GeoRasterLayer> base_layer, double offset_x,
+                                                 double offset_y, double offset_z);
+
+  private:
+    /// Converts the triangles to the arrays for ArrayMesh
+    static Array get_mesh_arrays(const TriangleMesh &mesh, double offset_x, double offset_y,
+                                 double offset_z);
+
+    /// Converts the ribbons to the arrays for ArrayMesh
+    static Array get_mesh_arrays(const RibbonMesh &mesh, double offset_x, double offset_y,
+                                 double offset_z);
+
+    /// Converts the extruded buildings to the arrays for ArrayMesh
+    static Array get_mesh_arrays(const ExtrudedMesh &mesh, double offset_x, double offset_y,
+                                 double offset_z);
+
+    /// Returns the attribute column with the given name, or nullptr if there is none
+    static const AttributeColumn *get_column(const FeatureColumns &columns, String name);
+
+    /// Returns the numeric value of the column in the given row, or default_value if there is no
+    /// column or the value is not larger than 0
+    static double get_positive_value(const AttributeColumn *column, size_t row,
+                                     double default_value);
+
+    /// Replaces the points of the lines with points draped onto the first band of the layer
+    static void drape_lines(std::vector<RibbonLine> &lines, Ref<GeoRasterLayer> height_layer,
+                            double max_segment_length);
+};
+
+} // namespace godot
+
+#endif // __GEOMESHBUILDER_H__
@@ -0,0 +1,134 @@
+#include "geoperformance.h"
+#include "RasterTileExtractor.h"
+#include "performance-counters.h"
+#include "trace.h"
+
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+using namespace godot;
+
+namespace {
+
+const char *COUNTER_NAMES[PerformanceCounters::COUNTER_MAX] = {
+    "get_image", "get_band_image", "get_value_at_position", "feature_queries", "save_override"};
+
+const char *EXTRA_MONITORS[] = {"Geodot/raster_decoded_mb", "Geodot/cached_features",
+                                "Geodot/gdal_block_cache_mb", "Geodot/lock_wait_ms",
+                                "Geodot/coalesced_tile_requests"};
+
+} // namespace
+
+void GeoPerformanceMonitors::add_monitor(const String &name, const Callable &callable,
+                                         int counter) {
+    Array arguments;
+    if (counter >= 0) { arguments.push_back(counter); }
+
+    Performance *performance = Performance::get_singleton();
+    if (!performance->has_custom_monitor(name)) {
+        performance->add_custom_monitor(name, callable, arguments);
+    }
+}
+
+void GeoPerformanceMonitors::add_monitors() {
+    for (int counter = 0; counter < PerformanceCounters::COUNTER_MAX; counter++) {
+        String name = String("Geodot/") + COUNTER_NAMES[counter];
+
+        add_monitor(name + "_calls", callable_mp_static(&GeoPerformanceMonitors::get_call_count),
+                    counter);
+        add_monitor(name + "_ms", callable_mp_static(&GeoPerformanceMonitors::get_milliseconds),
+                    counter);
+    }
+
+    add_monitor(EXTRA_MONITORS[0],
+                callable_mp_static(&GeoPerformanceMonitors::get_decoded_megabytes), -1);
+    add_monitor(EXTRA_MONITORS[1],
+                callable_mp_static(&GeoPerformanceMonitors::get_cached_feature_count), -1);
+    add_monitor(EXTRA_MONITORS[2],
+                callable_mp_static(&GeoPerformanceMonitors::get_block_cache_megabytes), -1);
+    add_monitor(EXTRA_MONITORS[3],
+                callable_mp_static(&GeoPerformanceMonitors::get_lock_wait_milliseconds), -1);
+    add_monitor(EXTRA_MONITORS[4],
+                callable_mp_static(&GeoPerformanceMonitors::get_coalesced_request_count), -1);
+}
+
+void GeoPerformanceMonitors::remove_monitors() {
+    Performance *performance = Performance::get_singleton();
+    if (performance == nullptr) { return; }
+
+    for (int counter = 0; counter < PerformanceCounters::COUNTER_MAX; counter++) {
+        String name = String("Geodot/") + COUNTER_NAMES[counter];
+
+        if (performance->has_custom_monitor(name + "_calls")) {
+            performance->remove_custom_monitor(name + "_calls");
+        }
+        if (performance->has_custom_monitor(name + "_ms")) {
+            performance->remove_custom_monitor(name + "_ms");
+        }
+    }
+
+    for (const char *name : EXTRA_MONITORS) {
+        if (performance->has_custom_monitor(name)) { performance->remove_custom_monitor(name); }
+    }
+}
+
+double GeoPerformanceMonitors::get_call_count(int counter) {
+    return PerformanceCounters::get_calls(static_cast<PerformanceCounters::Counter>(counter));
+}
+
+double GeoPerformanceMonitors::get_milliseconds(int counter) {
+    return PerformanceCounters::get_milliseconds(static_cast<PerformanceCounters::Counter>(counter));
+}
+
+double GeoPerformanceMonitors::get_decoded_megabytes() {
+    return PerformanceCounters::get_bytes_decoded() / (1024.0 * 1024.0);
+}
+
+double GeoPerformanceMonitors::get_cached_feature_count() {
+    return PerformanceCounters::get_cached_features();
+}
+
+double GeoPerformanceMonitors::get_block_cache_megabytes() {
+    return RasterTileExtractor::get_block_cache_used() / (1024.0 * 1024.0);
+}
+
+double GeoPerformanceMonitors::get_lock_wait_milliseconds() {
+    return PerformanceCounters::get_lock_wait_milliseconds();
+}
+
+double GeoPerformanceMonitors::get_coalesced_request_count() {
+    return PerformanceCounters::get_coalesced_requests();
+}
+
+void GeoTracer::_bind_methods() {
+    ClassDB::bind_static_method("GeoTracer", D_METHOD("start"), &GeoTracer::start);
+    ClassDB::bind_static_method("GeoTracer", D_METHOD("stop"), &GeoTracer::stop);
+    ClassDB::bind_static_method("GeoTracer", D_METHOD("is_running"), &GeoTracer::is_running);
+    ClassDB::bind_static_method("GeoTracer", D_METHOD("clear"), &GeoTracer::clear);
+    ClassDB::bind_static_method("GeoTracer", D_METHOD("dump", "path"), &GeoTracer::dump);
+}
+
+void GeoTracer::start() {
+    Tracer::clear();
+    Tracer::set_enabled(true);
+}
+
+void GeoTracer::stop() {
+    Tracer::set_enabled(false);
+}
+
+bool GeoTracer::is_running() {
+    return Tracer::is_enabled();
+}
+
+void GeoTracer::clear() {
+    Tracer::clear();
+}
+
+bool GeoTracer::dump(String path) {
+    String global_path = ProjectSettings::get_singleton()->globalize_path(path);
+
+    return Tracer::dump(global_path.utf8().get_data());
+}
@@ -0,0 +1,64 @@
+#ifndef __GEOPERFORMANCE_H__
+#define __GEOPERFORMANCE_H__
+
+#include <godot_cpp/classes/object.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include "defines.h"
+
+namespace godot {
+
+/// Exposes Geodot's internal performance counters as custom monitors of Godot's Performance
+/// singleton. They show up under "Geodot" in the debugger's Monitors tab, alongside frame time, and
+/// can also be read via Performance.get_custom_monitor("Geodot/...").
+/// The counters are cumulative; the graphs show how they grow per frame.
+class EXPORT GeoPerformanceMonitors {
+  public:
+    /// Registers all monitors. Called once when the extension is initialized.
+    static void add_monitors();
+
+    /// Removes all monitors again. Called when the extension is deinitialized.
+    static void remove_monitors();
+
+  private:
+    static double get_call_count(int counter);
+    static double get_milliseconds(int counter);
+    static double get_decoded_megabytes();
+    static double get_cached_feature_count();
+    static double get_block_cache_megabytes();
+    static double get_lock_wait_milliseconds();
+    static double get_coalesced_request_count();
+
+    static void add_monitor(const String &name, const Callable &callable, int counter);
+};
+
+/// Records trace events of Geodot internals (tile requests, raster reads, feature queries, lock
+/// waits) into per-thread ring buffers and writes them in the Chrome trace-event format, which can
+/// be opened in chrome://tracing or https://ui.perfetto.dev. Disabled by default.
+/// Usage: `GeoTracer.start()`, run the workload, then `GeoTracer.stop()` and
+/// `GeoTracer.dump("user://geodot_trace.json")`.
+class EXPORT GeoTracer : public Object {
+    GDCLASS(GeoTracer, Object)
+
+  protected:
+    static void _bind_methods();
+
+  public:
+    /// Discards previously recorded events and starts recording.
+    static void start();
+
+    /// Stops recording; recorded events are kept until the next start() or clear().
+    static void stop();
+
+    static bool is_running();
+
+    /// Discards all recorded events.
+    static void clear();
+
+    /// Writes all recorded events as JSON to the given path. Returns false if writing failed.
+    static bool dump(String path);
+};
+
+} // namespace godot
+
+#endif // __GEOPERFORMANCE_H__
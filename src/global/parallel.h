@@ -0,0 +1,74 @@
+#pragma once
+
+// Minimal helper for splitting CPU-bound work on decoded rasters across threads.
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace parallel_detail {
+
+/// The number of threads which calls to parallel_for_bands have started and not joined yet
+inline std::atomic<int> started_thread_count{0};
+
+/// True on threads started by parallel_for_bands
+inline thread_local bool is_band_thread = false;
+
+} // namespace parallel_detail
+
+/// Splits the range [0, count) into consecutive bands and calls function(begin, end) for each band
+/// on its own thread, returning once all bands are done. Bands contain at least min_band_size
+/// elements, so small inputs are processed on the calling thread without spawning any threads.
+/// All concurrent calls together start at most one thread less than there are cores, and nested
+/// calls from within a band run on the calling thread, so that callers which are already parallel
+/// don't oversubscribe the CPU.
+template <typename Function>
+void parallel_for_bands(int count, const Function &function, int min_band_size = 32) {
+    if (count <= 0) { return; }
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    int wanted_threads = std::clamp(count / std::max(min_band_size, 1), 1, max_threads) - 1;
+
+    if (parallel_detail::is_band_thread) { wanted_threads = 0; }
+
+    // Reserve the additional threads from the budget which is shared with concurrent calls
+    int extra_threads = 0;
+    int started = parallel_detail::started_thread_count.load();
+
+    do {
+        extra_threads = std::clamp(max_threads - 1 - started, 0, wanted_threads);
+    } while (extra_threads > 0 && !parallel_detail::started_thread_count.compare_exchange_weak(
+                                      started, started + extra_threads));
+
+    if (extra_threads == 0) {
+        function(0, count);
+        return;
+    }
+
+    int thread_count = extra_threads + 1;
+
+    std::vector<std::thread> threads;
+    threads.reserve(extra_threads);
+
+    int band_size = (count + thread_count - 1) / thread_count;
+
+    for (int begin = band_size; begin < count; begin += band_size) {
+        threads.emplace_back(
+            [&function](int band_begin, int band_end) {
+                parallel_detail::is_band_thread = true;
+                function(band_begin, band_end);
+            },
+            begin, std::min(begin + band_size, count));
+    }
+
+    // The calling thread takes care of the first band itself
+    function(0, std::min(band_size, count));
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    parallel_detail::started_thread_count -= extra_threads;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Lock-free counters for the hot paths of the processing libraries and Geodot.
+// Recording a sample costs two clock reads and a few relaxed atomic additions; nothing is
+// aggregated until the counters are actually read (e.g. by Godot's Performance monitors).
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include "trace.h"
+
+struct PerformanceCounterEntry {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> nanoseconds{0};
+};
+
+class PerformanceCounters {
+  public:
+    enum Counter {
+        GET_IMAGE,
+        GET_BAND_IMAGE,
+        GET_VALUE_AT_POSITION,
+        FEATURE_QUERY,
+        SAVE_OVERRIDE,
+        COUNTER_MAX
+    };
+
+    static void record(Counter counter, uint64_t nanoseconds) {
+        entries[counter].calls.fetch_add(1, std::memory_order_relaxed);
+        entries[counter].nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    static uint64_t get_calls(Counter counter) {
+        return entries[counter].calls.load(std::memory_order_relaxed);
+    }
+
+    static double get_milliseconds(Counter counter) {
+        return entries[counter].nanoseconds.load(std::memory_order_relaxed) / 1.0e6;
+    }
+
+    static void add_bytes_decoded(uint64_t bytes) {
+        bytes_decoded.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static uint64_t get_bytes_decoded() { return bytes_decoded.load(std::memory_order_relaxed); }
+
+    static void add_cached_features(int64_t amount) {
+        cached_features.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    static int64_t get_cached_features() { return cached_features.load(std::memory_order_relaxed); }
+
+    static void add_coalesced_request() {
+        coalesced_requests.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static uint64_t get_coalesced_requests() {
+        return coalesced_requests.load(std::memory_order_relaxed);
+    }
+
+    static double get_lock_wait_milliseconds() {
+        return lock_wait_nanoseconds.load(std::memory_order_relaxed) / 1.0e6;
+    }
+
+    /// Lock the given mutex, adding the time spent waiting for it to the lock wait counter and
+    /// recording it as a trace event with the given name. Uncontended locks are not timed at all.
+    template <typename Mutex> static void lock(Mutex &mutex, const char *trace_name = "lock wait") {
+        if (mutex.try_lock()) { return; }
+
+        ScopedTrace trace(trace_name);
+
+        auto before = std::chrono::steady_clock::now();
+        mutex.lock();
+        auto after = std::chrono::steady_clock::now();
+
+        lock_wait_nanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count(),
+            std::memory_order_relaxed);
+    }
+
+  private:
+    static inline PerformanceCounterEntry entries[COUNTER_MAX];
+    static inline std::atomic<uint64_t> bytes_decoded{0};
+    static inline std::atomic<int64_t> cached_features{0};
+    static inline std::atomic<uint64_t> lock_wait_nanoseconds{0};
+    static inline std::atomic<uint64_t> coalesced_requests{0};
+};
+
+/// Records the lifetime of this object as one call of the given counter.
+class ScopedPerformanceTimer {
+  public:
+    explicit ScopedPerformanceTimer(PerformanceCounters::Counter counter)
+        : counter(counter), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedPerformanceTimer() {
+        auto end = std::chrono::steady_clock::now();
+        PerformanceCounters::record(
+            counter, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+  private:
+    PerformanceCounters::Counter counter;
+    std::chrono::steady_clock::time_point start;
+};
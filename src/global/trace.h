@@ -0,0 +1,173 @@
+#pragma once
+
+// Optional tracing of Geodot internals in the Chrome trace-event format, viewable in
+// chrome://tracing or https://ui.perfetto.dev.
+// Every thread records into its own fixed-size ring buffer, so recording is lock-free; the oldest
+// events are overwritten once a buffer is full. Buffers of exited threads are handed to new
+// threads, so short-lived threads (e.g. of parallel_for_bands) don't add a buffer each. When
+// tracing is disabled, a ScopedTrace costs a single relaxed atomic load.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    /// Must point to a string with static lifetime, e.g. a string literal
+    const char *name;
+    int64_t start_nanoseconds;
+    int64_t end_nanoseconds;
+};
+
+struct TraceBuffer {
+    static constexpr uint64_t CAPACITY = 1 << 14;
+
+    explicit TraceBuffer(uint32_t thread_id) : thread_id(thread_id), events(CAPACITY) {}
+
+    uint32_t thread_id;
+
+    /// Total number of events ever written; the next event goes to head % CAPACITY.
+    /// Only written by the thread which owns the buffer.
+    std::atomic<uint64_t> head{0};
+
+    /// Events before this index were discarded by Tracer::clear.
+    std::atomic<uint64_t> first{0};
+
+    /// False once the owning thread has exited, so that the buffer can be given to a new thread.
+    /// Its events are kept (with this buffer's thread_id) until they are overwritten.
+    std::atomic<bool> is_in_use{true};
+
+    std::vector<TraceEvent> events;
+};
+
+class Tracer {
+  public:
+    static void set_enabled(bool enabled) { is_tracing.store(enabled, std::memory_order_relaxed); }
+
+    static bool is_enabled() { return is_tracing.load(std::memory_order_relaxed); }
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - epoch)
+            .count();
+    }
+
+    /// Record a complete event on the calling thread's buffer.
+    static void record(const char *name, int64_t start_nanoseconds, int64_t end_nanoseconds) {
+        TraceBuffer *buffer = get_thread_buffer();
+
+        uint64_t index = buffer->head.load(std::memory_order_relaxed);
+        buffer->events[index % TraceBuffer::CAPACITY] =
+            TraceEvent{name, start_nanoseconds, end_nanoseconds};
+        buffer->head.store(index + 1, std::memory_order_release);
+    }
+
+    /// Discard all recorded events. Safe while other threads record: only the events which were
+    /// recorded before are discarded, since the head of each buffer belongs to its thread.
+    static void clear() {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+
+        for (const std::shared_ptr<TraceBuffer> &buffer : buffers) {
+            buffer->first.store(buffer->head.load(std::memory_order_acquire),
+                                std::memory_order_release);
+        }
+    }
+
+    /// Write all recorded events into a JSON file at the given path. Returns false if the file
+    /// could not be written. Events which are recorded while dumping may be missing or torn, so
+    /// it is best to disable tracing before dumping.
+    static bool dump(const std::string &path) {
+        std::ofstream file(path);
+        if (!file.is_open()) { return false; }
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool is_first = true;
+
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+
+        for (const std::shared_ptr<TraceBuffer> &buffer : buffers) {
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t first = buffer->first.load(std::memory_order_acquire);
+            uint64_t count = std::min(head - std::min(first, head), TraceBuffer::CAPACITY);
+
+            for (uint64_t index = head - count; index < head; index++) {
+                const TraceEvent &event = buffer->events[index % TraceBuffer::CAPACITY];
+
+                if (!is_first) { file << ","; }
+                is_first = false;
+
+                // Complete events ("X") carry both begin and duration, in microseconds
+                file << "{\"name\":\"" << event.name << "\",\"cat\":\"geodot\",\"ph\":\"X\""
+                     << ",\"ts\":" << event.start_nanoseconds / 1000.0
+                     << ",\"dur\":" << (event.end_nanoseconds - event.start_nanoseconds) / 1000.0
+                     << ",\"pid\":1,\"tid\":" << buffer->thread_id << "}";
+            }
+        }
+
+        file << "]}\n";
+
+        return file.good();
+    }
+
+  private:
+    /// Returns the buffer of the calling thread to the registry when the thread exits
+    struct ThreadBufferLease {
+        TraceBuffer *buffer = nullptr;
+
+        ~ThreadBufferLease() {
+            if (buffer != nullptr) { buffer->is_in_use.store(false, std::memory_order_release); }
+        }
+    };
+
+    static TraceBuffer *get_thread_buffer() {
+        thread_local ThreadBufferLease lease;
+
+        if (lease.buffer == nullptr) {
+            // Buffers are kept in the registry after their thread exits so they can still be
+            // dumped, and are reused by the next thread which needs one
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+
+            for (const std::shared_ptr<TraceBuffer> &buffer : buffers) {
+                if (!buffer->is_in_use.load(std::memory_order_acquire)) {
+                    buffer->is_in_use.store(true, std::memory_order_relaxed);
+                    lease.buffer = buffer.get();
+                    break;
+                }
+            }
+
+            if (lease.buffer == nullptr) {
+                buffers.emplace_back(std::make_shared<TraceBuffer>(buffers.size() + 1));
+                lease.buffer = buffers.back().get();
+            }
+        }
+
+        return lease.buffer;
+    }
+
+    static inline std::atomic<bool> is_tracing{false};
+    static inline const std::chrono::steady_clock::time_point epoch =
+        std::chrono::steady_clock::now();
+    static inline std::mutex buffers_mutex;
+    static inline std::vector<std::shared_ptr<TraceBuffer>> buffers;
+};
+
+/// Records the lifetime of this object as a trace event, if tracing is enabled.
+class ScopedTrace {
+  public:
+    explicit ScopedTrace(const char *name)
+        : name(name), start(Tracer::is_enabled() ? Tracer::now() : -1) {}
+
+    ~ScopedTrace() {
+        if (start >= 0) { Tracer::record(name, start, Tracer::now()); }
+    }
+
+  private:
+    const char *name;
+    int64_t start;
+};
@@ -0,0 +1,227 @@
+#include "Contours.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+/// A part of a contour line within one cell, between the crossings of two pixel edges.
+/// Crossings are identified by level_index * edge_count + edge, where edge is
+/// 2 * (y * width + x) for the edge from pixel (x, y) to (x + 1, y) and
+/// 2 * (y * width + x) + 1 for the edge from pixel (x, y) to (x, y + 1).
+/// Neighbouring cells share their edges, which is what lines are joined by.
+struct Segment {
+    uint64_t start;
+    uint64_t end;
+};
+
+} // namespace
+
+std::vector<ContourLine> Contours::trace(const float *heights, int width, int height,
+                                         double top_left_x, double top_left_y,
+                                         double pixel_size_x, double pixel_size_y,
+                                         double interval, double base) {
+    ScopedTrace trace("Contours::trace");
+
+    std::vector<ContourLine> lines;
+
+    if (width < 2 || height < 2 || !(interval > 0.0)) { return lines; }
+
+    size_t pixel_count = static_cast<size_t>(width) * height;
+
+    float min_height = std::numeric_limits<float>::max();
+    float max_height = std::numeric_limits<float>::lowest();
+
+    for (size_t i = 0; i < pixel_count; i++) {
+        if (std::isnan(heights[i])) { continue; }
+
+        min_height = std::min(min_height, heights[i]);
+        max_height = std::max(max_height, heights[i]);
+    }
+
+    if (min_height > max_height) { return lines; }
+
+    int64_t first_level = static_cast<int64_t>(std::ceil((min_height - base) / interval));
+    uint64_t edge_count = pixel_count * 2;
+
+    auto get_level = [&](uint64_t level_index) {
+        return base + (first_level + static_cast<int64_t>(level_index)) * interval;
+    };
+
+    // Find the segments within each cell between four pixel centers, in bands of rows. Each row
+    // of cells gets its own list of segments so that the result does not depend on the threads.
+    int cell_rows = height - 1;
+    std::vector<std::vector<Segment>> row_segments(cell_rows);
+
+    parallel_for_bands(
+        cell_rows,
+        [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                std::vector<Segment> &segments = row_segments[y];
+
+                for (int x = 0; x < width - 1; x++) {
+                    size_t index = static_cast<size_t>(y) * width + x;
+
+                    float top_left = heights[index];
+                    float top_right = heights[index + 1];
+                    float bottom_left = heights[index + width];
+                    float bottom_right = heights[index + width + 1];
+
+                    if (std::isnan(top_left) || std::isnan(top_right) ||
+                        std::isnan(bottom_left) || std::isnan(bottom_right)) {
+                        continue;
+                    }
+
+                    float cell_min = std::min({top_left, top_right, bottom_left, bottom_right});
+                    float cell_max = std::max({top_left, top_right, bottom_left, bottom_right});
+
+                    int64_t level_begin =
+                        static_cast<int64_t>(std::ceil((cell_min - base) / interval));
+                    int64_t level_end =
+                        static_cast<int64_t>(std::floor((cell_max - base) / interval));
+
+                    // Edges in the order in which they surround the cell
+                    uint64_t top_edge = index * 2;
+                    uint64_t right_edge = (index + 1) * 2 + 1;
+                    uint64_t bottom_edge = (index + width) * 2;
+                    uint64_t left_edge = index * 2 + 1;
+
+                    for (int64_t level = level_begin; level <= level_end; level++) {
+                        double value = base + level * interval;
+                        uint64_t offset = (level - first_level) * edge_count;
+
+                        bool is_top_left_high = top_left >= value;
+                        bool is_top_right_high = top_right >= value;
+                        bool is_bottom_left_high = bottom_left >= value;
+                        bool is_bottom_right_high = bottom_right >= value;
+
+                        std::array<uint64_t, 4> crossings;
+                        int crossing_count = 0;
+
+                        if (is_top_left_high != is_top_right_high) {
+                            crossings[crossing_count++] = offset + top_edge;
+                        }
+                        if (is_top_right_high != is_bottom_right_high) {
+                            crossings[crossing_count++] = offset + right_edge;
+                        }
+                        if (is_bottom_right_high != is_bottom_left_high) {
+                            crossings[crossing_count++] = offset + bottom_edge;
+                        }
+                        if (is_bottom_left_high != is_top_left_high) {
+                            crossings[crossing_count++] = offset + left_edge;
+                        }
+
+                        if (crossing_count == 2) {
+                            segments.push_back({crossings[0], crossings[1]});
+                        } else if (crossing_count == 4) {
+                            // Saddle: the average of the corners decides which diagonal pair of
+                            // corners is connected through the center of the cell
+                            bool is_center_high =
+                                (top_left + top_right + bottom_left + bottom_right) / 4.0 >= value;
+
+                            if (is_center_high == is_top_left_high) {
+                                segments.push_back({crossings[0], crossings[1]});
+                                segments.push_back({crossings[2], crossings[3]});
+                            } else {
+                                segments.push_back({crossings[3], crossings[0]});
+                                segments.push_back({crossings[1], crossings[2]});
+                            }
+                        }
+                    }
+                }
+            }
+        },
+        16);
+
+    std::vector<Segment> segments;
+    for (std::vector<Segment> &row : row_segments) {
+        segments.insert(segments.end(), row.begin(), row.end());
+    }
+
+    // Every crossing is shared by at most two segments (one in each cell next to the edge)
+    std::unordered_map<uint64_t, std::array<int, 2>> segments_at_crossing;
+    segments_at_crossing.reserve(segments.size() * 2);
+
+    for (int i = 0; i < static_cast<int>(segments.size()); i++) {
+        for (uint64_t crossing : {segments[i].start, segments[i].end}) {
+            auto inserted = segments_at_crossing.emplace(crossing, std::array<int, 2>{i, -1});
+            if (!inserted.second) { inserted.first->second[1] = i; }
+        }
+    }
+
+    auto get_point = [&](uint64_t crossing, std::vector<double> &points) {
+        uint64_t edge = crossing % edge_count;
+        size_t index = edge / 2;
+        bool is_horizontal = edge % 2 == 0;
+
+        float start_height = heights[index];
+        float end_height = heights[is_horizontal ? index + 1 : index + width];
+        double fraction = (get_level(crossing / edge_count) - start_height) /
+                          (end_height - start_height);
+
+        double pixel_x = static_cast<double>(index % width) + (is_horizontal ? fraction : 0.0);
+        double pixel_y = static_cast<double>(index / width) + (is_horizontal ? 0.0 : fraction);
+
+        points.push_back(top_left_x + (pixel_x + 0.5) * pixel_size_x);
+        points.push_back(top_left_y - (pixel_y + 0.5) * pixel_size_y);
+    };
+
+    // Follows the segments from the given segment through the given crossing, marking them as
+    // visited and appending their crossings, until a line end or a visited segment is reached
+    std::vector<bool> is_visited(segments.size(), false);
+
+    auto follow = [&](int segment, uint64_t crossing, std::vector<uint64_t> &chain) {
+        while (true) {
+            const std::array<int, 2> &neighbours = segments_at_crossing.find(crossing)->second;
+            int next = neighbours[0] == segment ? neighbours[1] : neighbours[0];
+
+            if (next == -1 || is_visited[next]) { return; }
+
+            is_visited[next] = true;
+            segment = next;
+            crossing = segments[next].start == crossing ? segments[next].end : segments[next].start;
+            chain.push_back(crossing);
+        }
+    };
+
+    for (int i = 0; i < static_cast<int>(segments.size()); i++) {
+        if (is_visited[i]) { continue; }
+
+        is_visited[i] = true;
+
+        std::vector<uint64_t> forward{segments[i].start, segments[i].end};
+        follow(i, segments[i].end, forward);
+
+        ContourLine line;
+        line.level = get_level(segments[i].start / edge_count);
+        line.is_closed = forward.size() > 2 && forward.back() == forward.front();
+
+        std::vector<uint64_t> chain;
+
+        if (line.is_closed) {
+            chain = std::move(forward);
+        } else {
+            // The segment may be in the middle of the line, so also follow it backwards
+            std::vector<uint64_t> backward;
+            follow(i, segments[i].start, backward);
+
+            chain.assign(backward.rbegin(), backward.rend());
+            chain.insert(chain.end(), forward.begin(), forward.end());
+        }
+
+        line.points.reserve(chain.size() * 2);
+        for (uint64_t crossing : chain) {
+            get_point(crossing, line.points);
+        }
+
+        lines.emplace_back(std::move(line));
+    }
+
+    return lines;
+}
@@ -0,0 +1,33 @@
+#ifndef RASTEREXTRACTOR_CONTOURS_H
+#define RASTEREXTRACTOR_CONTOURS_H
+
+#include "defines.h"
+
+#include <vector>
+
+/// A contour line at a given height, as consecutive x, y pairs in projected meters.
+struct ContourLine {
+    double level;
+
+    std::vector<double> points;
+
+    /// True if the line is a ring, in which case the last point equals the first one.
+    bool is_closed;
+};
+
+/// Generation of contour lines (isolines) from decoded heightmaps, as known from gdal_contour.
+class Contours {
+  public:
+    /// Traces contour lines at every multiple of interval (offset by base) through the given
+    /// row-major heights, starting at the north-west corner top_left_x, top_left_y.
+    /// Contours are found with marching squares between the pixel centers. Bands of rows are
+    /// processed on separate threads, and the resulting segments are joined into continuous lines
+    /// through the pixel edges they cross, so there are no seams between the bands.
+    /// Cells with a NaN height are skipped, so no-data values must be replaced by NaN beforehand.
+    static std::vector<ContourLine> trace(const float *heights, int width, int height,
+                                          double top_left_x, double top_left_y,
+                                          double pixel_size_x, double pixel_size_y,
+                                          double interval, double base);
+};
+
+#endif // RASTEREXTRACTOR_CONTOURS_H
@@ -1,14 +1,18 @@
 #include "GeoRaster.h"
 #include "gdal-includes.h"
+#include "performance-counters.h"
+#include "trace.h"
 #include <algorithm> // For std::clamp etc
+#include <cmath>
 #include <cstring>
 #include <map>
 #include <mutex>
+#include <vector>
 
 std::mutex RasterIOHelper::rasterio_mutex = std::mutex();
 
 RasterIOHelper::RasterIOHelper() {
-    rasterio_mutex.lock();
+    PerformanceCounters::lock(rasterio_mutex, "RasterIOHelper lock wait");
 }
 
 RasterIOHelper::~RasterIOHelper() {
@@ -20,11 +24,13 @@ RasterIOHelper GeoRaster::get_raster_io_helper() {
     
     int min_raster_size = std::min(data->GetRasterXSize(), data->GetRasterYSize());
 
-    double source_destination_ratio = static_cast<double>(destination_window_size_pixels) /
-                                      static_cast<double>(source_window_size_pixels);
+    double source_destination_ratio_x =
+        static_cast<double>(destination_width) / static_cast<double>(source_window_width);
+    double source_destination_ratio_y =
+        static_cast<double>(destination_height) / static_cast<double>(source_window_height);
 
-    int usable_width = source_window_size_pixels;
-    int usable_height = source_window_size_pixels;
+    int usable_width = source_window_width;
+    int usable_height = source_window_height;
 
     int clamped_pixel_offset_x = pixel_offset_x;
     int clamped_pixel_offset_y = pixel_offset_y;
@@ -40,50 +46,50 @@ RasterIOHelper GeoRaster::get_raster_io_helper() {
     // Calculate clamped_pixel_offset and usable_[width|height] which can be used for retrieving data
     // without getting outside of the raster data's extent (which would cause RasterIO errors)
     // How this should be used:
-    // 1. Create array using size destination_window_size_pixels
+    // 1. Create array using size destination_width * destination_height
     // 2. Extract into that array clamped offset and usable width/height, offset by x and y remainder
 
     bool is_left_outside = pixel_offset_x < 0;
-    bool is_right_outside = pixel_offset_x + source_window_size_pixels > available_x;
+    bool is_right_outside = pixel_offset_x + source_window_width > available_x;
 
     if (is_left_outside || is_right_outside) {
         if (is_left_outside) {
             usable_width += pixel_offset_x;
-            remainder_x_left = (-pixel_offset_x) * source_destination_ratio;
+            remainder_x_left = (-pixel_offset_x) * source_destination_ratio_x;
             clamped_pixel_offset_x = 0;
 
-            target_width = usable_width * source_destination_ratio;
+            target_width = usable_width * source_destination_ratio_x;
         }
         if (is_right_outside) {
-            usable_width -= pixel_offset_x + source_window_size_pixels - available_x;
+            usable_width -= pixel_offset_x + source_window_width - available_x;
 
-            target_width = usable_width * source_destination_ratio;
+            target_width = usable_width * source_destination_ratio_x;
         }
     } else {
-        // Could be generalized as `target_width = usable_width * source_destination_ratio`, but
+        // Could be generalized as `target_width = usable_width * source_destination_ratio_x`, but
         // this can introduce a slight floating point error in cases where target_width should be
-        // equal to destination_window_size_pixels, so this is set explicitly here
-        target_width = destination_window_size_pixels;
+        // equal to destination_width, so this is set explicitly here
+        target_width = destination_width;
     }
 
     bool is_up_outside = pixel_offset_y < 0;
-    bool is_down_outside = pixel_offset_y + source_window_size_pixels > available_y;
+    bool is_down_outside = pixel_offset_y + source_window_height > available_y;
 
     if (is_up_outside || is_down_outside) {
         if (is_up_outside) {
             usable_height += pixel_offset_y;
-            remainder_y_top = (-pixel_offset_y) * source_destination_ratio;
+            remainder_y_top = (-pixel_offset_y) * source_destination_ratio_y;
             clamped_pixel_offset_y = 0;
 
-            target_height = usable_height * source_destination_ratio;
+            target_height = usable_height * source_destination_ratio_y;
         }
         if (is_down_outside) {
-            usable_height -= pixel_offset_y + source_window_size_pixels - available_y;
+            usable_height -= pixel_offset_y + source_window_height - available_y;
 
-            target_height = usable_height * source_destination_ratio;
+            target_height = usable_height * source_destination_ratio_y;
         }
     } else {
-        target_height = destination_window_size_pixels;
+        target_height = destination_height;
     }
 
     result.clamped_pixel_offset_x = clamped_pixel_offset_x;
@@ -99,24 +105,132 @@ RasterIOHelper GeoRaster::get_raster_io_helper() {
     return result;
 }
 
-void *GeoRaster::get_as_array() {
+bool GeoRaster::read_band_into(GDALRasterBand *band, uint8_t *array, int data_type,
+                               int pixel_stride, const RasterIOHelper &helper, int interpolation) {
+    ScopedTrace trace("GeoRaster::read_band");
+
+    if (resample_from_geotransform) {
+        return read_band_resampled(band, array, data_type, pixel_stride, helper, interpolation);
+    }
+
+    GDALRasterIOExtraArg rasterio_args;
+    INIT_RASTERIO_EXTRA_ARG(rasterio_args);
+    rasterio_args.eResampleAlg = static_cast<GDALRIOResampleAlg>(interpolation);
+
+    int line_stride = destination_width * pixel_stride;
+
+    CPLErr error = band->RasterIO(
+        GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width,
+        helper.usable_height,
+        array + helper.remainder_y_top * line_stride + helper.remainder_x_left * pixel_stride,
+        helper.target_width, helper.target_height, static_cast<GDALDataType>(data_type),
+        pixel_stride, line_stride, &rasterio_args);
+
+    return error < CE_Failure;
+}
+
+bool GeoRaster::read_band_resampled(GDALRasterBand *band, uint8_t *array, int data_type,
+                                    int pixel_stride, const RasterIOHelper &helper,
+                                    int interpolation) {
+    double transform[6];
+    double inverse_transform[6];
+    data->GetGeoTransform(transform);
+    if (!GDALInvGeoTransform(transform, inverse_transform)) { return false; }
+
+    GDALDataType type = static_cast<GDALDataType>(data_type);
+    int type_size = GDALGetDataTypeSizeBytes(type);
+
+    // Only read as many pixels of the bounding window as the destination resolution requires
+    double scale = std::min(1.0, std::max(static_cast<double>(destination_width) / source_window_width,
+                                          static_cast<double>(destination_height) / source_window_height));
+    int read_width = std::max(1, static_cast<int>(ceil(helper.usable_width * scale)));
+    int read_height = std::max(1, static_cast<int>(ceil(helper.usable_height * scale)));
+
     GDALRasterIOExtraArg rasterio_args;
     INIT_RASTERIO_EXTRA_ARG(rasterio_args);
+    rasterio_args.eResampleAlg = static_cast<GDALRIOResampleAlg>(interpolation);
+
+    std::vector<uint8_t> window(static_cast<size_t>(read_width) * read_height * type_size);
+
+    CPLErr error = band->RasterIO(GF_Read, helper.clamped_pixel_offset_x,
+                                  helper.clamped_pixel_offset_y, helper.usable_width,
+                                  helper.usable_height, window.data(), read_width, read_height,
+                                  type, 0, 0, &rasterio_args);
+    if (error >= CE_Failure) { return false; }
+
+    double window_scale_x = static_cast<double>(read_width) / helper.usable_width;
+    double window_scale_y = static_cast<double>(read_height) / helper.usable_height;
+    bool bilinear = interpolation != 0 && type == GDT_Float32;
+
+    for (int row = 0; row < destination_height; row++) {
+        double world_y = world_top_left_y - (row + 0.5) * world_size_y / destination_height;
+
+        for (int column = 0; column < destination_width; column++) {
+            double world_x = world_top_left_x + (column + 0.5) * world_size_x / destination_width;
+
+            double pixel_x, pixel_y;
+            GDALApplyGeoTransform(inverse_transform, world_x, world_y, &pixel_x, &pixel_y);
+
+            // Position within the read window, in window pixels
+            double window_x = (pixel_x - helper.clamped_pixel_offset_x) * window_scale_x;
+            double window_y = (pixel_y - helper.clamped_pixel_offset_y) * window_scale_y;
+
+            if (window_x < 0.0 || window_y < 0.0 || window_x >= read_width ||
+                window_y >= read_height) {
+                // Outside of the dataset: keep the nodata value the array was filled with
+                continue;
+            }
+
+            uint8_t *destination =
+                array + (static_cast<size_t>(row) * destination_width + column) * pixel_stride;
+
+            if (bilinear) {
+                const float *values = reinterpret_cast<const float *>(window.data());
+
+                double sample_x = std::clamp(window_x - 0.5, 0.0, read_width - 1.0);
+                double sample_y = std::clamp(window_y - 0.5, 0.0, read_height - 1.0);
+                int x0 = static_cast<int>(sample_x);
+                int y0 = static_cast<int>(sample_y);
+                int x1 = std::min(x0 + 1, read_width - 1);
+                int y1 = std::min(y0 + 1, read_height - 1);
+                float fraction_x = sample_x - x0;
+                float fraction_y = sample_y - y0;
+
+                float top = values[y0 * read_width + x0] * (1.0f - fraction_x) +
+                            values[y0 * read_width + x1] * fraction_x;
+                float bottom = values[y1 * read_width + x0] * (1.0f - fraction_x) +
+                               values[y1 * read_width + x1] * fraction_x;
+                float value = top * (1.0f - fraction_y) + bottom * fraction_y;
+
+                memcpy(destination, &value, sizeof(float));
+            } else {
+                size_t source_index = static_cast<size_t>(window_y) * read_width +
+                                      static_cast<size_t>(window_x);
+                memcpy(destination, window.data() + source_index * type_size, type_size);
+            }
+        }
+    }
+
+    return true;
+}
+
+void *GeoRaster::get_as_array() {
+    ScopedTrace trace("GeoRaster::get_as_array");
 
     int interpolation = interpolation_type;
 
     // If we're requesting downscaled data, always use nearest neighbour scaling.
     // TODO: Would be good if this could be overridden with an optional parameter, but any other
     // scaling usually causes very long loading times so this is the default for now
-    if (destination_window_size_pixels < source_window_size_pixels) { interpolation = 0; }
-
-    rasterio_args.eResampleAlg = static_cast<GDALRIOResampleAlg>(interpolation);
+    if (destination_width < source_window_width || destination_height < source_window_height) {
+        interpolation = 0;
+    }
 
     RasterIOHelper helper = get_raster_io_helper();
     // TODO: We could do more precise error handling by getting the error number using
     // CPLGetLastErrorNo() and returning that to the user somehow - maybe a flag in the
     // GeoRaster.
-    CPLErr error = CE_Failure;
+    bool success = false;
 
     // Depending on the image format, we need to structure the resulting array differently and/or
     // read multiple bands.
@@ -132,13 +246,13 @@ void *GeoRaster::get_as_array() {
             return array;
         }
 
-        error = band->RasterIO(
-            GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width, helper.usable_height,
-            array + helper.remainder_y_top * destination_window_size_pixels + helper.remainder_x_left,
-            helper.target_width, helper.target_height, GDT_Float32, 0, destination_window_size_pixels * 4,
-            &rasterio_args);
+        success = read_band_into(band, reinterpret_cast<uint8_t *>(array), GDT_Float32, 4, helper,
+                                 interpolation);
 
-        if (error < CE_Failure) { return array; }
+        if (success) {
+            PerformanceCounters::add_bytes_decoded(get_size_in_bytes());
+            return array;
+        }
 
         // Delete array in case of error
         delete [] array;
@@ -165,16 +279,14 @@ void *GeoRaster::get_as_array() {
                     GDALRasterBand *band = data->GetRasterBand(band_number);
 
                     // Read into the array with 4 bytes between the pixels
-                    error = band->RasterIO(
-                        GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width,
-                        helper.usable_height,
-                        array + (helper.remainder_y_top * destination_window_size_pixels + helper.remainder_x_left) * 4 +
-                            (band_number - 1),
-                        helper.target_width, helper.target_height, GDT_Byte, 4, destination_window_size_pixels * 4,
-                        &rasterio_args);
+                    success = read_band_into(band, array + (band_number - 1), GDT_Byte, 4, helper,
+                                             interpolation);
                 }
 
-                if (error < CE_Failure) { return array; }
+                if (success) {
+                    PerformanceCounters::add_bytes_decoded(get_size_in_bytes());
+                    return array;
+                }
 
                 // Delete array in case of error
                 delete [] array;
@@ -188,17 +300,15 @@ void *GeoRaster::get_as_array() {
                 // So that the result is RGBRGBRGB.
                 for (int band_number = 1; band_number < 4; band_number++) {
                     GDALRasterBand *band = data->GetRasterBand(band_number);
-                    // Read into the array with 4 bytes between the pixels
-                    error = band->RasterIO(
-                        GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width,
-                        helper.usable_height,
-                        array + (helper.remainder_y_top * destination_window_size_pixels + helper.remainder_x_left) * 3 +
-                            (band_number - 1),
-                        helper.target_width, helper.target_height, GDT_Byte, 3, destination_window_size_pixels * 3,
-                        &rasterio_args);
+                    // Read into the array with 3 bytes between the pixels
+                    success = read_band_into(band, array + (band_number - 1), GDT_Byte, 3, helper,
+                                             interpolation);
                 }
 
-                if (error < CE_Failure) { return array; }
+                if (success) {
+                    PerformanceCounters::add_bytes_decoded(get_size_in_bytes());
+                    return array;
+                }
 
                 // Delete array in case of error
                 delete [] array;
@@ -206,13 +316,12 @@ void *GeoRaster::get_as_array() {
             }
             case BYTE: {
                 GDALRasterBand *band = data->GetRasterBand(1);
-                error = band->RasterIO(
-                    GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width, helper.usable_height,
-                    array + helper.remainder_y_top * destination_window_size_pixels + helper.remainder_x_left,
-                    helper.target_width, helper.target_height, GDT_Byte, 0, destination_window_size_pixels,
-                    &rasterio_args);
+                success = read_band_into(band, array, GDT_Byte, 1, helper, interpolation);
 
-                if (error < CE_Failure) { return array; }
+                if (success) {
+                    PerformanceCounters::add_bytes_decoded(get_size_in_bytes());
+                    return array;
+                }
 
                 // Delete array in case of error
                 delete [] array;
@@ -230,18 +339,15 @@ void *GeoRaster::get_as_array() {
 }
 
 void *GeoRaster::get_band_as_array(int band_index) {
-    GDALRasterIOExtraArg rasterio_args;
-    INIT_RASTERIO_EXTRA_ARG(rasterio_args);
+    ScopedTrace trace("GeoRaster::get_band_as_array");
 
     int interpolation = interpolation_type;
 
-    rasterio_args.eResampleAlg = static_cast<GDALRIOResampleAlg>(interpolation);
-
     RasterIOHelper helper = get_raster_io_helper();
     // TODO: We could do more precise error handling by getting the error number using
     // CPLGetLastErrorNo() and returning that to the user somehow - maybe a flag in the
     // GeoRaster.
-    CPLErr error = CE_Failure;
+    bool success = false;
     FORMAT band_format = get_band_format(band_index);
     int pixel_size = get_pixel_size_x() * get_pixel_size_y();
     switch (band_format) {
@@ -254,16 +360,15 @@ void *GeoRaster::get_band_as_array(int band_index) {
                 // only 0s
                 return array;
             }
-            error = band->RasterIO(
-                    GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width, helper.usable_height,
-                    array + helper.remainder_y_top * destination_window_size_pixels + helper.remainder_x_left,
-                    helper.target_width, helper.target_height, GDT_Byte, 0, destination_window_size_pixels,
-                    &rasterio_args);
+            success = read_band_into(band, array, GDT_Byte, 1, helper, interpolation);
 
-                if (error < CE_Failure) { return array; }
+            if (success) {
+                PerformanceCounters::add_bytes_decoded(pixel_size);
+                return array;
+            }
 
-                // Delete array in case of error
-                delete [] array;
+            // Delete array in case of error
+            delete [] array;
 
             break;
         }
@@ -278,13 +383,13 @@ void *GeoRaster::get_band_as_array(int band_index) {
                 return array;
             }
 
-            error = band->RasterIO(
-                GF_Read, helper.clamped_pixel_offset_x, helper.clamped_pixel_offset_y, helper.usable_width, helper.usable_height,
-                array + helper.remainder_y_top * destination_window_size_pixels + helper.remainder_x_left,
-                helper.target_width, helper.target_height, GDT_Float32, 0, destination_window_size_pixels * 4,
-                &rasterio_args);
+            success = read_band_into(band, reinterpret_cast<uint8_t *>(array), GDT_Float32, 4,
+                                     helper, interpolation);
 
-            if (error < CE_Failure) { return array; }
+            if (success) {
+                PerformanceCounters::add_bytes_decoded(pixel_size * 4);
+                return array;
+            }
 
             // Delete array in case of error
             delete [] array;
@@ -343,11 +448,67 @@ GeoRaster::FORMAT GeoRaster::get_band_format(int band_index) {
 }
 
 int GeoRaster::get_pixel_size_x() {
-    return destination_window_size_pixels;
+    return destination_width;
 }
 
 int GeoRaster::get_pixel_size_y() {
-    return destination_window_size_pixels;
+    return destination_height;
+}
+
+double GeoRaster::get_pixel_size_meters_x() {
+    if (resample_from_geotransform) { return world_size_x / destination_width; }
+
+    double transform[6];
+    data->GetGeoTransform(transform);
+
+    return hypot(transform[1], transform[4]) * source_window_width / destination_width;
+}
+
+double GeoRaster::get_pixel_size_meters_y() {
+    if (resample_from_geotransform) { return world_size_y / destination_height; }
+
+    double transform[6];
+    data->GetGeoTransform(transform);
+
+    return hypot(transform[2], transform[5]) * source_window_height / destination_height;
+}
+
+double GeoRaster::get_top_left_x() {
+    if (resample_from_geotransform) { return world_top_left_x; }
+
+    double transform[6];
+    data->GetGeoTransform(transform);
+
+    return transform[0] + pixel_offset_x * transform[1] + pixel_offset_y * transform[2];
+}
+
+double GeoRaster::get_top_left_y() {
+    if (resample_from_geotransform) { return world_top_left_y; }
+
+    double transform[6];
+    data->GetGeoTransform(transform);
+
+    return transform[3] + pixel_offset_x * transform[4] + pixel_offset_y * transform[5];
+}
+
+bool GeoRaster::has_no_data_value(int band_index) {
+    int has_no_data = 0;
+    data->GetRasterBand(band_index)->GetNoDataValue(&has_no_data);
+
+    return has_no_data != 0;
+}
+
+float GeoRaster::get_no_data_value(int band_index) {
+    return static_cast<float>(data->GetRasterBand(band_index)->GetNoDataValue());
+}
+
+void GeoRaster::set_world_window(double top_left_x, double top_left_y, double size_meters_x,
+                                 double size_meters_y) {
+    resample_from_geotransform = true;
+    world_top_left_x = top_left_x;
+    world_top_left_y = top_left_y;
+    world_size_x = size_meters_x;
+    world_size_y = size_meters_y;
 }
 
 uint64_t *GeoRaster::get_histogram() {
@@ -435,14 +596,22 @@ GeoRaster::FORMAT GeoRaster::get_format_for_dataset(GDALDataset *data) {
 }
 
 GeoRaster::GeoRaster(GDALDataset *data, int interpolation_type)
-    : GeoRaster(data, 0, 0, data->GetRasterXSize(), data->GetRasterXSize(), interpolation_type) {}
+    : GeoRaster(data, 0, 0, data->GetRasterXSize(), data->GetRasterYSize(),
+                data->GetRasterXSize(), data->GetRasterYSize(), interpolation_type) {}
 
 GeoRaster::GeoRaster(GDALDataset *data, int pixel_offset_x, int pixel_offset_y,
                      int source_window_size_pixels, int destination_window_size_pixels,
                      int interpolation_type)
+    : GeoRaster(data, pixel_offset_x, pixel_offset_y, source_window_size_pixels,
+                source_window_size_pixels, destination_window_size_pixels,
+                destination_window_size_pixels, interpolation_type) {}
+
+GeoRaster::GeoRaster(GDALDataset *data, int pixel_offset_x, int pixel_offset_y,
+                     int source_window_width, int source_window_height, int destination_width,
+                     int destination_height, int interpolation_type)
     : data(data), pixel_offset_x(pixel_offset_x), pixel_offset_y(pixel_offset_y),
-      source_window_size_pixels(source_window_size_pixels),
-      destination_window_size_pixels(destination_window_size_pixels),
+      source_window_width(source_window_width), source_window_height(source_window_height),
+      destination_width(destination_width), destination_height(destination_height),
       interpolation_type(interpolation_type) {
     format = get_format_for_dataset(data);
 }
@@ -23,8 +23,9 @@ struct RasterIOHelper {
     ~RasterIOHelper();
 };
 
-// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+// Forward declaration of GDALDataset and GDALRasterBand from <gdal/gdal_priv.h>
 class GDALDataset;
+class GDALRasterBand;
 
 /// Wrapper for GDALDataset and its relevant functions.
 /// Provides easy access without GDAL dependencies to library users.
@@ -45,6 +46,12 @@ class GeoRaster {
               int source_window_size_pixels, int destination_window_size_pixels,
               int interpolation_type);
 
+    /// Construct a GeoRaster with a rectangular source window (in dataset pixels) which is
+    /// resampled to a rectangular destination image of destination_width * destination_height.
+    GeoRaster(GDALDataset *data, int pixel_offset_x, int pixel_offset_y, int source_window_width,
+              int source_window_height, int destination_width, int destination_height,
+              int interpolation_type);
+
     ~GeoRaster() = default;
 
     static FORMAT get_format_for_dataset(GDALDataset *data);
@@ -83,6 +90,33 @@ class GeoRaster {
 
     int get_pixel_size_y();
 
+    /// Returns the width of one pixel of this GeoRaster in meters, i.e. the distance between the
+    /// centers of horizontally adjacent pixels after resampling.
+    double get_pixel_size_meters_x();
+
+    /// Returns the height of one pixel of this GeoRaster in meters.
+    double get_pixel_size_meters_y();
+
+    /// Returns the projected x coordinate of the top left corner of this GeoRaster.
+    double get_top_left_x();
+
+    /// Returns the projected y coordinate of the top left corner of this GeoRaster.
+    double get_top_left_y();
+
+    /// Returns true if the band with the given index (starting at 1) defines a no-data value.
+    bool has_no_data_value(int band_index);
+
+    /// Returns the value which marks missing data in the band with the given index (starting at
+    /// 1), converted to float like the data of RF rasters. Only meaningful if has_no_data_value
+    /// is true; otherwise, this is GDAL's default, which RF pixels outside of the dataset get.
+    float get_no_data_value(int band_index);
+
+    /// Mark this GeoRaster as covering the given axis-aligned area in projected meters within a
+    /// dataset whose geotransform is rotated or not north-up. The pixel window then only serves as
+    /// the bounding box to read; every destination pixel is mapped back through the geotransform.
+    void set_world_window(double top_left_x, double top_left_y, double size_meters_x,
+                          double size_meters_y);
+
     /// Return a histogram in the format of ID -> number of occurrences.
     /// Only works with BYTE images!
     /// @RequiresManualDelete
@@ -103,15 +137,39 @@ class GeoRaster {
 
     int pixel_offset_y;
 
-    int source_window_size_pixels;
+    int source_window_width;
 
-    int destination_window_size_pixels;
+    int source_window_height;
+
+    int destination_width;
+
+    int destination_height;
 
     int interpolation_type;
 
+    bool resample_from_geotransform = false;
+
+    double world_top_left_x;
+
+    double world_top_left_y;
+
+    double world_size_x;
+
+    double world_size_y;
+
     /// Returns a RasterIOHelper with attributes needed for IO operations with native raster.
     /// Internal function to extract data from native raster.
     RasterIOHelper get_raster_io_helper();
+
+    /// Read the given band into the destination array, whose pixels are pixel_stride bytes apart.
+    /// data_type is the GDALDataType to read as. Returns true on success.
+    bool read_band_into(GDALRasterBand *band, uint8_t *array, int data_type, int pixel_stride,
+                        const RasterIOHelper &helper, int interpolation);
+
+    /// Like read_band_into, but for rasters with a rotated or flipped geotransform: the bounding
+    /// window is read once and each destination pixel is sampled from it via the geotransform.
+    bool read_band_resampled(GDALRasterBand *band, uint8_t *array, int data_type,
+                             int pixel_stride, const RasterIOHelper &helper, int interpolation);
 };
 
 #endif // RASTERTILEEXTRACTOR_GEORASTER_H
@@ -0,0 +1,262 @@
+#include "HeightfieldRaycaster.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using Vector = std::array<double, 3>;
+
+Vector subtract(const Vector &a, const Vector &b) {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+Vector cross(const Vector &a, const Vector &b) {
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+double dot(const Vector &a, const Vector &b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/// Möller-Trumbore ray-triangle intersection. Returns the distance along the ray, or a negative
+/// value if the triangle is missed.
+double intersect_triangle(const Vector &origin, const Vector &direction, const Vector &a,
+                          const Vector &b, const Vector &c) {
+    constexpr double EPSILON = 1e-12;
+
+    Vector edge_1 = subtract(b, a);
+    Vector edge_2 = subtract(c, a);
+
+    Vector p = cross(direction, edge_2);
+    double determinant = dot(edge_1, p);
+    if (std::abs(determinant) < EPSILON) { return -1.0; }
+
+    double inverse_determinant = 1.0 / determinant;
+    Vector to_origin = subtract(origin, a);
+
+    double u = dot(to_origin, p) * inverse_determinant;
+    if (u < 0.0 || u > 1.0) { return -1.0; }
+
+    Vector q = cross(to_origin, edge_1);
+    double v = dot(direction, q) * inverse_determinant;
+    if (v < 0.0 || u + v > 1.0) { return -1.0; }
+
+    return dot(edge_2, q) * inverse_determinant;
+}
+
+} // namespace
+
+HeightfieldRaycaster::HeightfieldRaycaster(const float *heights, int width, int height,
+                                           double top_left_x, double top_left_y,
+                                           double pixel_size_x, double pixel_size_y)
+    : heights(heights, heights + static_cast<size_t>(width) * height), width(width),
+      height(height), top_left_x(top_left_x), top_left_y(top_left_y), pixel_size_x(pixel_size_x),
+      pixel_size_y(pixel_size_y) {
+    ScopedTrace trace("HeightfieldRaycaster::build_pyramid");
+
+    // Without at least 2x2 pixels, there is no surface to hit
+    if (width < 2 || height < 2) { return; }
+
+    PyramidLevel cells{width - 1, height - 1};
+    cells.min_heights.resize(static_cast<size_t>(cells.width) * cells.height);
+    cells.max_heights.resize(cells.min_heights.size());
+
+    for (int y = 0; y < cells.height; y++) {
+        for (int x = 0; x < cells.width; x++) {
+            float corners[4] = {get_height(x, y), get_height(x + 1, y), get_height(x, y + 1),
+                                get_height(x + 1, y + 1)};
+
+            cells.min_heights[y * cells.width + x] = *std::min_element(corners, corners + 4);
+            cells.max_heights[y * cells.width + x] = *std::max_element(corners, corners + 4);
+        }
+    }
+
+    levels.emplace_back(std::move(cells));
+
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        const PyramidLevel &previous = levels.back();
+        PyramidLevel next{(previous.width + 1) / 2, (previous.height + 1) / 2};
+
+        next.min_heights.assign(static_cast<size_t>(next.width) * next.height,
+                                std::numeric_limits<float>::max());
+        next.max_heights.assign(next.min_heights.size(), std::numeric_limits<float>::lowest());
+
+        for (int y = 0; y < previous.height; y++) {
+            for (int x = 0; x < previous.width; x++) {
+                size_t index = (y / 2) * next.width + x / 2;
+
+                next.min_heights[index] =
+                    std::min(next.min_heights[index], previous.min_heights[y * previous.width + x]);
+                next.max_heights[index] =
+                    std::max(next.max_heights[index], previous.max_heights[y * previous.width + x]);
+            }
+        }
+
+        levels.emplace_back(std::move(next));
+    }
+}
+
+HeightfieldHit HeightfieldRaycaster::cast(const HeightfieldRay &ray, double max_distance) const {
+    HeightfieldHit hit;
+
+    double length = std::sqrt(ray.direction_x * ray.direction_x +
+                              ray.direction_y * ray.direction_y +
+                              ray.direction_z * ray.direction_z);
+
+    if (levels.empty() || length == 0.0) { return hit; }
+
+    // Transform the ray into grid space; distances along the ray stay the same
+    GridRay grid_ray{{(ray.origin_x - top_left_x) / pixel_size_x - 0.5,
+                      (top_left_y - ray.origin_y) / pixel_size_y - 0.5, ray.origin_z},
+                     {ray.direction_x / length / pixel_size_x,
+                      -ray.direction_y / length / pixel_size_y, ray.direction_z / length}};
+
+    for (int axis = 0; axis < 3; axis++) {
+        // Avoid infinities (and 0 * infinity) for rays parallel to an axis
+        double component = grid_ray.direction[axis];
+        if (std::abs(component) < 1e-12) { component = std::copysign(1e-12, component); }
+
+        grid_ray.inverse_direction[axis] = 1.0 / component;
+    }
+
+    int top_level = static_cast<int>(levels.size()) - 1;
+    double entry_distance;
+
+    if (intersect_node(grid_ray, top_level, 0, 0, max_distance, entry_distance)) {
+        traverse(grid_ray, top_level, 0, 0, max_distance, hit);
+    }
+
+    return hit;
+}
+
+std::vector<HeightfieldHit> HeightfieldRaycaster::cast_all(const std::vector<HeightfieldRay> &rays,
+                                                           double max_distance) const {
+    ScopedTrace trace("HeightfieldRaycaster::cast_all");
+
+    std::vector<HeightfieldHit> hits(rays.size());
+
+    parallel_for_bands(
+        static_cast<int>(rays.size()),
+        [&](int begin, int end) {
+            for (int index = begin; index < end; index++) {
+                hits[index] = cast(rays[index], max_distance);
+            }
+        },
+        64);
+
+    return hits;
+}
+
+void HeightfieldRaycaster::traverse(const GridRay &ray, int level, int x, int y,
+                                    double max_distance, HeightfieldHit &hit) const {
+    if (level == 0) {
+        intersect_cell(ray, x, y, max_distance, hit);
+        return;
+    }
+
+    // Visit the children which the ray passes through, closest first, and stop as soon as the
+    // next child is further away than a hit which was already found
+    std::array<std::pair<double, std::pair<int, int>>, 4> children;
+    int child_count = 0;
+
+    const PyramidLevel &child_level = levels[level - 1];
+
+    for (int child_y = y * 2; child_y < std::min(y * 2 + 2, child_level.height); child_y++) {
+        for (int child_x = x * 2; child_x < std::min(x * 2 + 2, child_level.width); child_x++) {
+            double limit = hit.is_hit ? std::min(hit.distance, max_distance) : max_distance;
+            double entry_distance;
+
+            if (intersect_node(ray, level - 1, child_x, child_y, limit, entry_distance)) {
+                children[child_count++] = {entry_distance, {child_x, child_y}};
+            }
+        }
+    }
+
+    std::sort(children.begin(), children.begin() + child_count);
+
+    for (int child = 0; child < child_count; child++) {
+        if (hit.is_hit && children[child].first > hit.distance) { break; }
+
+        traverse(ray, level - 1, children[child].second.first, children[child].second.second,
+                 max_distance, hit);
+    }
+}
+
+bool HeightfieldRaycaster::intersect_node(const GridRay &ray, int level, int x, int y,
+                                          double max_distance, double &entry_distance) const {
+    const PyramidLevel &pyramid_level = levels[level];
+    size_t index = static_cast<size_t>(y) * pyramid_level.width + x;
+
+    int node_size = 1 << level;
+
+    // Slab test against the box spanned by the node's cells and height range
+    double lower[3] = {static_cast<double>(x * node_size), static_cast<double>(y * node_size),
+                       pyramid_level.min_heights[index]};
+    double upper[3] = {static_cast<double>(std::min((x + 1) * node_size, width - 1)),
+                       static_cast<double>(std::min((y + 1) * node_size, height - 1)),
+                       pyramid_level.max_heights[index]};
+
+    double near_distance = 0.0;
+    double far_distance = max_distance;
+
+    for (int axis = 0; axis < 3; axis++) {
+        double distance_1 = (lower[axis] - ray.origin[axis]) * ray.inverse_direction[axis];
+        double distance_2 = (upper[axis] - ray.origin[axis]) * ray.inverse_direction[axis];
+
+        near_distance = std::max(near_distance, std::min(distance_1, distance_2));
+        far_distance = std::min(far_distance, std::max(distance_1, distance_2));
+
+        if (near_distance > far_distance) { return false; }
+    }
+
+    entry_distance = near_distance;
+    return true;
+}
+
+void HeightfieldRaycaster::intersect_cell(const GridRay &ray, int x, int y, double max_distance,
+                                          HeightfieldHit &hit) const {
+    Vector origin = {ray.origin[0], ray.origin[1], ray.origin[2]};
+    Vector direction = {ray.direction[0], ray.direction[1], ray.direction[2]};
+
+    Vector top_left = {double(x), double(y), get_height(x, y)};
+    Vector top_right = {double(x + 1), double(y), get_height(x + 1, y)};
+    Vector bottom_left = {double(x), double(y + 1), get_height(x, y + 1)};
+    Vector bottom_right = {double(x + 1), double(y + 1), get_height(x + 1, y + 1)};
+
+    std::array<std::array<Vector, 3>, 2> triangles = {{{top_left, top_right, bottom_right},
+                                                       {top_left, bottom_right, bottom_left}}};
+
+    for (const std::array<Vector, 3> &triangle : triangles) {
+        double distance = intersect_triangle(origin, direction, triangle[0], triangle[1],
+                                             triangle[2]);
+
+        // The cell may be entered before max_distance and still be hit beyond it
+        if (distance < 0.0 || distance > max_distance) { continue; }
+        if (hit.is_hit && distance >= hit.distance) { continue; }
+
+        hit.is_hit = true;
+        hit.distance = distance;
+
+        // Back from grid space into projected meters
+        hit.x = top_left_x + (origin[0] + direction[0] * distance + 0.5) * pixel_size_x;
+        hit.y = top_left_y - (origin[1] + direction[1] * distance + 0.5) * pixel_size_y;
+        hit.z = origin[2] + direction[2] * distance;
+
+        Vector edge_1 = subtract(triangle[1], triangle[0]);
+        Vector edge_2 = subtract(triangle[2], triangle[0]);
+        Vector normal = cross({edge_1[0] * pixel_size_x, -edge_1[1] * pixel_size_y, edge_1[2]},
+                              {edge_2[0] * pixel_size_x, -edge_2[1] * pixel_size_y, edge_2[2]});
+
+        double normal_length = std::sqrt(dot(normal, normal));
+        if (normal[2] < 0.0) { normal_length = -normal_length; }
+
+        hit.normal_x = normal[0] / normal_length;
+        hit.normal_y = normal[1] / normal_length;
+        hit.normal_z = normal[2] / normal_length;
+    }
+}
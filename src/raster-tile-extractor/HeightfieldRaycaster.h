@@ -0,0 +1,99 @@
+#ifndef RASTEREXTRACTOR_HEIGHTFIELDRAYCASTER_H
+#define RASTEREXTRACTOR_HEIGHTFIELDRAYCASTER_H
+
+#include "defines.h"
+
+#include <cstddef>
+#include <vector>
+
+/// A ray in projected meters: x is the easting, y the northing and z the height.
+struct HeightfieldRay {
+    double origin_x;
+    double origin_y;
+    double origin_z;
+
+    double direction_x;
+    double direction_y;
+    double direction_z;
+};
+
+struct HeightfieldHit {
+    bool is_hit = false;
+
+    /// Distance along the (normalized) ray
+    double distance;
+
+    double x;
+    double y;
+    double z;
+
+    /// Surface normal at the hit position, pointing upwards
+    double normal_x;
+    double normal_y;
+    double normal_z;
+};
+
+/// Intersects rays with a decoded heightmap without any physics engine.
+/// The surface is made up of two triangles between each 2x2 group of pixel centers, just like a
+/// terrain mesh built from the heightmap with regular quads. A pyramid of the minimum and maximum
+/// heights in increasingly large areas lets rays skip over everything they pass above or below.
+class HeightfieldRaycaster {
+  public:
+    /// Builds the height pyramid for the given row-major heights, starting at the north-west
+    /// corner top_left_x, top_left_y (in projected meters). The heights are copied.
+    HeightfieldRaycaster(const float *heights, int width, int height, double top_left_x,
+                         double top_left_y, double pixel_size_x, double pixel_size_y);
+
+    /// Returns the closest intersection of the ray within max_distance meters of its origin.
+    HeightfieldHit cast(const HeightfieldRay &ray, double max_distance) const;
+
+    /// Casts all rays on multiple threads.
+    std::vector<HeightfieldHit> cast_all(const std::vector<HeightfieldRay> &rays,
+                                         double max_distance) const;
+
+  private:
+    /// A ray in grid space, where (u, v) = (0, 0) is the center of the top left pixel and
+    /// (1, 1) the center of the pixel diagonally below it
+    struct GridRay {
+        double origin[3];
+        double direction[3];
+        double inverse_direction[3];
+    };
+
+    struct PyramidLevel {
+        int width;
+        int height;
+        std::vector<float> min_heights;
+        std::vector<float> max_heights;
+    };
+
+    void traverse(const GridRay &ray, int level, int x, int y, double max_distance,
+                  HeightfieldHit &hit) const;
+
+    /// Returns true and the entry distance if the ray enters the area of the given pyramid node
+    /// before max_distance.
+    bool intersect_node(const GridRay &ray, int level, int x, int y, double max_distance,
+                        double &entry_distance) const;
+
+    /// Updates the hit if the ray intersects the cell's triangles closer than the current hit and
+    /// within max_distance.
+    void intersect_cell(const GridRay &ray, int x, int y, double max_distance,
+                        HeightfieldHit &hit) const;
+
+    float get_height(int x, int y) const { return heights[static_cast<size_t>(y) * width + x]; }
+
+    std::vector<float> heights;
+    int width;
+    int height;
+
+    double top_left_x;
+    double top_left_y;
+    double pixel_size_x;
+    double pixel_size_y;
+
+    /// levels[0] contains one entry per cell between four pixel centers, every following level
+    /// combines 2x2 entries of the previous one until a single entry is left
+    std::vector<PyramidLevel> levels;
+};
+
+#endif // RASTEREXTRACTOR_HEIGHTFIELDRAYCASTER_H
@@ -0,0 +1,85 @@
+#include "HeightmapWindow.h"
+#include "GeoRaster.h"
+#include "RasterTileExtractor.h"
+
+#include <algorithm>
+#include <cmath>
+
+HeightmapWindow::HeightmapWindow(GDALDataset *dataset, double top_left_x, double top_left_y,
+                                 double size_meters_x, double size_meters_y, int max_size_pixels)
+    : top_left_x(top_left_x), top_left_y(top_left_y) {
+    double dataset_pixel_size = RasterTileExtractor::get_pixel_size(dataset);
+
+    width = std::clamp(static_cast<int>(ceil(size_meters_x / dataset_pixel_size)), 1,
+                       max_size_pixels);
+    height = std::clamp(static_cast<int>(ceil(size_meters_y / dataset_pixel_size)), 1,
+                        max_size_pixels);
+
+    read(dataset, size_meters_x, size_meters_y, 1);
+}
+
+HeightmapWindow::HeightmapWindow(GDALDataset *dataset, double top_left_x, double top_left_y,
+                                 double size_meters_x, double size_meters_y, int width,
+                                 int height, int interpolation_type)
+    : width(width), height(height), top_left_x(top_left_x), top_left_y(top_left_y) {
+    read(dataset, size_meters_x, size_meters_y, interpolation_type);
+}
+
+void HeightmapWindow::read(GDALDataset *dataset, double size_meters_x, double size_meters_y,
+                           int interpolation_type) {
+    pixel_size_x = size_meters_x / width;
+    pixel_size_y = size_meters_y / height;
+
+    GeoRaster *raster = RasterTileExtractor::get_tile_from_dataset(
+        dataset, top_left_x, top_left_y, size_meters_x, size_meters_y, width, height,
+        interpolation_type);
+
+    if (raster == nullptr) { return; }
+
+    size_t pixel_count = static_cast<size_t>(width) * height;
+    GeoRaster::FORMAT format = raster->get_band_format(1);
+
+    if (format == GeoRaster::RF) {
+        float *data = static_cast<float *>(raster->get_band_as_array(1));
+
+        if (data != nullptr) {
+            heights.assign(data, data + pixel_count);
+            delete[] data;
+        }
+    } else if (format == GeoRaster::BYTE) {
+        uint8_t *data = static_cast<uint8_t *>(raster->get_band_as_array(1));
+
+        if (data != nullptr) {
+            heights.assign(data, data + pixel_count);
+            delete[] data;
+        }
+    }
+
+    delete raster;
+}
+
+float HeightmapWindow::get(int x, int y) const {
+    x = std::clamp(x, 0, width - 1);
+    y = std::clamp(y, 0, height - 1);
+
+    return heights[static_cast<size_t>(y) * width + x];
+}
+
+float HeightmapWindow::sample(double pos_x, double pos_y) const {
+    // Pixel values are located at the centers of the pixels
+    double pixel_x = (pos_x - top_left_x) / pixel_size_x - 0.5;
+    double pixel_y = (top_left_y - pos_y) / pixel_size_y - 0.5;
+
+    pixel_x = std::clamp(pixel_x, 0.0, width - 1.0);
+    pixel_y = std::clamp(pixel_y, 0.0, height - 1.0);
+
+    int x = static_cast<int>(pixel_x);
+    int y = static_cast<int>(pixel_y);
+    float fraction_x = pixel_x - x;
+    float fraction_y = pixel_y - y;
+
+    float top = get(x, y) * (1.0f - fraction_x) + get(x + 1, y) * fraction_x;
+    float bottom = get(x, y + 1) * (1.0f - fraction_x) + get(x + 1, y + 1) * fraction_x;
+
+    return top * (1.0f - fraction_y) + bottom * fraction_y;
+}
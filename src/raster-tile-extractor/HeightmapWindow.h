@@ -0,0 +1,55 @@
+#ifndef RASTEREXTRACTOR_HEIGHTMAPWINDOW_H
+#define RASTEREXTRACTOR_HEIGHTMAPWINDOW_H
+
+#include "defines.h"
+
+#include <vector>
+
+// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+class GDALDataset;
+
+/// A rectangular area of the first band of a dataset, decoded into floats in one read so that
+/// many height queries within that area don't have to go through GDAL.
+/// Pixels are row-major, starting at the top left (north-west) corner.
+class HeightmapWindow {
+  public:
+    /// Reads the area starting at top_left_x, top_left_y (in projected meters) with the given size.
+    /// The resolution is that of the dataset, unless the window would be larger than
+    /// max_size_pixels in either direction, in which case it is reduced accordingly.
+    HeightmapWindow(GDALDataset *dataset, double top_left_x, double top_left_y,
+                    double size_meters_x, double size_meters_y, int max_size_pixels);
+
+    /// Reads the area with exactly the given number of pixels. Nearest neighbour interpolation (0)
+    /// can be used for data which must not be blended, such as classifications.
+    HeightmapWindow(GDALDataset *dataset, double top_left_x, double top_left_y,
+                    double size_meters_x, double size_meters_y, int width, int height,
+                    int interpolation_type = 1);
+
+    /// Returns false if the data could not be read.
+    bool is_valid() const { return !heights.empty(); }
+
+    /// Returns the bilinearly interpolated height at the given position in projected meters.
+    /// Positions outside of the window are clamped to its edge.
+    float sample(double pos_x, double pos_y) const;
+
+    /// Returns the height of the pixel at the given column and row, clamped to the window.
+    float get(int x, int y) const;
+
+    int width = 0;
+    int height = 0;
+
+    double top_left_x;
+    double top_left_y;
+
+    /// Size of a pixel in meters
+    double pixel_size_x;
+    double pixel_size_y;
+
+    std::vector<float> heights;
+
+  private:
+    void read(GDALDataset *dataset, double size_meters_x, double size_meters_y,
+              int interpolation_type);
+};
+
+#endif // RASTEREXTRACTOR_HEIGHTMAPWINDOW_H
@@ -0,0 +1,221 @@
+#include "Polygonizer.h"
+#include "HeightmapWindow.h"
+#include "gdal-includes.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace {
+
+/// Tiles are not made smaller than this number of rows
+constexpr int MIN_TILE_ROWS = 128;
+
+/// A polygon in pixel coordinates of the whole area
+struct TilePolygon {
+    double value;
+    std::unique_ptr<OGRGeometry> geometry;
+
+    /// True if the polygon reaches the edge of its tile towards another tile, in which case it may
+    /// have to be merged with polygons in that tile
+    bool is_on_seam;
+};
+
+/// Polygonizes the rows from row_begin to row_end. In order for the coordinates at the seams of
+/// neighbouring tiles to be exactly equal, the polygons are created in pixel coordinates of the
+/// whole area.
+std::vector<TilePolygon> polygonize_tile(const HeightmapWindow &window, int row_begin,
+                                         int row_end, bool has_no_data, double no_data) {
+    std::vector<TilePolygon> polygons;
+    int rows = row_end - row_begin;
+
+    GDALDriver *raster_driver = (GDALDriver *)GDALGetDriverByName("MEM");
+    GDALDataset *tile = raster_driver->Create("", window.width, rows, 1, GDT_Float32, nullptr);
+
+    double transform[6] = {0.0, 1.0, 0.0, static_cast<double>(row_begin), 0.0, 1.0};
+    tile->SetGeoTransform(transform);
+
+    GDALRasterBand *band = tile->GetRasterBand(1);
+    if (has_no_data) { band->SetNoDataValue(no_data); }
+
+    float *tile_values = const_cast<float *>(window.heights.data()) +
+                         static_cast<size_t>(row_begin) * window.width;
+    CPLErr error = band->RasterIO(GF_Write, 0, 0, window.width, rows, tile_values, window.width,
+                                  rows, GDT_Float32, 0, 0);
+
+    GDALDriver *vector_driver = (GDALDriver *)GDALGetDriverByName("Memory");
+    GDALDataset *vector_dataset = vector_driver->Create("", 0, 0, 0, GDT_Unknown, nullptr);
+    OGRLayer *layer = vector_dataset->CreateLayer("polygons", nullptr, wkbPolygon);
+
+    OGRFieldDefn field_definition("value", OFTReal);
+    layer->CreateField(&field_definition);
+
+    if (error == CE_None) {
+        GDALRasterBandH mask = has_no_data ? (GDALRasterBandH)band->GetMaskBand() : nullptr;
+
+        GDALFPolygonize((GDALRasterBandH)band, mask, (OGRLayerH)layer, 0, nullptr, nullptr,
+                        nullptr);
+    }
+
+    layer->ResetReading();
+    OGRFeature *feature = layer->GetNextFeature();
+
+    while (feature != nullptr) {
+        std::unique_ptr<OGRGeometry> geometry(feature->StealGeometry());
+
+        if (geometry != nullptr) {
+            OGREnvelope envelope;
+            geometry->getEnvelope(&envelope);
+
+            bool is_on_seam = (row_begin > 0 && envelope.MinY <= row_begin) ||
+                              (row_end < window.height && envelope.MaxY >= row_end);
+
+            polygons.push_back({feature->GetFieldAsDouble(0), std::move(geometry), is_on_seam});
+        }
+
+        OGRFeature::DestroyFeature(feature);
+        feature = layer->GetNextFeature();
+    }
+
+    GDALClose(vector_dataset);
+    GDALClose(tile);
+
+    return polygons;
+}
+
+/// Appends the polygon or the parts of the multi-polygon to the result
+void add_polygons(const OGRGeometry *geometry, double value,
+                  std::vector<TilePolygon> &polygons) {
+    if (geometry == nullptr || geometry->IsEmpty()) { return; }
+
+    OGRwkbGeometryType type = wkbFlatten(geometry->getGeometryType());
+
+    if (type == wkbPolygon) {
+        polygons.push_back({value, std::unique_ptr<OGRGeometry>(geometry->clone()), false});
+    } else if (type == wkbMultiPolygon || type == wkbGeometryCollection) {
+        const OGRGeometryCollection *collection = geometry->toGeometryCollection();
+
+        for (int i = 0; i < collection->getNumGeometries(); i++) {
+            add_polygons(collection->getGeometryRef(i), value, polygons);
+        }
+    }
+}
+
+/// Converts the ring from pixel coordinates to projected meters
+std::vector<double> get_ring_points(const OGRLinearRing *ring, const HeightmapWindow &window) {
+    std::vector<double> points;
+    points.reserve(ring->getNumPoints() * 2);
+
+    for (int i = 0; i < ring->getNumPoints(); i++) {
+        points.push_back(window.top_left_x + ring->getX(i) * window.pixel_size_x);
+        points.push_back(window.top_left_y - ring->getY(i) * window.pixel_size_y);
+    }
+
+    return points;
+}
+
+} // namespace
+
+std::vector<ClassPolygon> Polygonizer::polygonize(GDALDataset *dataset, double top_left_x,
+                                                  double top_left_y, double size_meters,
+                                                  int img_size, double simplify_tolerance) {
+    ScopedTrace trace("Polygonizer::polygonize");
+
+    std::vector<ClassPolygon> result;
+
+    HeightmapWindow window(dataset, top_left_x, top_left_y, size_meters, size_meters, img_size,
+                           img_size, 0);
+
+    if (!window.is_valid()) { return result; }
+
+    int has_no_data = false;
+    double no_data = dataset->GetRasterBand(1)->GetNoDataValue(&has_no_data);
+
+    // Polygonize tiles of rows on separate threads
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    int tile_count = std::clamp(window.height / MIN_TILE_ROWS, 1, max_threads);
+    int tile_rows = (window.height + tile_count - 1) / tile_count;
+
+    std::vector<std::vector<TilePolygon>> tiles(tile_count);
+
+    parallel_for_bands(
+        tile_count,
+        [&](int begin, int end) {
+            for (int tile = begin; tile < end; tile++) {
+                tiles[tile] = polygonize_tile(window, tile * tile_rows,
+                                              std::min((tile + 1) * tile_rows, window.height),
+                                              has_no_data, no_data);
+            }
+        },
+        1);
+
+    // Polygons on seams are merged with all other polygons of the same value on seams. Parts
+    // which don't touch each other remain separate polygons.
+    std::vector<TilePolygon> polygons;
+    std::map<double, std::unique_ptr<OGRMultiPolygon>> seam_polygons;
+
+    for (std::vector<TilePolygon> &tile : tiles) {
+        for (TilePolygon &polygon : tile) {
+            if (!polygon.is_on_seam) {
+                polygons.emplace_back(std::move(polygon));
+                continue;
+            }
+
+            std::unique_ptr<OGRMultiPolygon> &merged = seam_polygons[polygon.value];
+            if (merged == nullptr) { merged = std::make_unique<OGRMultiPolygon>(); }
+
+            merged->addGeometryDirectly(polygon.geometry.release());
+        }
+    }
+
+    {
+        ScopedTrace merge_trace("Polygonizer::merge_seams");
+
+        for (const auto &entry : seam_polygons) {
+            std::unique_ptr<OGRGeometry> merged(entry.second->UnionCascaded());
+            add_polygons(merged.get(), entry.first, polygons);
+        }
+    }
+
+    // Simplify in pixel coordinates, where the tolerance is given in pixels
+    if (simplify_tolerance > 0.0) {
+        ScopedTrace simplify_trace("Polygonizer::simplify");
+
+        double pixel_tolerance = simplify_tolerance / window.pixel_size_x;
+
+        parallel_for_bands(
+            static_cast<int>(polygons.size()),
+            [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    polygons[i].geometry.reset(
+                        polygons[i].geometry->SimplifyPreserveTopology(pixel_tolerance));
+                }
+            },
+            64);
+    }
+
+    result.reserve(polygons.size());
+
+    for (const TilePolygon &tile_polygon : polygons) {
+        if (tile_polygon.geometry == nullptr || tile_polygon.geometry->IsEmpty() ||
+            wkbFlatten(tile_polygon.geometry->getGeometryType()) != wkbPolygon) {
+            continue;
+        }
+
+        const OGRPolygon *polygon = tile_polygon.geometry->toPolygon();
+        ClassPolygon class_polygon{tile_polygon.value, {}};
+
+        class_polygon.rings.emplace_back(get_ring_points(polygon->getExteriorRing(), window));
+
+        for (int i = 0; i < polygon->getNumInteriorRings(); i++) {
+            class_polygon.rings.emplace_back(get_ring_points(polygon->getInteriorRing(i), window));
+        }
+
+        result.emplace_back(std::move(class_polygon));
+    }
+
+    return result;
+}
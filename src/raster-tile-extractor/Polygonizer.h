@@ -0,0 +1,36 @@
+#ifndef RASTEREXTRACTOR_POLYGONIZER_H
+#define RASTEREXTRACTOR_POLYGONIZER_H
+
+#include "defines.h"
+
+#include <vector>
+
+// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+class GDALDataset;
+
+/// A connected area of pixels with the same value in a classified raster.
+struct ClassPolygon {
+    double value;
+
+    /// The outer ring followed by the rings of any holes, each as consecutive x, y pairs in
+    /// projected meters and closed (the last point equals the first one).
+    std::vector<std::vector<double>> rings;
+};
+
+/// Conversion of classified rasters (e.g. land use) into polygons, as known from gdal_polygonize.
+class Polygonizer {
+  public:
+    /// Returns the polygons of equal values in the first band of the given square area, read at
+    /// img_size * img_size pixels with nearest neighbour interpolation. No-data pixels are left
+    /// out. The area is split into tiles which are polygonized on separate threads; polygons
+    /// continuing across tiles are merged afterwards.
+    /// If simplify_tolerance (in meters) is larger than 0, the polygons are simplified so that
+    /// they deviate at most by that distance from the pixel outlines, which greatly reduces their
+    /// vertex count. Each polygon keeps a valid topology, but small gaps or overlaps between
+    /// neighbouring polygons are possible.
+    static std::vector<ClassPolygon> polygonize(GDALDataset *dataset, double top_left_x,
+                                                double top_left_y, double size_meters,
+                                                int img_size, double simplify_tolerance);
+};
+
+#endif // RASTEREXTRACTOR_POLYGONIZER_H
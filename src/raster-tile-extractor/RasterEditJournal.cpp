@@ -0,0 +1,302 @@
+#include "RasterEditJournal.h"
+#include "GeoRaster.h"
+#include "gdal-includes.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Journal tile size for datasets whose blocks are strips rather than tiles
+constexpr int DEFAULT_TILE_SIZE = 256;
+
+/// Tiles larger than this in either direction are split up to keep deltas small
+constexpr int MAX_TILE_SIZE = 1024;
+
+} // namespace
+
+RasterEditJournal::RasterEditJournal(GDALDataset *dataset) : dataset(dataset) {
+    // Align journal tiles with the dataset's blocks so that reading them only touches whole blocks
+    int block_width, block_height;
+    dataset->GetRasterBand(1)->GetBlockSize(&block_width, &block_height);
+
+    if (block_height <= 1 || block_width > MAX_TILE_SIZE || block_height > MAX_TILE_SIZE) {
+        tile_width = DEFAULT_TILE_SIZE;
+        tile_height = DEFAULT_TILE_SIZE;
+    } else {
+        tile_width = block_width;
+        tile_height = block_height;
+    }
+
+    double transform[6];
+    has_transform = dataset->GetGeoTransform(transform) == CE_None &&
+                    GDALInvGeoTransform(transform, inverse_transform);
+}
+
+void RasterEditJournal::begin_operation() {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    operation_depth++;
+}
+
+void RasterEditJournal::end_operation() {
+    ScopedTrace trace("RasterEditJournal::end_operation");
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    if (operation_depth == 0) { return; }
+
+    operation_depth--;
+    if (operation_depth > 0 || pending_tiles.empty()) { return; }
+
+    Operation operation;
+    operation.reserve(pending_tiles.size());
+
+    for (const auto &[tile, before] : pending_tiles) {
+        operation.emplace_back(create_delta(tile, before, read_tile(tile)));
+    }
+
+    pending_tiles.clear();
+
+    undo_history.emplace_back(std::move(operation));
+    redo_history.clear();
+}
+
+void RasterEditJournal::record_position(double pos_x, double pos_y) {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    if (operation_depth == 0 || !has_transform) { return; }
+
+    double pixel_x, pixel_y;
+    GDALApplyGeoTransform(inverse_transform, pos_x, pos_y, &pixel_x, &pixel_y);
+
+    if (pixel_x < 0.0 || pixel_y < 0.0 || pixel_x >= dataset->GetRasterXSize() ||
+        pixel_y >= dataset->GetRasterYSize()) {
+        return;
+    }
+
+    TileIndex tile(static_cast<int>(pixel_x) / tile_width, static_cast<int>(pixel_y) / tile_height);
+
+    if (pending_tiles.find(tile) == pending_tiles.end()) {
+        pending_tiles.emplace(tile, read_tile(tile));
+    }
+}
+
+bool RasterEditJournal::undo() {
+    ScopedTrace trace("RasterEditJournal::undo");
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    if (undo_history.empty() || operation_depth > 0) { return false; }
+
+    apply(undo_history.back(), false);
+
+    redo_history.emplace_back(std::move(undo_history.back()));
+    undo_history.pop_back();
+
+    return true;
+}
+
+bool RasterEditJournal::redo() {
+    ScopedTrace trace("RasterEditJournal::redo");
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    if (redo_history.empty() || operation_depth > 0) { return false; }
+
+    apply(redo_history.back(), true);
+
+    undo_history.emplace_back(std::move(redo_history.back()));
+    redo_history.pop_back();
+
+    return true;
+}
+
+void RasterEditJournal::squash(int operation_count) {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    int history_size = static_cast<int>(undo_history.size());
+    if (operation_count <= 0 || operation_count > history_size) { operation_count = history_size; }
+    if (operation_count < 2) { return; }
+
+    // For every tile, keep the data before the oldest and after the newest of the operations
+    std::map<TileIndex, std::pair<std::vector<uint8_t>, std::vector<uint8_t>>> tiles;
+
+    for (int index = history_size - operation_count; index < history_size; index++) {
+        for (const TileDelta &delta : undo_history[index]) {
+            std::vector<uint8_t> before = decompress(delta.before, delta.raw_size);
+            std::vector<uint8_t> after = decompress(delta.difference, delta.raw_size);
+
+            for (size_t byte = 0; byte < after.size(); byte++) {
+                after[byte] ^= before[byte];
+            }
+
+            auto existing = tiles.find(delta.tile);
+            if (existing == tiles.end()) {
+                tiles.emplace(delta.tile, std::make_pair(std::move(before), std::move(after)));
+            } else {
+                existing->second.second = std::move(after);
+            }
+        }
+    }
+
+    undo_history.resize(history_size - operation_count);
+
+    Operation squashed;
+    squashed.reserve(tiles.size());
+
+    for (const auto &[tile, data] : tiles) {
+        squashed.emplace_back(create_delta(tile, data.first, data.second));
+    }
+
+    undo_history.emplace_back(std::move(squashed));
+}
+
+void RasterEditJournal::clear() {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    undo_history.clear();
+    redo_history.clear();
+}
+
+int RasterEditJournal::get_undo_count() {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    return undo_history.size();
+}
+
+int RasterEditJournal::get_redo_count() {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    return redo_history.size();
+}
+
+size_t RasterEditJournal::get_memory_usage() {
+    std::lock_guard<std::mutex> lock(journal_mutex);
+
+    size_t bytes = 0;
+
+    for (const std::vector<Operation> *history : {&undo_history, &redo_history}) {
+        for (const Operation &operation : *history) {
+            for (const TileDelta &delta : operation) {
+                bytes += delta.before.size() + delta.difference.size();
+            }
+        }
+    }
+
+    for (const auto &[tile, data] : pending_tiles) {
+        bytes += data.size();
+    }
+
+    return bytes;
+}
+
+std::vector<uint8_t> RasterEditJournal::read_tile(const TileIndex &tile) {
+    int offset_x = tile.first * tile_width;
+    int offset_y = tile.second * tile_height;
+    int width = std::min(tile_width, dataset->GetRasterXSize() - offset_x);
+    int height = std::min(tile_height, dataset->GetRasterYSize() - offset_y);
+
+    std::vector<uint8_t> data;
+
+    RasterIOHelper helper;
+
+    for (int band_number = 1; band_number <= dataset->GetRasterCount(); band_number++) {
+        GDALRasterBand *band = dataset->GetRasterBand(band_number);
+        GDALDataType type = band->GetRasterDataType();
+
+        size_t offset = data.size();
+        data.resize(offset + static_cast<size_t>(width) * height * GDALGetDataTypeSizeBytes(type));
+
+        CPLErr error = band->RasterIO(GF_Read, offset_x, offset_y, width, height,
+                                      data.data() + offset, width, height, type, 0, 0);
+
+        // Unreadable data can't be restored anyway, so it is recorded as zeroes
+        if (error >= CE_Failure) {
+            std::fill(data.begin() + offset, data.end(), 0);
+        }
+    }
+
+    return data;
+}
+
+void RasterEditJournal::write_tile(const TileIndex &tile, const std::vector<uint8_t> &data) {
+    int offset_x = tile.first * tile_width;
+    int offset_y = tile.second * tile_height;
+    int width = std::min(tile_width, dataset->GetRasterXSize() - offset_x);
+    int height = std::min(tile_height, dataset->GetRasterYSize() - offset_y);
+
+    size_t offset = 0;
+
+    RasterIOHelper helper;
+
+    for (int band_number = 1; band_number <= dataset->GetRasterCount(); band_number++) {
+        GDALRasterBand *band = dataset->GetRasterBand(band_number);
+        GDALDataType type = band->GetRasterDataType();
+
+        band->RasterIO(GF_Write, offset_x, offset_y, width, height,
+                       const_cast<uint8_t *>(data.data()) + offset, width, height, type, 0, 0);
+
+        offset += static_cast<size_t>(width) * height * GDALGetDataTypeSizeBytes(type);
+    }
+}
+
+void RasterEditJournal::apply(const Operation &operation, bool after) {
+    for (const TileDelta &delta : operation) {
+        std::vector<uint8_t> data = decompress(delta.before, delta.raw_size);
+
+        if (after) {
+            std::vector<uint8_t> difference = decompress(delta.difference, delta.raw_size);
+
+            for (size_t byte = 0; byte < data.size(); byte++) {
+                data[byte] ^= difference[byte];
+            }
+        }
+
+        write_tile(delta.tile, data);
+    }
+
+    dataset->FlushCache();
+}
+
+RasterEditJournal::TileDelta RasterEditJournal::create_delta(const TileIndex &tile,
+                                                             const std::vector<uint8_t> &before,
+                                                             const std::vector<uint8_t> &after) {
+    // The XOR of unchanged bytes is 0, so the difference compresses very well
+    std::vector<uint8_t> difference(before.size());
+    for (size_t byte = 0; byte < before.size(); byte++) {
+        difference[byte] = before[byte] ^ after[byte];
+    }
+
+    return TileDelta{tile, before.size(), compress(before), compress(difference)};
+}
+
+std::vector<uint8_t> RasterEditJournal::compress(const std::vector<uint8_t> &data) {
+    size_t compressed_size = 0;
+    void *compressed = CPLZLibDeflate(data.data(), data.size(), 1, nullptr, 0, &compressed_size);
+
+    // Fall back to storing the data uncompressed, which decompress recognizes by its size
+    if (compressed == nullptr || compressed_size >= data.size()) {
+        VSIFree(compressed);
+        return data;
+    }
+
+    std::vector<uint8_t> result(static_cast<uint8_t *>(compressed),
+                                static_cast<uint8_t *>(compressed) + compressed_size);
+    VSIFree(compressed);
+
+    return result;
+}
+
+std::vector<uint8_t> RasterEditJournal::decompress(const std::vector<uint8_t> &data,
+                                                   size_t raw_size) {
+    if (data.size() == raw_size) { return data; }
+
+    std::vector<uint8_t> result(raw_size);
+    size_t decompressed_size = 0;
+
+    if (CPLZLibInflate(data.data(), data.size(), result.data(), raw_size, &decompressed_size) ==
+        nullptr) {
+        std::fill(result.begin(), result.end(), 0);
+    }
+
+    return result;
+}
@@ -0,0 +1,111 @@
+#ifndef RASTEREXTRACTOR_RASTEREDITJOURNAL_H
+#define RASTEREXTRACTOR_RASTEREDITJOURNAL_H
+
+#include "defines.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+class GDALDataset;
+
+/// Records edits of a raster dataset so that they can be undone and redone.
+/// Edits are grouped into operations (e.g. one brush stroke). For every tile of the dataset which
+/// an operation touches, the journal stores the tile's data before the operation and the
+/// difference to its data afterwards, both compressed. Memory usage is therefore proportional to
+/// the edited area rather than to the size of the dataset, and mostly-unchanged tiles compress to
+/// almost nothing.
+class RasterEditJournal {
+  public:
+    explicit RasterEditJournal(GDALDataset *dataset);
+
+    /// Starts an operation. Operations can be nested; only the outermost one is recorded, so that
+    /// e.g. all pixels written by one brush stroke are undone together.
+    void begin_operation();
+
+    /// Ends an operation. When the outermost operation ends, the affected tiles are compressed
+    /// into a new entry of the undo history and the redo history is cleared.
+    void end_operation();
+
+    /// Must be called before the pixel at the given position (in projected meters) is modified
+    /// within an operation, so that the original data of its tile can be preserved.
+    void record_position(double pos_x, double pos_y);
+
+    /// Restores the dataset to its state before the latest recorded operation.
+    /// Returns false if there is nothing to undo.
+    bool undo();
+
+    /// Re-applies the latest undone operation. Returns false if there is nothing to redo.
+    bool redo();
+
+    /// Merges the latest operation_count operations of the undo history into a single one.
+    /// A value of 0 or less merges the entire history.
+    void squash(int operation_count);
+
+    /// Discards the entire undo and redo history.
+    void clear();
+
+    int get_undo_count();
+
+    int get_redo_count();
+
+    /// Returns the number of bytes used by the recorded history.
+    size_t get_memory_usage();
+
+  private:
+    using TileIndex = std::pair<int, int>;
+
+    struct TileDelta {
+        TileIndex tile;
+
+        /// Size of the uncompressed tile data in bytes
+        size_t raw_size;
+
+        /// Compressed data of the tile before the operation
+        std::vector<uint8_t> before;
+
+        /// Compressed XOR of the data before and after the operation
+        std::vector<uint8_t> difference;
+    };
+
+    using Operation = std::vector<TileDelta>;
+
+    /// Reads all bands of the given tile in their native data types, one band after the other.
+    std::vector<uint8_t> read_tile(const TileIndex &tile);
+
+    void write_tile(const TileIndex &tile, const std::vector<uint8_t> &data);
+
+    /// Writes the data of each tile in the operation either before or after the operation.
+    void apply(const Operation &operation, bool after);
+
+    static TileDelta create_delta(const TileIndex &tile, const std::vector<uint8_t> &before,
+                                  const std::vector<uint8_t> &after);
+
+    static std::vector<uint8_t> compress(const std::vector<uint8_t> &data);
+
+    static std::vector<uint8_t> decompress(const std::vector<uint8_t> &data, size_t raw_size);
+
+    GDALDataset *dataset;
+
+    int tile_width;
+    int tile_height;
+
+    bool has_transform;
+    double inverse_transform[6];
+
+    std::mutex journal_mutex;
+
+    int operation_depth = 0;
+
+    /// Uncompressed data of the tiles touched by the current operation before they were modified
+    std::map<TileIndex, std::vector<uint8_t>> pending_tiles;
+
+    std::vector<Operation> undo_history;
+    std::vector<Operation> redo_history;
+};
+
+#endif // RASTEREXTRACTOR_RASTEREDITJOURNAL_H
@@ -0,0 +1,167 @@
+#include "RasterSampler.h"
+#include "GeoRaster.h"
+#include "gdal-includes.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// Tile size for datasets whose blocks are strips rather than tiles
+constexpr int DEFAULT_TILE_SIZE = 256;
+
+/// Larger blocks are split up so that a few samples don't read large amounts of data
+constexpr int MAX_TILE_SIZE = 1024;
+
+} // namespace
+
+RasterSampler::RasterSampler(GDALDataset *dataset)
+    : dataset(dataset), width(dataset->GetRasterXSize()), height(dataset->GetRasterYSize()) {
+    GDALRasterBand *band = dataset->GetRasterBand(1);
+
+    int block_width, block_height;
+    band->GetBlockSize(&block_width, &block_height);
+
+    if (block_height <= 1 || block_width > MAX_TILE_SIZE || block_height > MAX_TILE_SIZE) {
+        tile_width = DEFAULT_TILE_SIZE;
+        tile_height = DEFAULT_TILE_SIZE;
+    } else {
+        tile_width = block_width;
+        tile_height = block_height;
+    }
+
+    int has_no_data_value = false;
+    no_data = band->GetNoDataValue(&has_no_data_value);
+    has_no_data = has_no_data_value;
+
+    double transform[6];
+    has_transform = dataset->GetGeoTransform(transform) == CE_None &&
+                    GDALInvGeoTransform(transform, inverse_transform);
+}
+
+float RasterSampler::sample(double pos_x, double pos_y) {
+    if (!has_transform || width <= 0 || height <= 0) { return NAN; }
+
+    double pixel_x, pixel_y;
+    GDALApplyGeoTransform(inverse_transform, pos_x, pos_y, &pixel_x, &pixel_y);
+
+    // Pixel values are located at the centers of the pixels
+    pixel_x = std::clamp(pixel_x - 0.5, 0.0, width - 1.0);
+    pixel_y = std::clamp(pixel_y - 0.5, 0.0, height - 1.0);
+
+    int column = static_cast<int>(pixel_x);
+    int row = static_cast<int>(pixel_y);
+    double fraction_x = pixel_x - column;
+    double fraction_y = pixel_y - row;
+
+    int next_column = std::min(column + 1, width - 1);
+    int next_row = std::min(row + 1, height - 1);
+
+    float values[4] = {get_pixel(column, row), get_pixel(next_column, row),
+                       get_pixel(column, next_row), get_pixel(next_column, next_row)};
+    double weights[4] = {(1.0 - fraction_x) * (1.0 - fraction_y), fraction_x * (1.0 - fraction_y),
+                         (1.0 - fraction_x) * fraction_y, fraction_x * fraction_y};
+
+    double sum = 0.0;
+    double weight_sum = 0.0;
+
+    for (int i = 0; i < 4; i++) {
+        if (std::isnan(values[i]) || (has_no_data && values[i] == no_data)) { continue; }
+
+        sum += values[i] * weights[i];
+        weight_sum += weights[i];
+    }
+
+    if (weight_sum <= 0.0) { return NAN; }
+
+    return sum / weight_sum;
+}
+
+std::vector<double> RasterSampler::drape_line(const std::vector<double> &points,
+                                              double max_segment_length) {
+    ScopedTrace trace("RasterSampler::drape_line");
+
+    std::vector<double> result;
+    size_t point_count = points.size() / 2;
+
+    if (point_count == 0) { return result; }
+
+    result.reserve(point_count * 3);
+
+    auto add_point = [&](double x, double y) {
+        result.push_back(x);
+        result.push_back(y);
+        result.push_back(sample(x, y));
+    };
+
+    add_point(points[0], points[1]);
+
+    for (size_t i = 1; i < point_count; i++) {
+        double start_x = points[i * 2 - 2], start_y = points[i * 2 - 1];
+        double end_x = points[i * 2], end_y = points[i * 2 + 1];
+
+        if (max_segment_length > 0.0) {
+            double length = std::hypot(end_x - start_x, end_y - start_y);
+            int subdivisions = static_cast<int>(std::ceil(length / max_segment_length));
+
+            for (int step = 1; step < subdivisions; step++) {
+                double fraction = static_cast<double>(step) / subdivisions;
+
+                add_point(start_x + (end_x - start_x) * fraction,
+                          start_y + (end_y - start_y) * fraction);
+            }
+        }
+
+        add_point(end_x, end_y);
+    }
+
+    return result;
+}
+
+float RasterSampler::get_pixel(int column, int row) {
+    const std::vector<float> &tile = get_tile(column / tile_width, row / tile_height);
+
+    if (tile.empty()) { return NAN; }
+
+    int tile_column_count = std::min(tile_width, width - (column / tile_width) * tile_width);
+
+    return tile[(row % tile_height) * tile_column_count + column % tile_width];
+}
+
+const std::vector<float> &RasterSampler::get_tile(int tile_x, int tile_y) {
+    int64_t tile_column_count = (width + tile_width - 1) / tile_width;
+    int64_t key = tile_y * tile_column_count + tile_x;
+
+    if (key == last_tile_key) { return *last_tile; }
+
+    auto existing = tiles.find(key);
+
+    if (existing == tiles.end()) {
+        int offset_x = tile_x * tile_width;
+        int offset_y = tile_y * tile_height;
+        int read_width = std::min(tile_width, width - offset_x);
+        int read_height = std::min(tile_height, height - offset_y);
+
+        std::vector<float> tile(static_cast<size_t>(read_width) * read_height);
+
+        CPLErr error;
+        {
+            RasterIOHelper lock;
+            error = dataset->GetRasterBand(1)->RasterIO(GF_Read, offset_x, offset_y, read_width,
+                                                        read_height, tile.data(), read_width,
+                                                        read_height, GDT_Float32, 0, 0);
+        }
+
+        // Unreadable tiles are kept empty so that they are not read again
+        if (error >= CE_Failure) { tile.clear(); }
+
+        existing = tiles.emplace(key, std::move(tile)).first;
+    }
+
+    last_tile_key = key;
+    last_tile = &existing->second;
+
+    return existing->second;
+}
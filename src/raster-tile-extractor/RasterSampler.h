@@ -0,0 +1,61 @@
+#ifndef RASTEREXTRACTOR_RASTERSAMPLER_H
+#define RASTEREXTRACTOR_RASTERSAMPLER_H
+
+#include "defines.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+class GDALDataset;
+
+/// Samples the first band of a dataset at arbitrary positions, e.g. for placing many vertices on
+/// terrain. Instead of one RasterIO call per position, the data is read in tiles aligned with the
+/// dataset's blocks, which are kept for all following samples. Positions should therefore be
+/// sampled in batches of spatially close positions, e.g. the vertices of all features in an area.
+/// Not thread-safe: use one RasterSampler per thread.
+class RasterSampler {
+  public:
+    explicit RasterSampler(GDALDataset *dataset);
+
+    /// Returns the bilinearly interpolated value at the given position in projected meters.
+    /// Positions outside of the dataset are clamped to its edge. No-data pixels are left out of
+    /// the interpolation; if there are only no-data pixels around, NaN is returned.
+    float sample(double pos_x, double pos_y);
+
+    /// Returns the given line (consecutive x, y pairs in projected meters) with an interpolated
+    /// height for each point, as consecutive x, y, z triples. If max_segment_length is larger
+    /// than 0, points are inserted into segments which are longer than that, so that the line
+    /// follows the terrain between the original points.
+    std::vector<double> drape_line(const std::vector<double> &points, double max_segment_length);
+
+  private:
+    /// Returns the value of the pixel at the given column and row, which must be in the dataset.
+    float get_pixel(int column, int row);
+
+    /// Returns the tile containing the given pixel, reading it if necessary
+    const std::vector<float> &get_tile(int tile_x, int tile_y);
+
+    GDALDataset *dataset;
+
+    int width;
+    int height;
+    int tile_width;
+    int tile_height;
+
+    bool has_no_data;
+    double no_data;
+
+    bool has_transform;
+    double inverse_transform[6];
+
+    /// Decoded tiles by tile_y * tile_column_count + tile_x
+    std::unordered_map<int64_t, std::vector<float>> tiles;
+
+    /// The most recently used tile, since consecutive samples are usually close to each other
+    int64_t last_tile_key = -1;
+    const std::vector<float> *last_tile = nullptr;
+};
+
+#endif // RASTEREXTRACTOR_RASTERSAMPLER_H
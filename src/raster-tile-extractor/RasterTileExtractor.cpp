@@ -1,5 +1,7 @@
 #include "RasterTileExtractor.h"
 #include "gdal-includes.h"
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iostream>
 
@@ -20,50 +22,108 @@ double webmercator_to_latitude(double webm_meters) {
 class DatasetPositionData {
   public:
     DatasetPositionData(GDALDataset *dataset, double meters_x, double meters_y, double size_meters)
-        : meters_x(meters_x), meters_y(meters_y), size_meters(size_meters) {
+        : DatasetPositionData(dataset, meters_x, meters_y, size_meters, size_meters) {}
+
+    DatasetPositionData(GDALDataset *dataset, double meters_x, double meters_y,
+                        double size_meters_x, double size_meters_y)
+        : meters_x(meters_x), meters_y(meters_y), size_meters_x(size_meters_x),
+          size_meters_y(size_meters_y) {
         // Get the current Transform of the source image
         double transform[6];
         dataset->GetGeoTransform(transform);
 
-        // Adjust the top left coordinates according to the input variables
-        double previous_meters_x = transform[0];
-        double previous_meters_y = transform[3];
-        double pixel_size = transform[1];
-
-        double offset_meters_x = meters_x - previous_meters_x;
-        double offset_meters_y = previous_meters_y - meters_y;
-
-        // Convert meters to pixels using the pixel size in meters
-        pixels_x = static_cast<int>(offset_meters_x / pixel_size);
-        pixels_y = static_cast<int>(offset_meters_y / pixel_size);
-
-        // Calculate the desired size in pixels
-        size_pixels = static_cast<int>(ceil(size_meters / pixel_size));
+        double inverse_transform[6];
+        GDALInvGeoTransform(transform, inverse_transform);
+
+        // Rotation terms or a non-north-up orientation mean that the requested area is not
+        // axis-aligned in pixel space
+        is_north_up = transform[2] == 0.0 && transform[4] == 0.0 && transform[1] > 0.0 &&
+                      transform[5] < 0.0;
+
+        if (is_north_up) {
+            // Convert meters to pixels using the pixel size in meters
+            double offset_pixels_x, offset_pixels_y;
+            GDALApplyGeoTransform(inverse_transform, meters_x, meters_y, &offset_pixels_x,
+                                  &offset_pixels_y);
+
+            pixels_x = static_cast<int>(offset_pixels_x);
+            pixels_y = static_cast<int>(offset_pixels_y);
+
+            // Calculate the desired size in pixels
+            size_pixels_x = static_cast<int>(ceil(size_meters_x / transform[1]));
+            size_pixels_y = static_cast<int>(ceil(size_meters_y / -transform[5]));
+        } else {
+            // Use the bounding box of all four corners in pixel space
+            double corners_x[4] = {meters_x, meters_x + size_meters_x, meters_x,
+                                   meters_x + size_meters_x};
+            double corners_y[4] = {meters_y, meters_y, meters_y - size_meters_y,
+                                   meters_y - size_meters_y};
+
+            double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+
+            for (int i = 0; i < 4; i++) {
+                double corner_pixel_x, corner_pixel_y;
+                GDALApplyGeoTransform(inverse_transform, corners_x[i], corners_y[i],
+                                      &corner_pixel_x, &corner_pixel_y);
+
+                min_x = std::min(min_x, corner_pixel_x);
+                min_y = std::min(min_y, corner_pixel_y);
+                max_x = std::max(max_x, corner_pixel_x);
+                max_y = std::max(max_y, corner_pixel_y);
+            }
+
+            pixels_x = static_cast<int>(floor(min_x));
+            pixels_y = static_cast<int>(floor(min_y));
+            size_pixels_x = std::max(1, static_cast<int>(ceil(max_x)) - pixels_x);
+            size_pixels_y = std::max(1, static_cast<int>(ceil(max_y)) - pixels_y);
+        }
     }
 
     double meters_x;
     double meters_y;
-    double size_meters;
+    double size_meters_x;
+    double size_meters_y;
+
+    bool is_north_up;
 
     int pixels_x;
     int pixels_y;
-    int size_pixels;
+    int size_pixels_x;
+    int size_pixels_y;
 };
 
 GeoRaster *RasterTileExtractor::clip_dataset(GDALDataset *dataset, double top_left_x,
-                                             double top_left_y, double size_meters, int img_size,
+                                             double top_left_y, double size_meters_x,
+                                             double size_meters_y, int img_size_x, int img_size_y,
                                              int interpolation_type) {
-    DatasetPositionData position_data(dataset, top_left_x, top_left_y, size_meters);
+    DatasetPositionData position_data(dataset, top_left_x, top_left_y, size_meters_x,
+                                      size_meters_y);
 
     // With these parameters, we can construct a GeoRaster!
-    return new GeoRaster(dataset, position_data.pixels_x, position_data.pixels_y,
-                         position_data.size_pixels, img_size, interpolation_type);
+    GeoRaster *raster = new GeoRaster(dataset, position_data.pixels_x, position_data.pixels_y,
+                                      position_data.size_pixels_x, position_data.size_pixels_y,
+                                      img_size_x, img_size_y, interpolation_type);
+
+    if (!position_data.is_north_up) {
+        raster->set_world_window(top_left_x, top_left_y, size_meters_x, size_meters_y);
+    }
+
+    return raster;
 }
 
 GeoRaster *RasterTileExtractor::get_tile_from_dataset(GDALDataset *dataset, double top_left_x,
                                                       double top_left_y, double size_meters,
                                                       int img_size, int interpolation_type) {
-    return clip_dataset(dataset, top_left_x, top_left_y, size_meters, img_size, interpolation_type);
+    return clip_dataset(dataset, top_left_x, top_left_y, size_meters, size_meters, img_size,
+                        img_size, interpolation_type);
+}
+
+GeoRaster *RasterTileExtractor::get_tile_from_dataset(GDALDataset *dataset, double top_left_x,
+                                                      double top_left_y, double size_meters_x,
+                                                      double size_meters_y, int img_size_x,
+                                                      int img_size_y, int interpolation_type) {
+    return clip_dataset(dataset, top_left_x, top_left_y, size_meters_x, size_meters_y, img_size_x,
+                        img_size_y, interpolation_type);
 }
 
 ExtentData RasterTileExtractor::get_extent_data(GDALDataset *dataset) {
@@ -74,12 +134,21 @@ ExtentData RasterTileExtractor::get_extent_data(GDALDataset *dataset) {
     double x_size = dataset->GetRasterXSize();
     double y_size = dataset->GetRasterYSize();
 
-    ExtentData extent_data;
+    // Apply the full transform to all four corners so that rotated rasters are covered too
+    double corners_x[4] = {0.0, x_size, 0.0, x_size};
+    double corners_y[4] = {0.0, 0.0, y_size, y_size};
 
-    extent_data.left = transform[0] + 0 * transform[1] + 0 * transform[2];
-    extent_data.right = transform[0] + x_size * transform[1] + 0 * transform[2];
-    extent_data.top = transform[3] + 0 * transform[4] + 0 * transform[5];
-    extent_data.down = transform[3] + 0 * transform[4] + y_size * transform[5];
+    ExtentData extent_data(INFINITY, -INFINITY, -INFINITY, INFINITY);
+
+    for (int i = 0; i < 4; i++) {
+        double x = transform[0] + corners_x[i] * transform[1] + corners_y[i] * transform[2];
+        double y = transform[3] + corners_x[i] * transform[4] + corners_y[i] * transform[5];
+
+        extent_data.left = std::min(extent_data.left, x);
+        extent_data.right = std::max(extent_data.right, x);
+        extent_data.top = std::max(extent_data.top, y);
+        extent_data.down = std::min(extent_data.down, y);
+    }
 
     return extent_data;
 }
@@ -100,7 +169,36 @@ float RasterTileExtractor::get_pixel_size(GDALDataset *dataset) {
     // From the docs:
     // In a north up image, padfTransform[1] is the pixel width, and padfTransform[5] is the pixel height.
     // The upper left corner of the upper left pixel is at position (padfTransform[0],padfTransform[3]).
-    return transform[1];
+    // For rotated images, the pixel width is the length of the column vector (transform[1], transform[4]).
+    return std::hypot(transform[1], transform[4]);
+}
+
+float RasterTileExtractor::get_pixel_size_y(GDALDataset *dataset) {
+    double transform[6];
+    dataset->GetGeoTransform(transform);
+
+    // The length of the row vector, see get_pixel_size
+    return std::hypot(transform[2], transform[5]);
+}
+
+int64_t RasterTileExtractor::get_block_cache_used() {
+    return GDALGetCacheUsed64();
+}
+
+int64_t RasterTileExtractor::get_block_cache_max() {
+    return GDALGetCacheMax64();
+}
+
+void RasterTileExtractor::set_block_cache_max(int64_t bytes) {
+    GDALSetCacheMax64(bytes);
+}
+
+void RasterTileExtractor::evict_dataset_cache(GDALDataset *dataset) {
+    // Flushing a band writes its dirty blocks and releases all of its cached blocks.
+    // Hold the RasterIO lock so that no tile is being read from this dataset meanwhile.
+    RasterIOHelper helper;
+
+    dataset->FlushCache();
 }
 
 void RasterTileExtractor::write_into_dataset(GDALDataset *dataset, double center_x, double center_y,
@@ -5,6 +5,8 @@
 #include "defines.h"
 #include "util.h"
 
+#include <cstdint>
+
 class RasterTileExtractor {
   public:
     /// Must be called before any other function to initialize GDAL.
@@ -16,6 +18,14 @@ class RasterTileExtractor {
                                             double top_left_y, double size_meters, int img_size,
                                             int interpolation_type);
 
+    /// Like get_tile_from_dataset, but for a rectangular area of size_meters_x * size_meters_y
+    /// which is resampled to an image of img_size_x * img_size_y pixels. Datasets with rotated or
+    /// non-north-up geotransforms are supported: only the pixels covering the area are read.
+    static GeoRaster *get_tile_from_dataset(GDALDataset *dataset, double top_left_x,
+                                            double top_left_y, double size_meters_x,
+                                            double size_meters_y, int img_size_x, int img_size_y,
+                                            int interpolation_type);
+
     static void write_into_dataset(GDALDataset *dataset, double center_x, double center_y,
                                    void *values, double scale, int interpolation_type);
 
@@ -26,14 +36,35 @@ class RasterTileExtractor {
 
     static float get_min(GDALDataset *dataset);
     static float get_max(GDALDataset *dataset);
+
+    /// Returns the width of a pixel in projected meters.
     static float get_pixel_size(GDALDataset *dataset);
 
+    /// Returns the height of a pixel in projected meters, which differs from the width for
+    /// rasters with non-square pixels.
+    static float get_pixel_size_y(GDALDataset *dataset);
+
+    /// Returns the number of bytes currently used by GDAL's global raster block cache.
+    static int64_t get_block_cache_used();
+
+    /// Returns the maximum size of GDAL's global raster block cache in bytes.
+    static int64_t get_block_cache_max();
+
+    /// Sets the maximum size of GDAL's global raster block cache in bytes. This overrides the
+    /// GDAL_CACHEMAX configuration option. Blocks exceeding the new size are evicted immediately.
+    static void set_block_cache_max(int64_t bytes);
+
+    /// Writes modified blocks of the given dataset to disk and evicts all of its blocks from the
+    /// block cache, making room for data which is currently needed.
+    static void evict_dataset_cache(GDALDataset *dataset);
+
   private:
     /// Return a GeoRaster containing the area in the given dataset starting at top_left_x,
     /// top_left_y with a given size (in meters). The resulting image has the resolution
-    /// img_size * img_size (pixels).
+    /// img_size_x * img_size_y (pixels).
     static GeoRaster *clip_dataset(GDALDataset *dataset, double top_left_x, double top_left_y,
-                                   double size_meters, int img_size, int interpolation_type);
+                                   double size_meters_x, double size_meters_y, int img_size_x,
+                                   int img_size_y, int interpolation_type);
 };
 
 #endif // RASTEREXTRACTOR_RASTERTILEEXTRACTOR_H
@@ -0,0 +1,165 @@
+#include "TerrainAnalysis.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float DEGREES_PER_RADIAN = 180.0 / M_PI;
+
+/// Calls kernel with the 3x3 neighbourhood of every pixel and writes the results into the result
+/// array. The neighbourhood is passed as
+///   a b c
+///   d e f
+///   g h i
+/// with e being the pixel itself and the first row of the array being the northernmost one.
+template <typename Output, typename Kernel>
+void apply_kernel(const float *heights, int width, int height, Output *result,
+                  const Kernel &kernel) {
+    if (width <= 0) { return; }
+
+    parallel_for_bands(height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const float *above = heights + std::max(y - 1, 0) * width;
+            const float *row = heights + y * width;
+            const float *below = heights + std::min(y + 1, height - 1) * width;
+            Output *out = result + y * width;
+
+            // The edge columns reuse their closest neighbours
+            for (int x : {0, width - 1}) {
+                int left = std::max(x - 1, 0);
+                int right = std::min(x + 1, width - 1);
+
+                out[x] = kernel(above[left], above[x], above[right], row[left], row[x], row[right],
+                                below[left], below[x], below[right]);
+            }
+
+            // The inner pixels don't need to clamp their neighbours
+            for (int x = 1; x < width - 1; x++) {
+                out[x] = kernel(above[x - 1], above[x], above[x + 1], row[x - 1], row[x],
+                                row[x + 1], below[x - 1], below[x], below[x + 1]);
+            }
+        }
+    });
+}
+
+/// Horn's gradient, scaled to meters per meter: positive towards the east and north.
+struct Gradient {
+    Gradient(double pixel_size_x, double pixel_size_y)
+        : factor_x(1.0 / (8.0 * pixel_size_x)), factor_y(1.0 / (8.0 * pixel_size_y)) {}
+
+    float east(float a, float c, float d, float f, float g, float i) const {
+        return ((c + 2.0f * f + i) - (a + 2.0f * d + g)) * factor_x;
+    }
+
+    float north(float a, float b, float c, float g, float h, float i) const {
+        return ((a + 2.0f * b + c) - (g + 2.0f * h + i)) * factor_y;
+    }
+
+    float factor_x;
+    float factor_y;
+};
+
+} // namespace
+
+void TerrainAnalysis::compute_slope(const float *heights, int width, int height,
+                                    double pixel_size_x, double pixel_size_y, float z_factor,
+                                    float *result) {
+    ScopedTrace trace("TerrainAnalysis::compute_slope");
+
+    Gradient gradient(pixel_size_x, pixel_size_y);
+
+    apply_kernel(heights, width, height, result,
+                 [&](float a, float b, float c, float d, float e, float f, float g, float h,
+                     float i) {
+                     // Horn's method doesn't use the pixel itself, so its missing data is checked
+                     if (std::isnan(e)) { return NAN; }
+
+                     float east = gradient.east(a, c, d, f, g, i) * z_factor;
+                     float north = gradient.north(a, b, c, g, h, i) * z_factor;
+
+                     return std::atan(std::sqrt(east * east + north * north)) * DEGREES_PER_RADIAN;
+                 });
+}
+
+void TerrainAnalysis::compute_aspect(const float *heights, int width, int height,
+                                     double pixel_size_x, double pixel_size_y, float *result) {
+    ScopedTrace trace("TerrainAnalysis::compute_aspect");
+
+    Gradient gradient(pixel_size_x, pixel_size_y);
+
+    apply_kernel(heights, width, height, result,
+                 [&](float a, float b, float c, float d, float e, float f, float g, float h,
+                     float i) {
+                     float east = gradient.east(a, c, d, f, g, i);
+                     float north = gradient.north(a, b, c, g, h, i);
+
+                     // Missing data propagates as NaN through the gradient
+                     if (std::isnan(e) || std::isnan(east) || std::isnan(north)) { return NAN; }
+
+                     if (east == 0.0f && north == 0.0f) { return -1.0f; }
+
+                     // The slope faces downhill, i.e. against the gradient
+                     float aspect = std::atan2(-east, -north) * DEGREES_PER_RADIAN;
+
+                     return aspect < 0.0f ? aspect + 360.0f : aspect;
+                 });
+}
+
+void TerrainAnalysis::compute_hillshade(const float *heights, int width, int height,
+                                        double pixel_size_x, double pixel_size_y, float z_factor,
+                                        float azimuth, float altitude, uint8_t *result) {
+    ScopedTrace trace("TerrainAnalysis::compute_hillshade");
+
+    Gradient gradient(pixel_size_x, pixel_size_y);
+
+    // Direction towards the light source as (east, north, up)
+    float azimuth_radians = azimuth / DEGREES_PER_RADIAN;
+    float altitude_radians = altitude / DEGREES_PER_RADIAN;
+
+    float light_east = std::sin(azimuth_radians) * std::cos(altitude_radians);
+    float light_north = std::cos(azimuth_radians) * std::cos(altitude_radians);
+    float light_up = std::sin(altitude_radians);
+
+    apply_kernel(heights, width, height, result,
+                 [&](float a, float b, float c, float d, float e, float f, float g, float h,
+                     float i) {
+                     float east = gradient.east(a, c, d, f, g, i) * z_factor;
+                     float north = gradient.north(a, b, c, g, h, i) * z_factor;
+
+                     // Missing data propagates as NaN, which can't be converted to an integer
+                     if (std::isnan(e) || std::isnan(east) || std::isnan(north)) {
+                         return uint8_t(0);
+                     }
+
+                     // Dot product of the light direction and the surface normal (-east, -north, 1)
+                     float lighting = (light_up - east * light_east - north * light_north) /
+                                      std::sqrt(1.0f + east * east + north * north);
+
+                     return static_cast<uint8_t>(std::clamp(lighting, 0.0f, 1.0f) * 255.0f);
+                 });
+}
+
+void TerrainAnalysis::compute_curvature(const float *heights, int width, int height,
+                                        double pixel_size_x, double pixel_size_y, float *result) {
+    ScopedTrace trace("TerrainAnalysis::compute_curvature");
+
+    float factor_x = 1.0 / (pixel_size_x * pixel_size_x);
+    float factor_y = 1.0 / (pixel_size_y * pixel_size_y);
+
+    apply_kernel(heights, width, height, result,
+                 [&](float a, float b, float c, float d, float e, float f, float g, float h,
+                     float i) {
+                     // Unlike the gradient, this doesn't use the corners, which may be missing
+                     if (std::isnan(a) || std::isnan(c) || std::isnan(g) || std::isnan(i)) {
+                         return NAN;
+                     }
+
+                     float second_derivative_x = ((d + f) * 0.5f - e) * factor_x;
+                     float second_derivative_y = ((b + h) * 0.5f - e) * factor_y;
+
+                     return -2.0f * (second_derivative_x + second_derivative_y) * 100.0f;
+                 });
+}
@@ -0,0 +1,38 @@
+#ifndef RASTEREXTRACTOR_TERRAINANALYSIS_H
+#define RASTEREXTRACTOR_TERRAINANALYSIS_H
+
+#include "defines.h"
+
+#include <cstdint>
+
+/// Derived terrain products computed from decoded heightmaps, as known from gdaldem.
+/// All functions take a row-major array of width * height heights (with the first row being the
+/// northernmost one) and the size of a pixel in meters, and write one value per pixel into the
+/// given result array. Gradients are computed with 3x3 kernels (Horn's method); pixels at the
+/// edges reuse their closest neighbours. Heights which are NaN mark missing data: pixels with NaN
+/// within their 3x3 neighbourhood get NaN (0 for the hillshade). The work is split across
+/// threads by rows.
+class TerrainAnalysis {
+  public:
+    /// Slope in degrees, from 0 (flat) to 90 (vertical).
+    static void compute_slope(const float *heights, int width, int height, double pixel_size_x,
+                              double pixel_size_y, float z_factor, float *result);
+
+    /// Direction which the slope faces in degrees, clockwise from north (0 = north, 90 = east).
+    /// Flat pixels get a value of -1.
+    static void compute_aspect(const float *heights, int width, int height, double pixel_size_x,
+                               double pixel_size_y, float *result);
+
+    /// Shaded relief from 0 (fully shaded) to 255 (fully lit) for a light source at the given
+    /// azimuth (degrees clockwise from north) and altitude (degrees above the horizon).
+    static void compute_hillshade(const float *heights, int width, int height, double pixel_size_x,
+                                  double pixel_size_y, float z_factor, float azimuth,
+                                  float altitude, uint8_t *result);
+
+    /// Curvature of the surface (Zevenbergen & Thorne) in 1/100 meters. Positive values indicate
+    /// convex areas such as ridges, negative values concave areas such as valleys.
+    static void compute_curvature(const float *heights, int width, int height,
+                                  double pixel_size_x, double pixel_size_y, float *result);
+};
+
+#endif // RASTEREXTRACTOR_TERRAINANALYSIS_H
@@ -0,0 +1,187 @@
+#include "Visibility.h"
+#include "HeightmapWindow.h"
+#include "RasterTileExtractor.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+constexpr double EARTH_RADIUS = 6371008.8;
+
+/// Atmospheric refraction bends lines of sight towards the earth, which makes the curvature
+/// appear smaller. 1/7 is the coefficient commonly used for visible light.
+constexpr double CURVATURE_FACTOR = 1.0 - 1.0 / 7.0;
+
+/// Batches of observers and targets spread out further than this are read at a lower resolution
+constexpr int MAX_WINDOW_SIZE = 4096;
+
+double get_curvature_drop(double distance, bool correct_curvature) {
+    if (!correct_curvature) { return 0.0; }
+
+    return CURVATURE_FACTOR * distance * distance / (2.0 * EARTH_RADIUS);
+}
+
+bool is_visible(const HeightmapWindow &window, const VisibilityPoint &observer,
+                const VisibilityPoint &target, double step_size, bool correct_curvature) {
+    double direction_x = target.x - observer.x;
+    double direction_y = target.y - observer.y;
+    double distance = std::hypot(direction_x, direction_y);
+
+    double start_height = window.sample(observer.x, observer.y) + observer.height_above_ground;
+    double end_height = window.sample(target.x, target.y) + target.height_above_ground -
+                        get_curvature_drop(distance, correct_curvature);
+
+    // Sample the terrain about once per pixel between (but excluding) observer and target
+    int steps = static_cast<int>(distance / step_size);
+
+    for (int step = 1; step < steps; step++) {
+        double fraction = static_cast<double>(step) / steps;
+
+        double terrain_height = window.sample(observer.x + direction_x * fraction,
+                                              observer.y + direction_y * fraction) -
+                                get_curvature_drop(distance * fraction, correct_curvature);
+        double line_height = start_height + (end_height - start_height) * fraction;
+
+        if (terrain_height > line_height) { return false; }
+    }
+
+    return true;
+}
+
+} // namespace
+
+std::vector<uint8_t> Visibility::get_lines_of_sight(GDALDataset *dataset,
+                                                    const std::vector<VisibilityPoint> &observers,
+                                                    const std::vector<VisibilityPoint> &targets,
+                                                    bool correct_curvature) {
+    ScopedTrace trace("Visibility::get_lines_of_sight");
+
+    size_t count = std::min(observers.size(), targets.size());
+    std::vector<uint8_t> result(count, 0);
+
+    if (count == 0) { return result; }
+
+    // Read the area covering all observers and targets at once
+    double min_x = std::numeric_limits<double>::max();
+    double min_y = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double max_y = std::numeric_limits<double>::lowest();
+
+    for (size_t index = 0; index < count; index++) {
+        for (const VisibilityPoint &point : {observers[index], targets[index]}) {
+            min_x = std::min(min_x, point.x);
+            min_y = std::min(min_y, point.y);
+            max_x = std::max(max_x, point.x);
+            max_y = std::max(max_y, point.y);
+        }
+    }
+
+    // Pad by a pixel so that interpolation at the edges has data on both sides
+    double padding = RasterTileExtractor::get_pixel_size(dataset);
+
+    HeightmapWindow window(dataset, min_x - padding, max_y + padding,
+                           max_x - min_x + 2.0 * padding, max_y - min_y + 2.0 * padding,
+                           MAX_WINDOW_SIZE);
+
+    if (!window.is_valid()) { return result; }
+
+    double step_size = std::min(window.pixel_size_x, window.pixel_size_y);
+
+    parallel_for_bands(
+        static_cast<int>(count),
+        [&](int begin, int end) {
+            for (int index = begin; index < end; index++) {
+                result[index] = is_visible(window, observers[index], targets[index], step_size,
+                                           correct_curvature);
+            }
+        },
+        8);
+
+    return result;
+}
+
+std::vector<uint8_t> Visibility::get_viewshed(GDALDataset *dataset,
+                                              const VisibilityPoint &observer, double radius,
+                                              double target_height, int size,
+                                              bool correct_curvature) {
+    ScopedTrace trace("Visibility::get_viewshed");
+
+    std::vector<uint8_t> result(static_cast<size_t>(size) * size, 0);
+
+    if (size <= 0) { return result; }
+
+    HeightmapWindow window(dataset, observer.x - radius, observer.y + radius, 2.0 * radius,
+                           2.0 * radius, size, size);
+
+    if (!window.is_valid()) { return result; }
+
+    int observer_x = size / 2;
+    int observer_y = size / 2;
+    double observer_height =
+        window.sample(observer.x, observer.y) + observer.height_above_ground;
+
+    // Rays are cast from the observer to every cell on the border of the raster. Along each ray,
+    // a cell is visible if the line of sight to it is steeper than to every cell before it.
+    std::vector<std::pair<int, int>> border;
+    for (int i = 0; i < size; i++) {
+        border.emplace_back(i, 0);
+        border.emplace_back(i, size - 1);
+    }
+    for (int i = 1; i < size - 1; i++) {
+        border.emplace_back(0, i);
+        border.emplace_back(size - 1, i);
+    }
+
+    std::mutex result_mutex;
+
+    parallel_for_bands(
+        static_cast<int>(border.size()),
+        [&](int begin, int end) {
+            // Neighbouring rays overlap near the observer, so every band of rays writes into its
+            // own buffer which is merged into the result afterwards
+            std::vector<uint8_t> visible(result.size(), 0);
+
+            for (int index = begin; index < end; index++) {
+                int delta_x = border[index].first - observer_x;
+                int delta_y = border[index].second - observer_y;
+                int steps = std::max(std::abs(delta_x), std::abs(delta_y));
+
+                double max_tangent = std::numeric_limits<double>::lowest();
+
+                for (int step = 1; step <= steps; step++) {
+                    double fraction = static_cast<double>(step) / steps;
+                    int x = observer_x + static_cast<int>(std::lround(delta_x * fraction));
+                    int y = observer_y + static_cast<int>(std::lround(delta_y * fraction));
+
+                    double distance = std::hypot((x - observer_x) * window.pixel_size_x,
+                                                 (y - observer_y) * window.pixel_size_y);
+                    if (distance > radius) { break; }
+
+                    double terrain_height =
+                        window.get(x, y) - get_curvature_drop(distance, correct_curvature);
+
+                    double target_tangent =
+                        (terrain_height + target_height - observer_height) / distance;
+                    if (target_tangent >= max_tangent) { visible[y * size + x] = 255; }
+
+                    max_tangent =
+                        std::max(max_tangent, (terrain_height - observer_height) / distance);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            for (size_t cell = 0; cell < visible.size(); cell++) {
+                result[cell] |= visible[cell];
+            }
+        },
+        64);
+
+    result[observer_y * size + observer_x] = 255;
+
+    return result;
+}
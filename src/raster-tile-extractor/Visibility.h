@@ -0,0 +1,40 @@
+#ifndef RASTEREXTRACTOR_VISIBILITY_H
+#define RASTEREXTRACTOR_VISIBILITY_H
+
+#include "defines.h"
+
+#include <cstdint>
+#include <vector>
+
+// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+class GDALDataset;
+
+/// A point in projected meters with a height above the terrain, e.g. the eyes of an observer.
+struct VisibilityPoint {
+    double x;
+    double y;
+    double height_above_ground;
+};
+
+/// Visibility analyses over the first band of a heightmap dataset.
+/// With earth curvature correction, distant terrain is lowered by d^2 / 2R, reduced by the usual
+/// atmospheric refraction coefficient of 1/7 (as in gdal_viewshed).
+class Visibility {
+  public:
+    /// Checks whether each target can be seen from the observer with the same index.
+    /// The heightmap covering all points is read once for the whole batch, and the lines of sight
+    /// are checked on multiple threads. Returns 1 for visible and 0 for hidden targets.
+    static std::vector<uint8_t> get_lines_of_sight(GDALDataset *dataset,
+                                                   const std::vector<VisibilityPoint> &observers,
+                                                   const std::vector<VisibilityPoint> &targets,
+                                                   bool correct_curvature);
+
+    /// Returns a square raster of size * size pixels centered on the observer and covering
+    /// 2 * radius meters, with 255 for cells where a target at target_height above the terrain
+    /// is visible from the observer and 0 for hidden cells and cells outside of the radius.
+    static std::vector<uint8_t> get_viewshed(GDALDataset *dataset, const VisibilityPoint &observer,
+                                             double radius, double target_height, int size,
+                                             bool correct_curvature);
+};
+
+#endif // RASTEREXTRACTOR_VISIBILITY_H
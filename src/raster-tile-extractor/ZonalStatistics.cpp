@@ -0,0 +1,250 @@
+#include "ZonalStatistics.h"
+#include "HeightmapWindow.h"
+#include "RasterTileExtractor.h"
+#include "gdal-includes.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+/// Batches of zones are not combined beyond this size (in pixels per side) so that the data
+/// which is read at once stays small. Larger zones are read on their own at a lower resolution.
+constexpr int MAX_BATCH_SIZE = 2048;
+
+struct Bounds {
+    double min_x = std::numeric_limits<double>::max();
+    double min_y = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double max_y = std::numeric_limits<double>::lowest();
+
+    void extend(const Bounds &other) {
+        min_x = std::min(min_x, other.min_x);
+        min_y = std::min(min_y, other.min_y);
+        max_x = std::max(max_x, other.max_x);
+        max_y = std::max(max_y, other.max_y);
+    }
+};
+
+Bounds get_bounds(const Zone &zone) {
+    Bounds bounds;
+
+    for (const std::vector<double> &ring : zone.rings) {
+        for (size_t i = 0; i + 1 < ring.size(); i += 2) {
+            bounds.min_x = std::min(bounds.min_x, ring[i]);
+            bounds.max_x = std::max(bounds.max_x, ring[i]);
+            bounds.min_y = std::min(bounds.min_y, ring[i + 1]);
+            bounds.max_y = std::max(bounds.max_y, ring[i + 1]);
+        }
+    }
+
+    return bounds;
+}
+
+/// Zones which are read together
+struct Batch {
+    std::vector<int> zones;
+    Bounds bounds;
+};
+
+/// Options for all zones
+struct Settings {
+    bool has_no_data;
+    double no_data;
+    bool compute_majority;
+};
+
+/// Rasterizes the zone row by row and accumulates the values of the pixels whose centers are
+/// inside of it.
+ZoneStatistics compute_zone(const HeightmapWindow &window, const Zone &zone,
+                            const Bounds &bounds, const Settings &settings) {
+    ZoneStatistics statistics;
+    statistics.min = std::numeric_limits<double>::max();
+    statistics.max = std::numeric_limits<double>::lowest();
+
+    std::unordered_map<double, int64_t> histogram;
+
+    int row_begin = std::max(
+        static_cast<int>(std::floor((window.top_left_y - bounds.max_y) / window.pixel_size_y)), 0);
+    int row_end = std::min(
+        static_cast<int>(std::ceil((window.top_left_y - bounds.min_y) / window.pixel_size_y)),
+        window.height);
+
+    std::vector<double> crossings;
+
+    for (int row = row_begin; row < row_end; row++) {
+        double y = window.top_left_y - (row + 0.5) * window.pixel_size_y;
+
+        crossings.clear();
+
+        for (const std::vector<double> &ring : zone.rings) {
+            size_t point_count = ring.size() / 2;
+
+            for (size_t i = 0; i < point_count; i++) {
+                size_t next = (i + 1) % point_count;
+
+                double x_1 = ring[i * 2], y_1 = ring[i * 2 + 1];
+                double x_2 = ring[next * 2], y_2 = ring[next * 2 + 1];
+
+                if ((y_1 > y) != (y_2 > y)) {
+                    crossings.push_back(x_1 + (y - y_1) / (y_2 - y_1) * (x_2 - x_1));
+                }
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        // Pixels with their centers between each pair of crossings are inside
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            int column_begin = std::max(
+                static_cast<int>(
+                    std::ceil((crossings[i] - window.top_left_x) / window.pixel_size_x - 0.5)),
+                0);
+            int column_end = std::min(
+                static_cast<int>(
+                    std::ceil((crossings[i + 1] - window.top_left_x) / window.pixel_size_x - 0.5)),
+                window.width);
+
+            const float *values = window.heights.data() + static_cast<size_t>(row) * window.width;
+
+            for (int column = column_begin; column < column_end; column++) {
+                double value = values[column];
+
+                if (std::isnan(value) || (settings.has_no_data && value == settings.no_data)) {
+                    continue;
+                }
+
+                statistics.count++;
+                statistics.sum += value;
+                statistics.min = std::min(statistics.min, value);
+                statistics.max = std::max(statistics.max, value);
+
+                if (settings.compute_majority) { histogram[value]++; }
+            }
+        }
+    }
+
+    if (statistics.count == 0) { return ZoneStatistics(); }
+
+    statistics.mean = statistics.sum / statistics.count;
+
+    // Ties are resolved towards the smaller value so that the result is deterministic
+    int64_t majority_count = 0;
+    for (const auto &entry : histogram) {
+        if (entry.second > majority_count ||
+            (entry.second == majority_count && entry.first < statistics.majority)) {
+            statistics.majority = entry.first;
+            majority_count = entry.second;
+        }
+    }
+
+    return statistics;
+}
+
+} // namespace
+
+std::vector<ZoneStatistics> ZonalStatistics::compute(GDALDataset *dataset,
+                                                     const std::vector<Zone> &zones) {
+    ScopedTrace trace("ZonalStatistics::compute");
+
+    std::vector<ZoneStatistics> result(zones.size());
+
+    if (zones.empty()) { return result; }
+
+    GDALRasterBand *band = dataset->GetRasterBand(1);
+
+    Settings settings;
+    int has_no_data = false;
+    settings.no_data = band->GetNoDataValue(&has_no_data);
+    settings.has_no_data = has_no_data;
+    settings.compute_majority = GDALDataTypeIsInteger(band->GetRasterDataType());
+
+    double transform[6];
+    dataset->GetGeoTransform(transform);
+    double pixel_size_x = RasterTileExtractor::get_pixel_size(dataset);
+    double pixel_size_y = RasterTileExtractor::get_pixel_size_y(dataset);
+
+    std::vector<Bounds> zone_bounds(zones.size());
+    std::vector<int> order(zones.size());
+
+    for (size_t i = 0; i < zones.size(); i++) {
+        zone_bounds[i] = get_bounds(zones[i]);
+        order[i] = i;
+    }
+
+    // Sort the zones into strips from north to south, and from west to east within each strip, so
+    // that zones which follow each other are close to each other
+    double strip_height = pixel_size_y * MAX_BATCH_SIZE / 2.0;
+
+    auto get_strip = [&](int zone) {
+        return std::floor((zone_bounds[zone].min_y + zone_bounds[zone].max_y) / 2.0 / strip_height);
+    };
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        double strip_a = get_strip(a), strip_b = get_strip(b);
+        if (strip_a != strip_b) { return strip_a > strip_b; }
+
+        return zone_bounds[a].min_x < zone_bounds[b].min_x;
+    });
+
+    // Greedily combine consecutive zones into batches as long as their area remains small enough
+    std::vector<Batch> batches;
+    double max_batch_width = pixel_size_x * MAX_BATCH_SIZE;
+    double max_batch_height = pixel_size_y * MAX_BATCH_SIZE;
+
+    for (int zone : order) {
+        if (zone_bounds[zone].min_x > zone_bounds[zone].max_x) { continue; } // No vertices
+
+        if (!batches.empty()) {
+            Bounds combined = batches.back().bounds;
+            combined.extend(zone_bounds[zone]);
+
+            if (combined.max_x - combined.min_x <= max_batch_width &&
+                combined.max_y - combined.min_y <= max_batch_height) {
+                batches.back().zones.push_back(zone);
+                batches.back().bounds = combined;
+                continue;
+            }
+        }
+
+        batches.push_back({{zone}, zone_bounds[zone]});
+    }
+
+    parallel_for_bands(
+        static_cast<int>(batches.size()),
+        [&](int begin, int end) {
+            for (int index = begin; index < end; index++) {
+                const Batch &batch = batches[index];
+
+                // Align the window to the dataset's pixels so that the values are not resampled
+                double left = transform[0] +
+                              std::floor((batch.bounds.min_x - transform[0]) / pixel_size_x) *
+                                  pixel_size_x;
+                double top = transform[3] -
+                             std::floor((transform[3] - batch.bounds.max_y) / pixel_size_y) *
+                                 pixel_size_y;
+
+                int width = std::max(
+                    static_cast<int>(std::ceil((batch.bounds.max_x - left) / pixel_size_x)), 1);
+                int height = std::max(
+                    static_cast<int>(std::ceil((top - batch.bounds.min_y) / pixel_size_y)), 1);
+
+                HeightmapWindow window(dataset, left, top, width * pixel_size_x,
+                                       height * pixel_size_y, std::min(width, MAX_BATCH_SIZE),
+                                       std::min(height, MAX_BATCH_SIZE), 0);
+
+                if (!window.is_valid()) { continue; }
+
+                for (int zone : batch.zones) {
+                    result[zone] = compute_zone(window, zones[zone], zone_bounds[zone], settings);
+                }
+            }
+        },
+        1);
+
+    return result;
+}
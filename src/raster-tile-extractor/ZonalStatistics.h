@@ -0,0 +1,46 @@
+#ifndef RASTEREXTRACTOR_ZONALSTATISTICS_H
+#define RASTEREXTRACTOR_ZONALSTATISTICS_H
+
+#include "defines.h"
+
+#include <cstdint>
+#include <vector>
+
+// Forward declaration of GDALDataset from <gdal/gdal_priv.h>
+class GDALDataset;
+
+/// A polygon over which statistics are computed.
+struct Zone {
+    /// The outer ring followed by the rings of any holes, each as consecutive x, y pairs in
+    /// projected meters.
+    std::vector<std::vector<double>> rings;
+};
+
+struct ZoneStatistics {
+    /// Number of pixels whose centers are within the zone (not counting no-data pixels)
+    int64_t count = 0;
+
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+    double mean = 0.0;
+
+    /// Most common value; only computed for integer bands such as classifications
+    double majority = 0.0;
+};
+
+/// Statistics of raster values within polygons, as known from QGIS' zonal statistics.
+class ZonalStatistics {
+  public:
+    /// Returns the statistics of the first band of the dataset within each zone. Neighbouring
+    /// zones are grouped into batches which share one read of the area covering all of them, and
+    /// batches are processed on multiple threads. Within a batch, each zone is rasterized with a
+    /// scanline fill (even-odd, so holes are excluded).
+    /// Zones are read at the dataset's resolution unless they span more than 2048 pixels; such
+    /// zones are read on their own at a lower resolution, so their counts refer to those pixels.
+    /// Zones too small to contain any pixel center have a count of 0.
+    static std::vector<ZoneStatistics> compute(GDALDataset *dataset,
+                                               const std::vector<Zone> &zones);
+};
+
+#endif // RASTEREXTRACTOR_ZONALSTATISTICS_H
@@ -8,6 +8,8 @@
 
 #include "geodata.h"
 #include "geoimage.h"
+#include "geomeshbuilder.h"
+#include "geoperformance.h"
 #include "geotransform.h"
 #include "loaders.h"
 
@@ -22,10 +24,14 @@ void register_geodot_types(ModuleInitializationLevel p_level) {
     ClassDB::register_class<GeoPolygon>();
     ClassDB::register_class<GeoDataset>();
     ClassDB::register_class<GeoFeatureLayer>();
+    ClassDB::register_class<GeoFeatureCursor>();
     ClassDB::register_class<GeoRasterLayer>();
+    ClassDB::register_class<GeoRasterCache>();
     ClassDB::register_class<GeoTransform>();
+    ClassDB::register_class<GeoMeshBuilder>();
     ClassDB::register_class<GeoDatasetLoader>();
     ClassDB::register_class<GeoRasterLayerLoader>();
+    ClassDB::register_class<GeoTracer>();
 
     // Register resource loaders
     Ref<GeoDatasetLoader> loader;
@@ -37,10 +43,14 @@ void register_geodot_types(ModuleInitializationLevel p_level) {
     raster_loader.instantiate();
 
     ResourceLoader::get_singleton()->add_resource_format_loader(raster_loader);
+
+    GeoPerformanceMonitors::add_monitors();
 }
 
 void unregister_geodot_types(ModuleInitializationLevel p_level) {
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) { return; }
+
+    GeoPerformanceMonitors::remove_monitors();
 }
 
 extern "C" {
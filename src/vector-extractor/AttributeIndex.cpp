@@ -0,0 +1,348 @@
+#include "AttributeIndex.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+struct Token {
+    enum Type { IDENTIFIER, NUMBER, STRING, SYMBOL, END, INVALID };
+
+    Type type;
+
+    /// The identifier, string or symbol; keywords are identifiers
+    std::string text;
+
+    double number = 0.0;
+};
+
+/// Splits a filter into tokens, with quotes and escapes of identifiers and strings resolved
+class Tokenizer {
+  public:
+    explicit Tokenizer(const std::string &filter) : filter(filter) {}
+
+    Token next() {
+        while (position < filter.size() && std::isspace(static_cast<unsigned char>(peek()))) {
+            position++;
+        }
+
+        if (position >= filter.size()) { return {Token::END, ""}; }
+
+        char current = peek();
+
+        if (current == '\'' || current == '"') {
+            return read_quoted(current, current == '\'' ? Token::STRING : Token::IDENTIFIER);
+        }
+
+        if (std::isalpha(static_cast<unsigned char>(current)) || current == '_') {
+            size_t begin = position;
+
+            while (position < filter.size() &&
+                   (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_')) {
+                position++;
+            }
+
+            return {Token::IDENTIFIER, filter.substr(begin, position - begin)};
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(current)) || current == '-' ||
+            current == '+' || current == '.') {
+            const char *begin = filter.c_str() + position;
+            char *end = nullptr;
+            double number = std::strtod(begin, &end);
+
+            if (end == begin) { return {Token::INVALID, ""}; }
+
+            position += end - begin;
+            return {Token::NUMBER, "", number};
+        }
+
+        // Two-character comparison operators first
+        for (const char *symbol : {"<=", ">=", "<>", "!=", "=="}) {
+            if (filter.compare(position, 2, symbol) == 0) {
+                position += 2;
+                return {Token::SYMBOL, symbol};
+            }
+        }
+
+        position++;
+        return {Token::SYMBOL, std::string(1, current)};
+    }
+
+  private:
+    char peek() const { return filter[position]; }
+
+    /// Reads a token enclosed in the given quote, where two quotes stand for one
+    Token read_quoted(char quote, Token::Type type) {
+        std::string text;
+        position++;
+
+        while (position < filter.size()) {
+            if (peek() == quote) {
+                if (position + 1 < filter.size() && filter[position + 1] == quote) {
+                    text += quote;
+                    position += 2;
+                    continue;
+                }
+
+                position++;
+                return {type, text};
+            }
+
+            text += peek();
+            position++;
+        }
+
+        // The closing quote is missing
+        return {Token::INVALID, ""};
+    }
+
+    const std::string &filter;
+    size_t position = 0;
+};
+
+bool is_keyword(const Token &token, const char *keyword) {
+    if (token.type != Token::IDENTIFIER || token.text.size() != std::strlen(keyword)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < token.text.size(); i++) {
+        if (std::toupper(static_cast<unsigned char>(token.text[i])) != keyword[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool is_symbol(const Token &token, const char *symbol) {
+    return token.type == Token::SYMBOL && token.text == symbol;
+}
+
+/// Adds the value of the token to the condition. Returns false if it is not a value, or not of
+/// the same kind as the previous ones.
+bool add_value(const Token &token, AttributeCondition &condition, bool is_first) {
+    if (token.type != Token::NUMBER && token.type != Token::STRING) { return false; }
+
+    bool is_numeric = token.type == Token::NUMBER;
+
+    if (is_first) {
+        condition.is_numeric = is_numeric;
+    } else if (condition.is_numeric != is_numeric) {
+        return false;
+    }
+
+    if (is_numeric) {
+        condition.numbers.push_back(token.number);
+    } else {
+        condition.strings.push_back(token.text);
+    }
+
+    return true;
+}
+
+/// Sorts the values together with their IDs and returns the sorted order
+template <typename T>
+std::vector<size_t> get_sorted_order(const std::vector<T> &values,
+                                     const std::vector<int64_t> &ids) {
+    std::vector<size_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return values[a] < values[b] || (values[a] == values[b] && ids[a] < ids[b]);
+    });
+
+    return order;
+}
+
+} // namespace
+
+bool AttributeCondition::parse(const std::string &filter, AttributeCondition &result) {
+    Tokenizer tokenizer(filter);
+    AttributeCondition condition;
+
+    Token field = tokenizer.next();
+    if (field.type != Token::IDENTIFIER || is_keyword(field, "NOT")) { return false; }
+
+    condition.field = field.text;
+
+    Token operation = tokenizer.next();
+
+    if (is_symbol(operation, "=") || is_symbol(operation, "==")) {
+        condition.type = EQUAL;
+        if (!add_value(tokenizer.next(), condition, true)) { return false; }
+    } else if (is_keyword(operation, "IN")) {
+        condition.type = EQUAL;
+        if (!is_symbol(tokenizer.next(), "(")) { return false; }
+
+        Token separator;
+        bool is_first = true;
+
+        do {
+            if (!add_value(tokenizer.next(), condition, is_first)) { return false; }
+
+            is_first = false;
+            separator = tokenizer.next();
+        } while (is_symbol(separator, ","));
+
+        if (!is_symbol(separator, ")")) { return false; }
+    } else if (is_keyword(operation, "BETWEEN")) {
+        condition.type = RANGE;
+
+        Token min = tokenizer.next();
+        if (min.type != Token::NUMBER || !is_keyword(tokenizer.next(), "AND")) { return false; }
+
+        Token max = tokenizer.next();
+        if (max.type != Token::NUMBER) { return false; }
+
+        condition.is_numeric = true;
+        condition.min = min.number;
+        condition.max = max.number;
+    } else if (is_symbol(operation, "<") || is_symbol(operation, "<=") ||
+               is_symbol(operation, ">") || is_symbol(operation, ">=")) {
+        condition.type = RANGE;
+
+        Token bound = tokenizer.next();
+        if (bound.type != Token::NUMBER) { return false; }
+
+        condition.is_numeric = true;
+
+        if (operation.text[0] == '<') {
+            condition.max = bound.number;
+            condition.include_max = operation.text.size() == 2;
+        } else {
+            condition.min = bound.number;
+            condition.include_min = operation.text.size() == 2;
+        }
+    } else {
+        return false;
+    }
+
+    // Anything after the condition, e.g. another condition joined with AND, is left to GDAL
+    if (tokenizer.next().type != Token::END) { return false; }
+
+    result = std::move(condition);
+    return true;
+}
+
+AttributeIndex::AttributeIndex(std::vector<double> values, std::vector<int64_t> value_ids)
+    : numeric(true) {
+    ScopedTrace trace("AttributeIndex::AttributeIndex");
+
+    // NaN matches no condition, and it would break the ordering of the sort
+    size_t valid_count = 0;
+
+    for (size_t i = 0; i < values.size(); i++) {
+        if (std::isnan(values[i])) { continue; }
+
+        // -0.0 and 0.0 are equal, so they must also have the same hash
+        values[valid_count] = values[i] + 0.0;
+        value_ids[valid_count] = value_ids[i];
+        valid_count++;
+    }
+
+    values.resize(valid_count);
+    value_ids.resize(valid_count);
+
+    std::vector<size_t> order = get_sorted_order(values, value_ids);
+
+    numbers.reserve(order.size());
+    ids.reserve(order.size());
+
+    for (size_t position : order) {
+        numbers.push_back(values[position]);
+        ids.push_back(value_ids[position]);
+    }
+
+    for (size_t begin = 0, end = 0; begin < numbers.size(); begin = end) {
+        while (end < numbers.size() && numbers[end] == numbers[begin]) {
+            end++;
+        }
+
+        number_ranges[numbers[begin]] = {begin, end};
+    }
+}
+
+AttributeIndex::AttributeIndex(std::vector<std::string> values, std::vector<int64_t> value_ids)
+    : numeric(false) {
+    ScopedTrace trace("AttributeIndex::AttributeIndex");
+
+    std::vector<size_t> order = get_sorted_order(values, value_ids);
+
+    strings.reserve(order.size());
+    ids.reserve(order.size());
+
+    for (size_t position : order) {
+        strings.push_back(std::move(values[position]));
+        ids.push_back(value_ids[position]);
+    }
+
+    // The views point into the strings, which are not changed anymore
+    for (size_t begin = 0, end = 0; begin < strings.size(); begin = end) {
+        while (end < strings.size() && strings[end] == strings[begin]) {
+            end++;
+        }
+
+        string_ranges[strings[begin]] = {begin, end};
+    }
+}
+
+bool AttributeIndex::is_numeric() const {
+    return numeric;
+}
+
+size_t AttributeIndex::size() const {
+    return ids.size();
+}
+
+void AttributeIndex::append_ids(size_t begin, size_t end, std::vector<int64_t> &result) const {
+    result.insert(result.end(), ids.begin() + begin, ids.begin() + end);
+}
+
+bool AttributeIndex::find(const AttributeCondition &condition,
+                          std::vector<int64_t> &result) const {
+    if (condition.is_numeric != numeric) { return false; }
+
+    if (condition.type == AttributeCondition::RANGE) {
+        auto begin = condition.include_min
+                         ? std::lower_bound(numbers.begin(), numbers.end(), condition.min)
+                         : std::upper_bound(numbers.begin(), numbers.end(), condition.min);
+        auto end = condition.include_max
+                       ? std::upper_bound(numbers.begin(), numbers.end(), condition.max)
+                       : std::lower_bound(numbers.begin(), numbers.end(), condition.max);
+
+        if (begin < end) { append_ids(begin - numbers.begin(), end - numbers.begin(), result); }
+
+        return true;
+    }
+
+    // Values which are listed more than once must only be added once
+    auto append_range = [&](const auto &ranges, const auto &value, std::vector<size_t> &added) {
+        auto range = ranges.find(value);
+        if (range == ranges.end()) { return; }
+
+        if (std::find(added.begin(), added.end(), range->second.begin) != added.end()) { return; }
+        added.push_back(range->second.begin);
+
+        append_ids(range->second.begin, range->second.end, result);
+    };
+
+    std::vector<size_t> added;
+
+    if (numeric) {
+        for (double value : condition.numbers) {
+            append_range(number_ranges, value + 0.0, added);
+        }
+    } else {
+        for (const std::string &value : condition.strings) {
+            append_range(string_ranges, std::string_view(value), added);
+        }
+    }
+
+    return true;
+}
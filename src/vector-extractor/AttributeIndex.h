@@ -0,0 +1,89 @@
+#ifndef VECTOREXTRACTOR_ATTRIBUTEINDEX_H
+#define VECTOREXTRACTOR_ATTRIBUTEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// A condition on a single attribute which can be answered by an AttributeIndex.
+struct AttributeCondition {
+    /// EQUAL matches any of the values (for both `=` and `IN`), RANGE matches values between min
+    /// and max
+    enum Type { EQUAL, RANGE };
+
+    std::string field;
+    Type type;
+
+    /// True if the values are numbers, false if they are strings
+    bool is_numeric;
+
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+
+    /// The bounds of a RANGE, which is always numeric; infinite if there is no bound
+    double min = -std::numeric_limits<double>::infinity();
+    double max = std::numeric_limits<double>::infinity();
+    bool include_min = true;
+    bool include_max = true;
+
+    /// Parses filters of the forms `field = value`, `field IN (value, ...)`, `field < value`
+    /// (also with <=, > and >=) and `field BETWEEN value AND value`, where values are numbers or
+    /// 'strings' (all of the same kind) and the field may be "quoted". Ranges must be numeric.
+    /// Returns false for any other filter, which has to be evaluated by GDAL instead.
+    static bool parse(const std::string &filter, AttributeCondition &result);
+};
+
+/// The values of one attribute of many features, sorted for range queries and hashed for equality
+/// queries. Features whose attribute is not set are not included, like in SQL comparisons with
+/// NULL. It can't be changed after being built.
+class AttributeIndex {
+  public:
+    /// Builds a numeric index from the value of each ID.
+    AttributeIndex(std::vector<double> values, std::vector<int64_t> ids);
+
+    /// Builds a string index from the value of each ID.
+    AttributeIndex(std::vector<std::string> values, std::vector<int64_t> ids);
+
+    /// Not copyable or movable, since string_ranges refers to the memory of strings
+    AttributeIndex(const AttributeIndex &) = delete;
+    AttributeIndex &operator=(const AttributeIndex &) = delete;
+    AttributeIndex(AttributeIndex &&) = delete;
+    AttributeIndex &operator=(AttributeIndex &&) = delete;
+
+    bool is_numeric() const;
+
+    /// Appends the IDs of all features which fulfill the condition, in no particular order.
+    /// Returns false without appending anything if the condition can't be answered by this index,
+    /// e.g. when comparing a numeric attribute to strings.
+    bool find(const AttributeCondition &condition, std::vector<int64_t> &result) const;
+
+    /// Returns the number of values in the index.
+    size_t size() const;
+
+  private:
+    /// A range of positions within the sorted values
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    /// Appends the IDs in the given range of positions
+    void append_ids(size_t begin, size_t end, std::vector<int64_t> &result) const;
+
+    bool numeric;
+
+    /// The values (in the vector corresponding to the type) and their IDs, sorted by value
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+    std::vector<int64_t> ids;
+
+    /// The range of positions of each distinct value
+    std::unordered_map<double, Range> number_ranges;
+    std::unordered_map<std::string_view, Range> string_ranges;
+};
+
+#endif // VECTOREXTRACTOR_ATTRIBUTEINDEX_H
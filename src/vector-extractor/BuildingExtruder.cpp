@@ -0,0 +1,181 @@
+#include "BuildingExtruder.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Twice the signed area of the ring (consecutive x, y pairs); positive if it is counter-clockwise
+double get_signed_area(const std::vector<double> &ring) {
+    double area = 0.0;
+    size_t point_count = ring.size() / 2;
+
+    for (size_t i = 0; i < point_count; i++) {
+        size_t next = (i + 1) % point_count;
+        area += ring[i * 2] * ring[next * 2 + 1] - ring[next * 2] * ring[i * 2 + 1];
+    }
+
+    return area;
+}
+
+/// Returns the ring without a closing point, clockwise if it is the outer ring and
+/// counter-clockwise if it is a hole, so that the building is always on the right side
+std::vector<double> get_oriented_ring(const std::vector<double> &ring, bool is_outer) {
+    size_t point_count = ring.size() / 2;
+
+    if (point_count > 1 && ring[0] == ring[point_count * 2 - 2] &&
+        ring[1] == ring[point_count * 2 - 1]) {
+        point_count--;
+    }
+
+    std::vector<double> oriented(ring.begin(), ring.begin() + point_count * 2);
+
+    if ((get_signed_area(oriented) > 0.0) == is_outer) {
+        for (size_t i = 0; i < point_count / 2; i++) {
+            size_t other = point_count - 1 - i;
+            std::swap(oriented[i * 2], oriented[other * 2]);
+            std::swap(oriented[i * 2 + 1], oriented[other * 2 + 1]);
+        }
+    }
+
+    return oriented;
+}
+
+void add_vertex(ExtrudedMesh &mesh, double x, double y, double z, double normal_x,
+                double normal_y, double normal_z, double u, double v, int32_t building_index) {
+    mesh.vertices.insert(mesh.vertices.end(), {x, y, z});
+    mesh.normals.insert(mesh.normals.end(), {normal_x, normal_y, normal_z});
+    mesh.uvs.insert(mesh.uvs.end(), {u, v});
+    mesh.building_indices.push_back(building_index);
+}
+
+/// Adds the walls and the roof of the building to the given meshes, with vertex indices starting
+/// at 0
+void extrude_building(const BuildingFootprint &footprint, ExtrudedMesh &walls,
+                      ExtrudedMesh &roofs) {
+    PolygonRings rings;
+
+    for (size_t i = 0; i < footprint.rings.size(); i++) {
+        std::vector<double> ring = get_oriented_ring(footprint.rings[i], i == 0);
+
+        if (ring.size() >= 6) {
+            rings.push_back(std::move(ring));
+        } else if (i == 0) {
+            // Without an outer ring, there is no building
+            return;
+        }
+    }
+
+    if (rings.empty()) { return; }
+
+    double bottom = footprint.base_height;
+    double top = footprint.base_height + footprint.height;
+
+    // Each wall gets its own vertices for flat shading
+    for (const std::vector<double> &ring : rings) {
+        size_t point_count = ring.size() / 2;
+        double distance = 0.0;
+
+        for (size_t i = 0; i < point_count; i++) {
+            size_t next = (i + 1) % point_count;
+
+            double ax = ring[i * 2];
+            double ay = ring[i * 2 + 1];
+            double bx = ring[next * 2];
+            double by = ring[next * 2 + 1];
+
+            double length = std::hypot(bx - ax, by - ay);
+            if (length == 0.0) { continue; }
+
+            // The building is on the right, so the left normal faces outwards
+            double normal_x = -(by - ay) / length;
+            double normal_y = (bx - ax) / length;
+
+            int32_t first = walls.vertices.size() / 3;
+
+            add_vertex(walls, ax, ay, bottom, normal_x, normal_y, 0.0, distance, 0.0, 0);
+            add_vertex(walls, bx, by, bottom, normal_x, normal_y, 0.0, distance + length, 0.0, 0);
+            add_vertex(walls, bx, by, top, normal_x, normal_y, 0.0, distance + length,
+                       footprint.height, 0);
+            add_vertex(walls, ax, ay, top, normal_x, normal_y, 0.0, distance, footprint.height, 0);
+
+            walls.indices.insert(walls.indices.end(),
+                                 {first, first + 1, first + 2, first, first + 2, first + 3});
+
+            distance += length;
+        }
+    }
+
+    double origin_x = rings[0][0];
+    double origin_y = rings[0][1];
+
+    for (const std::vector<double> &ring : rings) {
+        for (size_t i = 0; i + 1 < ring.size(); i += 2) {
+            add_vertex(roofs, ring[i], ring[i + 1], top, 0.0, 0.0, 1.0, ring[i] - origin_x,
+                       ring[i + 1] - origin_y, 0);
+        }
+    }
+
+    roofs.indices = PolygonTriangulator::triangulate(rings);
+}
+
+/// Appends the mesh to the target, offsetting its vertex indices and assigning its vertices to
+/// the given building
+void append_mesh(ExtrudedMesh &target, const ExtrudedMesh &mesh, int32_t building_index) {
+    int32_t first_vertex = target.vertices.size() / 3;
+
+    target.vertices.insert(target.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+    target.normals.insert(target.normals.end(), mesh.normals.begin(), mesh.normals.end());
+    target.uvs.insert(target.uvs.end(), mesh.uvs.begin(), mesh.uvs.end());
+    target.building_indices.insert(target.building_indices.end(), mesh.vertices.size() / 3,
+                                   building_index);
+
+    for (int32_t index : mesh.indices) {
+        target.indices.push_back(first_vertex + index);
+    }
+}
+
+} // namespace
+
+std::vector<BuildingChunk>
+BuildingExtruder::extrude(const std::vector<BuildingFootprint> &footprints, int chunk_count) {
+    ScopedTrace trace("BuildingExtruder::extrude");
+
+    std::vector<BuildingChunk> chunks(std::max(chunk_count, 0));
+
+    int footprint_count = static_cast<int>(footprints.size());
+    std::vector<ExtrudedMesh> walls(footprint_count);
+    std::vector<ExtrudedMesh> roofs(footprint_count);
+
+    parallel_for_bands(
+        footprint_count,
+        [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                const BuildingFootprint &footprint = footprints[i];
+
+                if (footprint.height <= 0.0 || footprint.chunk < 0 ||
+                    footprint.chunk >= chunk_count) {
+                    continue;
+                }
+
+                extrude_building(footprint, walls[i], roofs[i]);
+            }
+        },
+        16);
+
+    // Merging is cheap compared to the triangulation, so it happens on this thread in order
+    for (int i = 0; i < footprint_count; i++) {
+        if (walls[i].indices.empty() && roofs[i].indices.empty()) { continue; }
+
+        BuildingChunk &chunk = chunks[footprints[i].chunk];
+        int32_t building_index = chunk.ids.size();
+
+        append_mesh(chunk.walls, walls[i], building_index);
+        append_mesh(chunk.roofs, roofs[i], building_index);
+        chunk.ids.push_back(footprints[i].id);
+    }
+
+    return chunks;
+}
@@ -0,0 +1,64 @@
+#ifndef VECTOREXTRACTOR_BUILDINGEXTRUDER_H
+#define VECTOREXTRACTOR_BUILDINGEXTRUDER_H
+
+#include "PolygonTriangulator.h"
+
+#include <cstdint>
+#include <vector>
+
+/// The footprint of a building which is extruded from base_height to base_height + height.
+struct BuildingFootprint {
+    /// The outline of the building in projected meters, see PolygonRings
+    PolygonRings rings;
+
+    double base_height;
+    double height;
+
+    /// Returned in BuildingChunk::ids, e.g. the ID of the feature
+    int64_t id;
+
+    /// The chunk which this building is added to
+    int chunk;
+};
+
+/// Triangles of extruded buildings with the attributes needed for rendering and picking.
+struct ExtrudedMesh {
+    /// Consecutive x, y, z triples in projected meters
+    std::vector<double> vertices;
+
+    /// One x, y, z normal per vertex
+    std::vector<double> normals;
+
+    /// One u, v pair per vertex in meters: along the outline and upwards from the base for walls,
+    /// relative to the first point of the outline for roofs
+    std::vector<double> uvs;
+
+    /// The index of the building (within BuildingChunk::ids) of each vertex
+    std::vector<int32_t> building_indices;
+
+    /// Three vertex indices per triangle, clockwise when seen from the front (facing outwards
+    /// and upwards when converted to Godot's coordinate system)
+    std::vector<int32_t> indices;
+};
+
+/// The buildings in one chunk, e.g. a tile, merged into one mesh for the walls and one for the
+/// roofs.
+struct BuildingChunk {
+    ExtrudedMesh walls;
+    ExtrudedMesh roofs;
+
+    /// The ID of each building in this chunk
+    std::vector<int64_t> ids;
+};
+
+class BuildingExtruder {
+  public:
+    /// Extrudes the footprints in parallel and merges them into the given number of chunks.
+    /// Walls have flat normals facing away from the building (also for walls around holes), roofs
+    /// are flat and triangulated with the PolygonTriangulator. Footprints with a height which is
+    /// not larger than 0 or an invalid chunk are skipped.
+    static std::vector<BuildingChunk> extrude(const std::vector<BuildingFootprint> &footprints,
+                                              int chunk_count);
+};
+
+#endif // VECTOREXTRACTOR_BUILDINGEXTRUDER_H
@@ -37,19 +37,83 @@ const uint8_t *Feature::get_binary_attribute(const char *name, int* n_bytes) {
     return ret;
 }
 
+int Feature::get_field_index(const char *name) const {
+    return feature->GetFieldIndex(name);
+}
+
+int64_t Feature::get_attribute_as_integer(int index) const {
+    if (index < 0 || index >= feature->GetFieldCount()) { return 0; }
+
+    return feature->GetFieldAsInteger64(index);
+}
+
+double Feature::get_attribute_as_real(int index) const {
+    if (index < 0 || index >= feature->GetFieldCount()) { return 0.0; }
+
+    return feature->GetFieldAsDouble(index);
+}
+
+bool Feature::get_attribute_as_bool(int index) const {
+    if (index < 0 || index >= feature->GetFieldCount() || !feature->IsFieldSetAndNotNull(index)) {
+        return false;
+    }
+
+    OGRFieldType type = feature->GetFieldDefnRef(index)->GetType();
+
+    if (type == OFTInteger || type == OFTInteger64 || type == OFTReal) {
+        return feature->GetFieldAsDouble(index) != 0.0;
+    }
+
+    const char *value = feature->GetFieldAsString(index);
+
+    return EQUAL(value, "true") || EQUAL(value, "yes") || EQUAL(value, "1");
+}
+
+bool Feature::get_attribute_as_date_time(int index, AttributeDateTime &result) const {
+    if (index < 0 || index >= feature->GetFieldCount() || !feature->IsFieldSetAndNotNull(index)) {
+        return false;
+    }
+
+    return feature->GetFieldAsDateTime(index, &result.year, &result.month, &result.day,
+                                       &result.hour, &result.minute, &result.second,
+                                       &result.time_zone);
+}
+
 void Feature::set_attribute(const char *name, const char *value) {
     feature->SetField(name, value);
+    mark_modified();
 }
 
 void Feature::set_binary_attribute(const char *name, uint8_t *value, int n_bytes) {
     feature->SetField(feature->GetFieldIndex(name), n_bytes, value);
+    mark_modified();
 }
 
+void Feature::mark_modified() {
+    if (changes == nullptr) {
+        is_modified = true;
+        return;
+    }
+
+    // Set under the lock, since a background save clears it unless the feature is dirty
+    std::lock_guard<std::mutex> lock(changes->mutex);
+
+    is_modified = true;
+
+    if (!is_dirty) {
+        is_dirty = true;
+        changes->ids.insert(cache_id);
+    }
+}
 
 int Feature::get_id() const {
     return feature->GetFID();
 }
 
+const OGRGeometry *Feature::get_geometry() const {
+    return feature->GetGeometryRef();
+}
+
 bool Feature::intersects_with(std::shared_ptr<Feature> other) const {
     if (geometry_type == NONE or other->geometry_type == NONE) {
         // Features without goemetry cannot intersect
@@ -4,12 +4,36 @@
 #include "defines.h"
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <cstdint>
 
 class OGRFeature;
 class OGRGeometry;
 
+/// The value of a date, time or date-time attribute
+struct AttributeDateTime {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    float second;
+
+    /// 0 for unknown, 1 for local time, 100 for GMT, and 100 +/- 4 per 15 minutes of offset
+    /// from GMT otherwise (like OGRFeature::GetFieldAsDateTime)
+    int time_zone;
+};
+
+/// The cache IDs (see Feature::cache_id) of a layer's features which were changed since the layer
+/// last synchronized them, shared between the layer and its features so that only those need to
+/// be synchronized.
+struct FeatureChanges {
+    std::mutex mutex;
+    std::set<int64_t> ids;
+};
+
 class Feature {
   public:
     enum GeometryType { NONE, POINT, LINE, POLYGON };
@@ -33,18 +57,59 @@ class Feature {
 
     const uint8_t *get_binary_attribute(const char *name, int *n_bytes);
 
+    /// Return the index of the attribute with the given name, or -1 if there is none.
+    /// For reading an attribute of many features, the index should be resolved only once (e.g.
+    /// with NativeLayer::get_field_index) and passed to the typed getters.
+    int get_field_index(const char *name) const;
+
+    /// Typed getters for the attribute with the given index, which avoid converting the value to
+    /// a string. Unset attributes and invalid indices result in 0.
+    int64_t get_attribute_as_integer(int index) const;
+    double get_attribute_as_real(int index) const;
+
+    /// Numbers other than 0 and the strings "true", "yes" and "1" (in any case) are true.
+    bool get_attribute_as_bool(int index) const;
+
+    /// Writes the date and time of the attribute with the given index to the given result.
+    /// Returns false if it is not set or can't be read as a date.
+    bool get_attribute_as_date_time(int index, AttributeDateTime &result) const;
+
     void set_attribute(const char *name, const char *value);
 
     void set_binary_attribute(const char *name, uint8_t *value, int n_bytes);
 
+    /// Called by the setters: marks this feature as modified and, if it isn't yet, as dirty
+    /// within the changes of its layer.
+    void mark_modified();
+
     int get_id() const;
 
+    /// Return the geometry of this Feature. For parts of multi-geometries, this is only the part
+    /// corresponding to this Feature, not the whole geometry of the OGRFeature.
+    virtual const OGRGeometry *get_geometry() const;
+
     bool intersects_with(std::shared_ptr<Feature> other) const;
 
     GeometryType geometry_type = NONE;
 
     bool is_deleted = false;
 
+    /// Set by the setters, so that the NativeLayer keeps this feature cached until it is saved
+    /// instead of evicting it together with its changes. Only cleared once a save has committed
+    /// the feature and it wasn't changed since. Written under the mutex of changes, if any.
+    bool is_modified = false;
+
+    /// True if the feature was changed since its layer last synchronized it, i.e. its cache_id is
+    /// in changes. Guarded by the mutex of changes.
+    bool is_dirty = false;
+
+    /// The changes of the layer which caches this feature, if any
+    std::shared_ptr<FeatureChanges> changes;
+
+    /// The key of the layer's feature cache entry which contains this feature. This is the ID of
+    /// the OGRFeature, which differs from get_id for the parts of multi-geometries.
+    int64_t cache_id = -1;
+
     OGRFeature *feature;
 };
 
@@ -0,0 +1,59 @@
+#ifndef VECTOREXTRACTOR_FEATURECOLUMNS_H
+#define VECTOREXTRACTOR_FEATURECOLUMNS_H
+
+#include "Feature.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// The values of one attribute for all rows of a FeatureColumns result.
+struct AttributeColumn {
+    enum Type { INTEGER, INTEGER64, REAL, STRING };
+
+    std::string name;
+    Type type;
+
+    /// Only the vector which corresponds to the type is filled, with one entry per row.
+    /// Unset attributes are 0 or an empty string.
+    std::vector<int64_t> integers;
+    std::vector<double> reals;
+    std::vector<std::string> strings;
+};
+
+/// The result of a feature query in a columnar layout, for consumers which process many features
+/// at once and don't need a Feature object for each of them.
+/// Each row corresponds to one Feature as returned by the other queries: multi-geometries result in
+/// one row per part, with the same attributes.
+struct FeatureColumns {
+    /// The ID of each row, as returned by Feature::get_id
+    std::vector<int64_t> ids;
+
+    /// The geometry type of each row; NONE for rows without geometry
+    std::vector<Feature::GeometryType> geometry_types;
+
+    /// The vertices of all rows as consecutive x, y, z triples in projected meters
+    std::vector<double> coordinates;
+
+    /// The index of the first vertex of each ring, followed by the total vertex count.
+    /// Points have one ring with one vertex, lines have one ring, and polygons have their outer
+    /// ring (clockwise, like PolygonFeature::get_outer_vertices) followed by their holes.
+    std::vector<int64_t> ring_offsets{0};
+
+    /// The index of the first ring of each row, followed by the total ring count.
+    /// Rows without geometry have no rings.
+    std::vector<int64_t> row_offsets{0};
+
+    std::vector<AttributeColumn> attributes;
+};
+
+/// The values of one attribute for all features of a layer, see NativeLayer::get_attribute_values.
+struct AttributeValues {
+    /// The ID of each row. Unlike in FeatureColumns, multi-geometries have only one row, since
+    /// their parts share the attributes.
+    std::vector<int64_t> ids;
+
+    AttributeColumn column;
+};
+
+#endif // VECTOREXTRACTOR_FEATURECOLUMNS_H
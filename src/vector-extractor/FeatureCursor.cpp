@@ -0,0 +1,138 @@
+#include "FeatureCursor.h"
+#include "NativeLayer.h"
+#include "gdal-includes.h"
+#include "performance-counters.h"
+#include "trace.h"
+
+FeatureCursor::FeatureCursor(std::shared_ptr<NativeLayer> layer, const OGRGeometry *geometry,
+                             std::string attribute_filter, int max_amount)
+    : layer(layer), geometry(geometry != nullptr ? geometry->clone() : nullptr),
+      attribute_filter(attribute_filter), max_amount(max_amount) {
+    if (layer == nullptr || !layer->is_valid() || max_amount == 0) { stage = FINISHED; }
+}
+
+FeatureCursor::~FeatureCursor() {
+    if (stage == FINISHED) { return; }
+
+    PerformanceCounters::lock(layer->layer_mutex, "NativeLayer lock wait");
+    finish();
+    layer->layer_mutex.unlock();
+}
+
+std::shared_ptr<FeatureCursor> FeatureCursor::near_position(std::shared_ptr<NativeLayer> layer,
+                                                            double pos_x, double pos_y,
+                                                            double radius, int max_amount) {
+    OGRPoint center(pos_x, pos_y);
+    std::unique_ptr<OGRGeometry> circle(center.Buffer(radius));
+
+    return std::make_shared<FeatureCursor>(layer, circle.get(), "", max_amount);
+}
+
+std::shared_ptr<FeatureCursor> FeatureCursor::in_square(std::shared_ptr<NativeLayer> layer,
+                                                        double top_left_x, double top_left_y,
+                                                        double size_meters, int max_amount) {
+    OGRLinearRing *square_outline = new OGRLinearRing();
+    square_outline->addPoint(top_left_x, top_left_y);
+    square_outline->addPoint(top_left_x + size_meters, top_left_y);
+    square_outline->addPoint(top_left_x + size_meters, top_left_y - size_meters);
+    square_outline->addPoint(top_left_x, top_left_y - size_meters);
+    square_outline->addPoint(top_left_x, top_left_y);
+
+    OGRPolygon square;
+    square.addRingDirectly(square_outline);
+
+    return std::make_shared<FeatureCursor>(layer, &square, "", max_amount);
+}
+
+std::list<std::shared_ptr<Feature>> FeatureCursor::get_next_page(int page_size) {
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("FeatureCursor::get_next_page");
+
+    std::list<std::shared_ptr<Feature>> page;
+
+    if (stage == FINISHED) { return page; }
+
+    PerformanceCounters::lock(layer->layer_mutex, "NativeLayer lock wait");
+
+    while (stage != FINISHED && static_cast<int>(page.size()) < page_size) {
+        if (is_cancelled) {
+            finish();
+            break;
+        }
+
+        // Another query or cursor may have used the layer since the last page
+        if (layer->reading_cursor != this) { seek(); }
+
+        OGRLayer *current_layer = stage == DISK ? layer->layer : layer->ram_layer;
+        OGRFeature *feature = current_layer->GetNextFeature();
+
+        if (feature == nullptr) {
+            if (stage == DISK) {
+                // Continue with the RAM layer
+                stage = RAM;
+                position = 0;
+                layer->release_cursor();
+            } else {
+                finish();
+            }
+
+            continue;
+        }
+
+        position++;
+        page.splice(page.end(), layer->get_feature_for_ogrfeature(feature));
+
+        if (max_amount >= 0 && returned_count + static_cast<int>(page.size()) >= max_amount) {
+            page.resize(max_amount - returned_count);
+            finish();
+        }
+    }
+
+    layer->layer_mutex.unlock();
+
+    returned_count += page.size();
+
+    return page;
+}
+
+bool FeatureCursor::is_finished() const {
+    return stage == FINISHED || is_cancelled;
+}
+
+void FeatureCursor::cancel() {
+    is_cancelled = true;
+}
+
+int FeatureCursor::get_returned_count() const {
+    return returned_count;
+}
+
+void FeatureCursor::seek() {
+    layer->release_cursor();
+
+    OGRLayer *current_layer = layer->layer;
+
+    if (stage == RAM) {
+        current_layer = layer->ram_layer;
+
+        // Make changes to cached features of the RAM layer visible to the filters
+        if (position == 0) { layer->write_feature_cache_to_ram_layer(); }
+    }
+
+    current_layer->SetSpatialFilter(geometry.get());
+    current_layer->SetAttributeFilter(attribute_filter.empty() ? nullptr
+                                                               : attribute_filter.c_str());
+    current_layer->ResetReading();
+
+    // Drivers without fast random access skip the features one by one, which is still cheaper
+    // than creating Features for them
+    if (position > 0) { current_layer->SetNextByIndex(position); }
+
+    layer->reading_cursor = this;
+}
+
+void FeatureCursor::finish() {
+    if (layer->reading_cursor == this) { layer->release_cursor(); }
+
+    stage = FINISHED;
+}
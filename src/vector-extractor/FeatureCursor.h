@@ -0,0 +1,80 @@
+#ifndef VECTOREXTRACTOR_FEATURECURSOR_H
+#define VECTOREXTRACTOR_FEATURECURSOR_H
+
+#include "Feature.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+class NativeLayer;
+class OGRGeometry;
+
+/// Iterates over the features of a NativeLayer (first the disk layer, then the RAM layer) page by
+/// page, so that large results never have to be held in memory at once. Pages can be requested
+/// at any time, e.g. one per frame; other queries on the layer in between are allowed.
+/// Except for `cancel`, a cursor must only be used by one thread at a time.
+class FeatureCursor {
+  public:
+    /// Creates a cursor over the features which intersect with the given geometry (if it is not
+    /// null) and which fulfill the given SQL-WHERE-like attribute filter (if it is not empty).
+    /// The geometry is copied. At most max_amount features are returned; negative means no limit.
+    FeatureCursor(std::shared_ptr<NativeLayer> layer, const OGRGeometry *geometry,
+                  std::string attribute_filter, int max_amount);
+
+    ~FeatureCursor();
+
+    /// Creates a cursor over the features which overlap with the circle around the given position.
+    static std::shared_ptr<FeatureCursor> near_position(std::shared_ptr<NativeLayer> layer,
+                                                        double pos_x, double pos_y, double radius,
+                                                        int max_amount);
+
+    /// Creates a cursor over the features which overlap with the square created by the given
+    /// top-left position and size.
+    static std::shared_ptr<FeatureCursor> in_square(std::shared_ptr<NativeLayer> layer,
+                                                    double top_left_x, double top_left_y,
+                                                    double size_meters, int max_amount);
+
+    /// Returns the next features, continuing where the previous page ended. The page has
+    /// page_size features, unless the end is reached, or a multi-geometry feature at the end of
+    /// the page contributes more than one Feature. The Features are cached like in all other
+    /// queries of the NativeLayer.
+    std::list<std::shared_ptr<Feature>> get_next_page(int page_size);
+
+    /// Returns true if all features have been returned, the maximum amount has been reached, or
+    /// the cursor was cancelled.
+    bool is_finished() const;
+
+    /// Stops the cursor; following pages are empty. Can be called from any thread.
+    void cancel();
+
+    /// Returns the number of Features which have been returned so far.
+    int get_returned_count() const;
+
+  private:
+    enum Stage { DISK, RAM, FINISHED };
+
+    /// Sets this cursor's filters on the layer which is currently read and moves to the current
+    /// position within it. Required whenever another query has used the layer in between.
+    void seek();
+
+    /// Removes this cursor's filters from the layers and marks it as finished.
+    void finish();
+
+    std::shared_ptr<NativeLayer> layer;
+    std::unique_ptr<OGRGeometry> geometry;
+    std::string attribute_filter;
+    int max_amount;
+
+    Stage stage = DISK;
+    std::atomic<bool> is_cancelled{false};
+
+    /// The number of OGRFeatures read from the current layer
+    int64_t position = 0;
+
+    int returned_count = 0;
+};
+
+#endif // VECTOREXTRACTOR_FEATURECURSOR_H
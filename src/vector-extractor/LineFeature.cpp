@@ -36,8 +36,14 @@ double LineFeature::get_line_point_z(int index) {
 void LineFeature::set_point_count(int new_count) {
     line->setNumPoints(new_count);
     point_count = new_count;
+    mark_modified();
 }
 
 void LineFeature::set_line_point(int index, double x, double y, double z) {
     line->setPoint(index, x, y, z);
+    mark_modified();
+}
+
+const OGRGeometry *LineFeature::get_geometry() const {
+    return line;
 }
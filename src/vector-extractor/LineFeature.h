@@ -44,6 +44,8 @@ class LineFeature : public Feature {
     /// The z coordinate is optional, it defaults to 0.0.
     void set_line_point(int index, double x, double y, double z = 0.0);
 
+    const OGRGeometry *get_geometry() const override;
+
   private:
     OGRLineString *line;
 
@@ -2,13 +2,31 @@
 #include "NativeLayer.h"
 
 
-NativeDataset::NativeDataset(std::string path, bool write_access)
-    : path(path), write_access(write_access) {
+NativeDataset::NativeDataset(std::string path, bool write_access, int num_threads)
+    : path(path), write_access(write_access), num_threads(num_threads) {
     unsigned int open_access = write_access ? GDAL_OF_UPDATE : GDAL_OF_READONLY;
 
+    // GDAL_NUM_THREADS is read by the drivers when opening the dataset, so setting it thread-locally
+    // around GDALOpenEx makes it specific to this dataset without affecting any others.
+    std::string previous_num_threads;
+    if (num_threads > 0) {
+        const char *previous = CPLGetThreadLocalConfigOption("GDAL_NUM_THREADS", "");
+        previous_num_threads = previous;
+
+        CPLSetThreadLocalConfigOption("GDAL_NUM_THREADS", std::to_string(num_threads).c_str());
+    }
+
     dataset = (GDALDataset *)GDALOpenEx(path.c_str(), open_access, nullptr, nullptr, nullptr);
+
+    if (num_threads > 0) {
+        CPLSetThreadLocalConfigOption(
+            "GDAL_NUM_THREADS", previous_num_threads.empty() ? nullptr : previous_num_threads.c_str());
+    }
 }
 
+NativeDataset::NativeDataset(GDALDataset *dataset, std::string path)
+    : path(path), write_access(true), num_threads(0), dataset(dataset) {}
+
 NativeDataset::~NativeDataset() {
     GDALClose(dataset);
 }
@@ -56,25 +74,69 @@ std::vector<std::string> NativeDataset::get_raster_band_descriptions() {
 }
 
 bool NativeDataset::has_layer(const char *name) const {
+    std::lock_guard<std::mutex> lock(*mutex);
+
     return dataset->GetLayerByName(name) != NULL;
 }
 
 std::shared_ptr<NativeLayer> NativeDataset::get_sql_layer(const char *query) const {
-    return std::make_shared<NativeLayer>(dataset->ExecuteSQL(query, nullptr, nullptr));
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    return std::make_shared<NativeLayer>(dataset->ExecuteSQL(query, nullptr, nullptr),
+                                         shared_from_this());
 }
 
 std::shared_ptr<NativeLayer> NativeDataset::get_layer(const char *name) const {
-    return std::make_shared<NativeLayer>(dataset->GetLayerByName(name));
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    return std::make_shared<NativeLayer>(dataset->GetLayerByName(name), shared_from_this());
 }
 
 std::shared_ptr<NativeDataset> NativeDataset::get_subdataset(const char *name) const {
     // TODO: Hardcoded for the way GeoPackages work - do we want to support others too?
     return std::make_shared<NativeDataset> (("GPKG:" + path + std::string(":") + std::string(name)).c_str(),
-                             write_access);
+                             write_access, num_threads);
+}
+
+std::shared_ptr<NativeLayer>
+NativeDataset::create_layer(const char *name, Feature::GeometryType geometry_type, int epsg_code,
+                            const std::vector<std::string> &field_names) {
+    OGRwkbGeometryType ogr_geometry_type = wkbNone;
+
+    if (geometry_type == Feature::POINT) {
+        ogr_geometry_type = wkbPoint;
+    } else if (geometry_type == Feature::LINE) {
+        ogr_geometry_type = wkbLineString;
+    } else if (geometry_type == Feature::POLYGON) {
+        ogr_geometry_type = wkbPolygon;
+    }
+
+    std::lock_guard<std::mutex> lock(*mutex);
+
+    OGRSpatialReference *spatial_reference = nullptr;
+    if (epsg_code != -1) {
+        spatial_reference = new OGRSpatialReference();
+        spatial_reference->importFromEPSG(epsg_code);
+    }
+
+    OGRLayer *layer = dataset->CreateLayer(name, spatial_reference, ogr_geometry_type);
+
+    // The layer keeps its own reference
+    if (spatial_reference != nullptr) { spatial_reference->Release(); }
+
+    if (layer == nullptr) { return nullptr; }
+
+    // Fields must exist before the NativeLayer is created, since it copies them into its RAM layer
+    for (const std::string &field_name : field_names) {
+        OGRFieldDefn field_definition(field_name.c_str(), OGRFieldType::OFTString);
+        layer->CreateField(&field_definition);
+    }
+
+    return std::make_shared<NativeLayer>(layer, shared_from_this());
 }
 
 std::shared_ptr<NativeDataset> NativeDataset::clone() {
-    return std::make_shared<NativeDataset> (path, write_access);
+    return std::make_shared<NativeDataset> (path, write_access, num_threads);
 }
 
 bool NativeDataset::is_valid() const {
@@ -1,11 +1,23 @@
+#ifndef VECTOREXTRACTOR_NATIVEDATASET_H
+#define VECTOREXTRACTOR_NATIVEDATASET_H
+
+#include "Feature.h"
 #include "gdal-includes.h"
 
+#include <memory>
+#include <mutex>
 
 class NativeLayer;
 
-class NativeDataset {
+class NativeDataset : public std::enable_shared_from_this<NativeDataset> {
   public:
-    NativeDataset(std::string path, bool write_access);
+    /// If num_threads is larger than 0, it is used as GDAL_NUM_THREADS while opening the dataset,
+    /// which drivers such as GTiff use for decoding blocks in parallel.
+    NativeDataset(std::string path, bool write_access, int num_threads = 0);
+
+    /// Wraps a dataset which was created rather than opened from a path, e.g. one in memory.
+    /// Takes ownership of the dataset.
+    NativeDataset(GDALDataset *dataset, std::string path);
     ~NativeDataset();
 
     /// Return the names of all feature layers as std::strings.
@@ -29,6 +41,13 @@ class NativeDataset {
 
     std::shared_ptr<NativeDataset> get_subdataset(const char *name) const;
 
+    /// Creates a new, empty feature layer with the given name, geometry type and (string)
+    /// attribute fields in this dataset. The spatial reference is set from the EPSG code unless it
+    /// is -1. Returns null if the dataset doesn't support creating layers.
+    std::shared_ptr<NativeLayer> create_layer(const char *name, Feature::GeometryType geometry_type,
+                                              int epsg_code,
+                                              const std::vector<std::string> &field_names);
+
     std::shared_ptr<NativeDataset> clone();
 
     bool is_valid() const;
@@ -40,5 +59,14 @@ class NativeDataset {
 
     bool write_access;
 
+    int num_threads;
+
     GDALDataset *dataset;
-};
\ No newline at end of file
+
+    /// Locked while the GDAL dataset or one of its layers is accessed. It is shared with the
+    /// NativeLayers of this dataset, since their layers use the same connection (e.g. the SQLite
+    /// database of a GeoPackage), and their background threads must not use it concurrently.
+    std::shared_ptr<std::mutex> mutex = std::make_shared<std::mutex>();
+};
+
+#endif // VECTOREXTRACTOR_NATIVEDATASET_H
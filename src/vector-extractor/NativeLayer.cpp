@@ -2,10 +2,16 @@
 #include "NativeDataset.h"
 #include "PointFeature.h"
 #include "PolygonFeature.h"
+#include "performance-counters.h"
+#include "trace.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <memory>
 
-NativeLayer::NativeLayer(OGRLayer *layer) : layer(layer) {
+NativeLayer::NativeLayer(OGRLayer *layer, std::shared_ptr<const NativeDataset> dataset)
+    : dataset(dataset), layer(layer), layer_mutex(*dataset->mutex) {
     // We want users to be able to create and modify features, but we also don't necessarily want to
     // write those changes to disk. So we create a in-RAM layer with the same footprint as this
     // layer. It starts empty and is filled with new user-created features once they are created.
@@ -26,51 +32,347 @@ NativeLayer::NativeLayer(OGRLayer *layer) : layer(layer) {
     }
 }
 
+void NativeLayer::lock_layers() {
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+
+    release_cursor();
+}
+
+void NativeLayer::release_cursor() {
+    if (reading_cursor == nullptr) { return; }
+
+    for (OGRLayer *current_layer : {layer, ram_layer}) {
+        current_layer->SetSpatialFilter(nullptr);
+        current_layer->SetAttributeFilter(nullptr);
+    }
+
+    // Background readers may have left fields ignored on the disk layer
+    layer->SetIgnoredFields(nullptr);
+
+    reading_cursor = nullptr;
+}
+
+void NativeLayer::touch_cache_entry(GUIntBig id) {
+    auto position = cache_usage_positions.find(id);
+
+    if (position != cache_usage_positions.end()) {
+        cache_usage.splice(cache_usage.begin(), cache_usage, position->second);
+    } else {
+        cache_usage.push_front(id);
+        cache_usage_positions[id] = cache_usage.begin();
+    }
+}
+
+bool NativeLayer::is_evictable(const std::list<std::shared_ptr<Feature>> &features) const {
+    for (const std::shared_ptr<Feature> &feature : features) {
+        if (feature.use_count() > 1 || feature->is_modified || feature->is_deleted) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void NativeLayer::trim_feature_cache() {
+    if (max_cached_features < 0 || feature_cache.size() <= cache_trim_size) { return; }
+
+    ScopedTrace trace("NativeLayer::trim_feature_cache");
+
+    // Walk from the least recently used entry towards the most recently used one
+    auto usage = cache_usage.end();
+
+    while (usage != cache_usage.begin() &&
+           feature_cache.size() > static_cast<size_t>(max_cached_features)) {
+        --usage;
+
+        auto cached = feature_cache.find(*usage);
+        if (!is_evictable(cached->second)) { continue; }
+
+        PerformanceCounters::add_cached_features(-static_cast<int64_t>(cached->second.size()));
+        feature_cache.erase(cached);
+        cache_usage_positions.erase(*usage);
+
+        // Returns the older neighbour, so the next step continues with the newer one
+        usage = cache_usage.erase(usage);
+    }
+
+    cache_trim_size = std::max(feature_cache.size(), static_cast<size_t>(max_cached_features)) +
+                      MIN_CACHE_TRIM_INTERVAL;
+}
+
+void NativeLayer::set_max_cached_features(int max_features) {
+    lock_layers();
+
+    max_cached_features = max_features;
+
+    // Trim right away instead of waiting for the cache to grow
+    cache_trim_size = 0;
+    trim_feature_cache();
+
+    layer_mutex.unlock();
+}
+
+int NativeLayer::get_max_cached_features() {
+    return max_cached_features;
+}
+
 void NativeLayer::write_feature_cache_to_ram_layer() {
-    ram_layer->ResetReading();
+    std::set<int64_t> changed_ids;
+    std::vector<std::shared_ptr<Feature>> changed_features;
 
-    // Iterate over RAM layer, update with cached features
-    // Not the other way around because we'll usually have far more cached features than total features in the RAM layer
-    OGRFeature *feature = ram_layer->GetNextFeature();
+    {
+        std::lock_guard<std::mutex> lock(changes->mutex);
+        changed_ids.swap(changes->ids);
 
-    while (feature != nullptr) {
-        if (feature_cache.find(feature->GetFID()) != feature_cache.end()) {
-            OGRErr error = ram_layer->UpsertFeature(feature_cache[feature->GetFID()].front()->feature);
+        // Features which are changed again from now on are marked as dirty again, even while
+        // they are written below
+        for (int64_t id : changed_ids) {
+            auto cached = feature_cache.find(id);
+            if (cached == feature_cache.end()) { continue; }
+
+            for (const std::shared_ptr<Feature> &feature : cached->second) {
+                feature->is_dirty = false;
+            }
+
+            unsaved_ids.insert(id);
+
+            // Changes of features from the disk layer stay in the cache until they are saved
+            if (ram_feature_ids.count(id) > 0) {
+                changed_features.push_back(cached->second.front());
+            }
         }
+    }
+
+    for (const std::shared_ptr<Feature> &feature : changed_features) {
+        OGRErr error = ram_layer->UpsertFeature(feature->feature);
+    }
+}
+
+NativeLayer::~NativeLayer() {
+    // A background save is finished rather than discarded
+    if (save_thread.joinable()) { save_thread.join(); }
+
+    // Stop building the spatial and attribute indices, since they would access this object
+    is_closing = true;
+    if (spatial_index_thread.joinable()) { spatial_index_thread.join(); }
+    if (attribute_index_thread.joinable()) { attribute_index_thread.join(); }
 
-        feature = ram_layer->GetNextFeature();
+    for (const auto &entry : feature_cache) {
+        PerformanceCounters::add_cached_features(-static_cast<int64_t>(entry.second.size()));
     }
 }
 
 void NativeLayer::save_override() {
-    layer_mutex.lock();
+    if (save_thread.joinable()) { save_thread.join(); }
 
-    write_feature_cache_to_ram_layer();
+    lock_layers();
+    saving = true;
+    SaveSnapshot snapshot = take_save_snapshot();
+    layer_mutex.unlock();
 
-    // Write changes from RAM layer into this layer
-    ram_layer->ResetReading();            // Reset the reading cursor
-    ram_layer->SetSpatialFilter(nullptr); // Reset the spatial filter
-    OGRFeature *current_feature = ram_layer->GetNextFeature();
+    write_unsaved_features(std::move(snapshot));
+}
+
+void NativeLayer::save_override_in_background() {
+    lock_layers();
+
+    if (!saving) {
+        // The previous save has finished and is about to end, so this doesn't block
+        if (save_thread.joinable()) { save_thread.join(); }
+
+        saving = true;
+
+        // The copies are taken on this thread, since the features are changed on it without the
+        // layer_mutex
+        save_thread = std::thread(&NativeLayer::write_unsaved_features, this,
+                                  take_save_snapshot());
+    }
+
+    layer_mutex.unlock();
+}
+
+bool NativeLayer::is_saving() {
+    return saving;
+}
+
+float NativeLayer::get_save_progress() {
+    if (!saving) { return 1.0f; }
+
+    int total = save_feature_count;
+    if (total == 0) { return 0.0f; }
+
+    return static_cast<float>(saved_feature_count) / total;
+}
+
+NativeLayer::SaveSnapshot NativeLayer::take_save_snapshot() {
+    ScopedTrace trace("NativeLayer::take_save_snapshot");
+
+    saved_feature_count = 0;
+    save_feature_count = 0;
+
+    write_feature_cache_to_ram_layer();
 
     // TODO: Add/remove fields created/removed in ram_layer to layer
 
-    while (current_feature != nullptr) {
-        if (current_feature->GetFID() <= layer->GetFeatureCount()) {
-            OGRErr error = layer->SetFeature(current_feature);
-        } else {
-            OGRErr error = layer->CreateFeature(current_feature);
+    // Copies of the features are written, so that they can be changed again meanwhile
+    SaveSnapshot snapshot;
+
+    for (GUIntBig id : unsaved_ids) {
+        auto cached = feature_cache.find(id);
+        bool is_cached = cached != feature_cache.end();
+
+        if (is_cached && cached->second.front()->is_deleted) {
+            snapshot.discarded_ids.push_back(id);
+            continue;
         }
 
-        current_feature = ram_layer->GetNextFeature();
+        // New features are read from the RAM layer, which also has the ones that
+        // clear_feature_cache removed from the cache. Changed disk features stay cached.
+        OGRFeature *feature = nullptr;
+        if (ram_feature_ids.count(id) > 0) {
+            feature = ram_layer->GetFeature(id);
+        } else if (is_cached) {
+            feature = cached->second.front()->feature->Clone();
+        }
+
+        // Stays unsaved rather than being dropped
+        if (feature == nullptr) { continue; }
+
+        // The parts of multi-geometries are separate Features, which can't be written back yet
+        const OGRGeometry *geometry = feature->GetGeometryRef();
+        OGRwkbGeometryType type =
+            geometry != nullptr ? wkbFlatten(geometry->getGeometryType()) : wkbNone;
+        if (type == wkbMultiLineString || type == wkbMultiPolygon) {
+            OGRFeature::DestroyFeature(feature);
+            snapshot.discarded_ids.push_back(id);
+            continue;
+        }
+
+        snapshot.features.push_back(feature);
+        snapshot.saved_ids.push_back(id);
     }
 
-    layer->SyncToDisk();
+    for (const std::vector<GUIntBig> &ids : {snapshot.saved_ids, snapshot.discarded_ids}) {
+        for (GUIntBig id : ids) {
+            unsaved_ids.erase(id);
+        }
+    }
+
+    save_feature_count = snapshot.features.size();
+
+    return snapshot;
+}
+
+void NativeLayer::write_unsaved_features(SaveSnapshot snapshot) {
+    ScopedPerformanceTimer timer(PerformanceCounters::SAVE_OVERRIDE);
+    ScopedTrace trace("NativeLayer::save_override");
+    lock_layers();
+
+    // E.g. GeoPackages would otherwise use one implicit transaction per feature
+    bool has_transaction = layer->StartTransaction() == OGRERR_NONE;
+
+    std::vector<GUIntBig> created_ids;
+
+    // Features which couldn't be written are saved again next time
+    std::vector<GUIntBig> failed_ids;
+
+    layer_mutex.unlock();
+
+    for (size_t begin = 0; begin < snapshot.features.size(); begin += SAVE_CHUNK_SIZE) {
+        size_t end = std::min(begin + SAVE_CHUNK_SIZE, snapshot.features.size());
+
+        lock_layers();
+
+        for (size_t i = begin; i < end; i++) {
+            GUIntBig id = snapshot.saved_ids[i];
+            OGRErr error;
+
+            if (ram_feature_ids.count(id) > 0 && saved_ram_feature_ids.count(id) == 0) {
+                error = layer->CreateFeature(snapshot.features[i]);
+
+                if (error == OGRERR_NONE) {
+                    saved_ram_feature_ids.insert(id);
+                    created_ids.push_back(id);
+                }
+            } else {
+                error = layer->SetFeature(snapshot.features[i]);
+            }
+
+            if (error != OGRERR_NONE) {
+                std::cout << "Error saving feature " << id << ": " << error << std::endl;
+                failed_ids.push_back(id);
+            }
+
+            OGRFeature::DestroyFeature(snapshot.features[i]);
+        }
+
+        layer_mutex.unlock();
+
+        saved_feature_count = end;
+    }
+
+    lock_layers();
+
+    if (has_transaction && layer->CommitTransaction() != OGRERR_NONE) {
+        std::cout << "Error committing the saved features of layer " << layer->GetName()
+                  << std::endl;
+
+        // Nothing was written, so the features are saved again next time
+        for (GUIntBig id : created_ids) {
+            saved_ram_feature_ids.erase(id);
+        }
+
+        // The features are still marked as modified, so they weren't evicted meanwhile
+        for (GUIntBig id : snapshot.saved_ids) {
+            unsaved_ids.insert(id);
+        }
+    } else {
+        layer->SyncToDisk();
+
+        // Keeps them marked as modified below
+        for (GUIntBig id : failed_ids) {
+            unsaved_ids.insert(id);
+        }
+
+        // The saved state is on disk now, so the cached features may be evicted again unless they
+        // were changed while saving
+        std::lock_guard<std::mutex> lock(changes->mutex);
+
+        for (const std::vector<GUIntBig> &ids : {snapshot.saved_ids, snapshot.discarded_ids}) {
+            for (GUIntBig id : ids) {
+                auto cached = feature_cache.find(id);
+                if (cached == feature_cache.end() || unsaved_ids.count(id) > 0) { continue; }
+
+                for (const std::shared_ptr<Feature> &feature : cached->second) {
+                    if (!feature->is_dirty) { feature->is_modified = false; }
+                }
+            }
+        }
+
+        // The spatial index no longer matches the disk layer. It is rebuilt on the next query; an
+        // index which is currently being built is discarded once it is done.
+        disk_generation++;
+
+        if (spatial_index_state == READY) {
+            spatial_index.reset();
+            spatial_index_state = NOT_STARTED;
+        }
+
+        // The attribute indices are rebuilt right away, since they were requested explicitly
+        for (auto &entry : attribute_indices) {
+            if (entry.second.state == READY) { queue_attribute_index(entry.first); }
+        }
+
+        clear_attribute_cache();
+    }
+
+    saving = false;
 
     layer_mutex.unlock();
 }
 
 void NativeLayer::save_modified_layer(std::string path) {
-    layer_mutex.lock();
+    lock_layers();
 
     GDALDriver *out_driver = (GDALDriver *)GDALGetDriverByName("GPKG");
     GDALDataset *out_dataset = out_driver->Create(path.c_str(), 0, 0, 0, GDT_Unknown, nullptr);
@@ -166,7 +468,7 @@ std::shared_ptr<Feature> NativeLayer::create_feature() {
         feature = std::make_shared<Feature>(new_feature);
     }
 
-    layer_mutex.lock();
+    lock_layers();
 
     // Generate a new ID based on the highest ID within the original data plus the highest added ID
     GUIntBig id = disk_feature_count + ram_feature_count;
@@ -186,7 +488,19 @@ std::shared_ptr<Feature> NativeLayer::create_feature() {
     const OGRErr error = ram_layer->CreateFeature(new_feature);
     // (No need to check that error, we're in a self-owned in-RAM dataset)
 
+    // New features only exist in the cache and the RAM layer until they are saved
+    feature->is_modified = true;
+    feature->changes = changes;
+    feature->cache_id = id;
+    ram_feature_ids.insert(id);
+    unsaved_ids.insert(id);
+
     feature_cache[id] = std::list<std::shared_ptr<Feature> >{feature};
+    touch_cache_entry(id);
+    PerformanceCounters::add_cached_features(1);
+
+    // The cached values don't have a row for the new feature
+    clear_attribute_cache();
 
     layer_mutex.unlock();
 
@@ -214,6 +528,8 @@ bool NativeLayer::is_feature_deleted(OGRFeature *feature) {
 }
 
 std::list<std::shared_ptr<Feature> > NativeLayer::get_feature_for_ogrfeature(OGRFeature *feature) {
+    ScopedTrace trace("NativeLayer::get_feature_for_ogrfeature");
+
     std::list<std::shared_ptr<Feature> > list = std::list<std::shared_ptr<Feature> >();
 
     // FIXME: This should never happen - would be better to throw an error towards Godot here
@@ -230,6 +546,8 @@ std::list<std::shared_ptr<Feature> > NativeLayer::get_feature_for_ogrfeature(OGR
         // FIXME: This also requires a `delete` on the Feature object!
         cached_feature.remove_if([](const std::shared_ptr<Feature> feature) { return feature->is_deleted; });
 
+        touch_cache_entry(feature->GetFID());
+
         // Since there already is an OGRFeature object inside of the cached Feature, we don't need this one anymore
         OGRFeature::DestroyFeature(feature);
 
@@ -286,8 +604,19 @@ std::list<std::shared_ptr<Feature> > NativeLayer::get_feature_for_ogrfeature(OGR
         }
     }
 
+    // Changes made through the setters are written to the RAM layer lazily
+    for (const std::shared_ptr<Feature> &new_feature : list) {
+        new_feature->changes = changes;
+        new_feature->cache_id = feature->GetFID();
+    }
+
     // Add to the cache and return
     feature_cache[feature->GetFID()] = list;
+    touch_cache_entry(feature->GetFID());
+    PerformanceCounters::add_cached_features(list.size());
+
+    // The new features are referenced by the returned list, so they are not evicted right away
+    trim_feature_cache();
 
     return list;
 }
@@ -307,16 +636,53 @@ ExtentData NativeLayer::get_extent() {
 }
 
 void NativeLayer::clear_feature_cache() {
-    layer_mutex.lock();
+    lock_layers();
 
     write_feature_cache_to_ram_layer();
-    feature_cache.clear();
-    
+
+    for (auto cached = feature_cache.begin(); cached != feature_cache.end();) {
+        // Unsaved changes of disk features only exist in the cache, so those entries are kept.
+        // New features are in the RAM layer, where the save reads them from.
+        bool is_ram_feature = ram_feature_ids.count(cached->first) > 0;
+        bool is_modified = false;
+        bool is_deleted = false;
+
+        for (const std::shared_ptr<Feature> &feature : cached->second) {
+            is_modified |= feature->is_modified;
+            is_deleted |= feature->is_deleted;
+        }
+
+        if (is_modified && !is_ram_feature) {
+            ++cached;
+            continue;
+        }
+
+        // Deleted features aren't saved, which can't be told from the RAM layer later on
+        if (is_deleted) { unsaved_ids.erase(cached->first); }
+
+        PerformanceCounters::add_cached_features(-static_cast<int64_t>(cached->second.size()));
+
+        auto position = cache_usage_positions.find(cached->first);
+        if (position != cache_usage_positions.end()) {
+            cache_usage.erase(position->second);
+            cache_usage_positions.erase(position);
+        }
+
+        cached = feature_cache.erase(cached);
+    }
+
+    cache_trim_size = std::max(feature_cache.size(),
+                               static_cast<size_t>(std::max(max_cached_features.load(), 0))) +
+                      MIN_CACHE_TRIM_INTERVAL;
+    clear_attribute_cache();
+
     layer_mutex.unlock();
 }
 
 std::list<std::shared_ptr<Feature> > NativeLayer::get_feature_by_id(int id) {
-    layer_mutex.lock();
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("NativeLayer::get_feature_by_id");
+    lock_layers();
 
     OGRFeature *ogr_feature = layer->GetFeature(id);
     auto feature = get_feature_for_ogrfeature(ogr_feature);
@@ -327,30 +693,45 @@ std::list<std::shared_ptr<Feature> > NativeLayer::get_feature_by_id(int id) {
 }
 
 std::list<std::shared_ptr<Feature> > NativeLayer::get_features_by_attribute_filter(std::string filter) {
-    layer_mutex.lock();
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("NativeLayer::get_features_by_attribute_filter");
+    lock_layers();
 
     auto list = std::list<std::shared_ptr<Feature> >();
+    std::vector<int64_t> ids;
 
-    layer->ResetReading();            // Reset the reading cursor
-    layer->SetAttributeFilter(filter.c_str()); // Set the attribute filter
+    if (find_in_attribute_index(filter, ids)) {
+        // Return the features in the same order as the layer would
+        std::sort(ids.begin(), ids.end());
 
-    OGRFeature *current_feature = layer->GetNextFeature();
+        for (int64_t id : ids) {
+            OGRFeature *current_feature = layer->GetFeature(id);
+            if (current_feature == nullptr) { continue; }
 
-    while (current_feature != nullptr) {
-        // Add the Feature objects from the next OGRFeature in the layer to the list
-        list.splice(list.end(), get_feature_for_ogrfeature(current_feature));
+            list.splice(list.end(), get_feature_for_ogrfeature(current_feature));
+        }
+    } else {
+        layer->ResetReading();            // Reset the reading cursor
+        layer->SetAttributeFilter(filter.c_str()); // Set the attribute filter
 
-        current_feature = layer->GetNextFeature();
-    }
+        OGRFeature *current_feature = layer->GetNextFeature();
 
-    // Reset attribute filter
-    layer->SetAttributeFilter(nullptr);
+        while (current_feature != nullptr) {
+            // Add the Feature objects from the next OGRFeature in the layer to the list
+            list.splice(list.end(), get_feature_for_ogrfeature(current_feature));
 
-    // Same as above but for in-RAM data
+            current_feature = layer->GetNextFeature();
+        }
+
+        // Reset attribute filter
+        layer->SetAttributeFilter(nullptr);
+    }
+
+    // Same as above but for in-RAM data, which is not indexed
     // TODO: Remove code duplication
     ram_layer->ResetReading();            // Reset the reading cursor
     ram_layer->SetAttributeFilter(filter.c_str()); // Set the attribute filter
-    current_feature = ram_layer->GetNextFeature();
+    OGRFeature *current_feature = ram_layer->GetNextFeature();
 
     while (current_feature != nullptr) {
         // Add the Feature objects from the next OGRFeature in the layer to the list
@@ -368,7 +749,9 @@ std::list<std::shared_ptr<Feature> > NativeLayer::get_features_by_attribute_filt
 }
 
 std::list<std::shared_ptr<Feature> > NativeLayer::get_features() {
-    layer_mutex.lock();
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("NativeLayer::get_features");
+    lock_layers();
 
     auto list = std::list<std::shared_ptr<Feature> >();
 
@@ -401,8 +784,348 @@ std::list<std::shared_ptr<Feature> > NativeLayer::get_features() {
     return list;
 }
 
+std::function<OGRFeature *()> NativeLayer::get_disk_features_inside_geometry(
+    OGRGeometry *geometry) {
+    if (geometry != nullptr && spatial_index_state == NOT_STARTED) {
+        if (layer->TestCapability(OLCFastSpatialFilter) || !layer->TestCapability(OLCRandomRead)) {
+            // The layer has a spatial index of its own, or an index would not help
+            spatial_index_state = UNAVAILABLE;
+        } else {
+            // A previous build which was discarded has already finished, so this doesn't block
+            if (spatial_index_thread.joinable()) { spatial_index_thread.join(); }
+
+            spatial_index_state = BUILDING;
+            spatial_index_thread = std::thread(&NativeLayer::build_spatial_index, this);
+        }
+    }
+
+    if (geometry == nullptr || spatial_index_state != READY) {
+        layer->SetSpatialFilter(geometry);
+        layer->ResetReading();
+
+        return [this]() { return layer->GetNextFeature(); };
+    }
+
+    OGREnvelope envelope;
+    geometry->getEnvelope(&envelope);
+
+    std::vector<int64_t> ids;
+    spatial_index->query(envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY, ids);
+
+    // Return the features in the same order as the layer would
+    std::sort(ids.begin(), ids.end());
+
+    return [this, geometry, ids, next = size_t(0)]() mutable -> OGRFeature * {
+        while (next < ids.size()) {
+            OGRFeature *feature = layer->GetFeature(ids[next++]);
+            if (feature == nullptr) { continue; }
+
+            // The index only compares envelopes, so the exact test of the spatial filter follows
+            const OGRGeometry *feature_geometry = feature->GetGeometryRef();
+            if (feature_geometry != nullptr && geometry->Intersects(feature_geometry)) {
+                return feature;
+            }
+
+            OGRFeature::DestroyFeature(feature);
+        }
+
+        return nullptr;
+    };
+}
+
+bool NativeLayer::read_disk_layer_in_chunks(const void *reader,
+                                            const std::function<bool(OGRFeature *)> &visit,
+                                            char **ignored_fields) {
+    int64_t position = 0;
+    bool is_done = false;
+    bool is_stopped = false;
+
+    // Seeking to the position is linear in it for many drivers, which would make resuming after
+    // every chunk quadratic. Without fast seeking, the reader resumes after the last FID instead,
+    // as long as the features arrive in ascending FID order, and otherwise reads in one pass.
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+    bool can_seek = layer->TestCapability(OLCFastSetNextByIndex);
+    std::string fid_column = layer->GetFIDColumn();
+    layer_mutex.unlock();
+
+    if (fid_column.empty()) { fid_column = "FID"; }
+
+    bool is_fid_ascending = true;
+    GIntBig last_fid = OGRNullFID;
+
+    // Read the layer in chunks so that queries are only blocked for short times
+    while (!is_done && !is_stopped && !is_closing) {
+        PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+
+        if (reading_cursor != reader) {
+            // Another query or cursor has used the layer since the last chunk
+            release_cursor();
+
+            layer->SetSpatialFilter(nullptr);
+            if (ignored_fields != nullptr) {
+                layer->SetIgnoredFields(const_cast<const char **>(ignored_fields));
+            }
+
+            // The filter is removed by release_cursor when another query takes over
+            if (position > 0 && !can_seek) {
+                std::string filter = fid_column + " > " + std::to_string(last_fid);
+                layer->SetAttributeFilter(filter.c_str());
+            }
+
+            layer->ResetReading();
+            if (position > 0 && can_seek) { layer->SetNextByIndex(position); }
+
+            reading_cursor = reader;
+        }
+
+        for (int i = 0; i < BACKGROUND_READ_CHUNK_SIZE || !(can_seek || is_fid_ascending); i++) {
+            OGRFeature *feature = layer->GetNextFeature();
+
+            if (feature == nullptr) {
+                is_done = true;
+                break;
+            }
+
+            position++;
+
+            GIntBig fid = feature->GetFID();
+            if (fid == OGRNullFID || (last_fid != OGRNullFID && fid <= last_fid)) {
+                is_fid_ascending = false;
+            }
+            last_fid = fid;
+
+            if (!visit(feature)) {
+                is_stopped = true;
+                break;
+            }
+        }
+
+        layer_mutex.unlock();
+    }
+
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+    if (reading_cursor == reader) { release_cursor(); }
+    layer_mutex.unlock();
+
+    return is_done;
+}
+
+void NativeLayer::build_spatial_index() {
+    ScopedTrace trace("NativeLayer::build_spatial_index");
+
+    std::vector<PackedRTree::Entry> entries;
+    bool has_ids = true;
+
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+    int generation = disk_generation;
+    layer_mutex.unlock();
+
+    bool is_done = read_disk_layer_in_chunks(&spatial_index, [&](OGRFeature *feature) {
+        // Without IDs, the features can't be read from the index
+        if (feature->GetFID() == OGRNullFID) {
+            has_ids = false;
+        } else {
+            const OGRGeometry *geometry = feature->GetGeometryRef();
+
+            if (geometry != nullptr && !geometry->IsEmpty()) {
+                OGREnvelope envelope;
+                geometry->getEnvelope(&envelope);
+
+                entries.push_back({envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY,
+                                   feature->GetFID()});
+            }
+        }
+
+        OGRFeature::DestroyFeature(feature);
+        return has_ids;
+    });
+
+    std::unique_ptr<PackedRTree> index;
+    if (is_done && has_ids) { index = std::make_unique<PackedRTree>(std::move(entries)); }
+
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+
+    if (!has_ids) {
+        spatial_index_state = UNAVAILABLE;
+    } else if (index != nullptr && generation == disk_generation) {
+        spatial_index = std::move(index);
+        spatial_index_state = READY;
+    } else {
+        spatial_index_state = NOT_STARTED;
+    }
+
+    layer_mutex.unlock();
+}
+
+void NativeLayer::create_attribute_index(std::string name) {
+    lock_layers();
+
+    OGRFeatureDefn *definition = layer->GetLayerDefn();
+    int field_index = definition->GetFieldIndex(name.c_str());
+
+    if (field_index < 0) {
+        layer_mutex.unlock();
+        return;
+    }
+
+    // Filters may use any capitalization of the name, so the disk layer's one is used as the key
+    std::string field_name = definition->GetFieldDefn(field_index)->GetNameRef();
+
+    if (attribute_indices.count(field_name) == 0) {
+        OGRFieldType type = definition->GetFieldDefn(field_index)->GetType();
+        bool is_supported = type == OFTInteger || type == OFTInteger64 || type == OFTReal ||
+                            type == OFTString;
+
+        if (is_supported && layer->TestCapability(OLCRandomRead)) {
+            queue_attribute_index(field_name);
+        } else {
+            attribute_indices[field_name].state = UNAVAILABLE;
+        }
+    }
+
+    layer_mutex.unlock();
+}
+
+bool NativeLayer::has_attribute_index(std::string name) {
+    lock_layers();
+
+    int field_index = layer->GetLayerDefn()->GetFieldIndex(name.c_str());
+    bool is_ready = false;
+
+    if (field_index >= 0) {
+        auto entry =
+            attribute_indices.find(layer->GetLayerDefn()->GetFieldDefn(field_index)->GetNameRef());
+        is_ready = entry != attribute_indices.end() && entry->second.state == READY;
+    }
+
+    layer_mutex.unlock();
+
+    return is_ready;
+}
+
+void NativeLayer::queue_attribute_index(const std::string &name) {
+    AttributeIndexEntry &entry = attribute_indices[name];
+    entry.state = BUILDING;
+    entry.index.reset();
+
+    pending_attribute_indices.push_back(name);
+
+    if (!is_building_attribute_indices) {
+        // The previous thread has emptied the queue and is about to end, so this doesn't block
+        if (attribute_index_thread.joinable()) { attribute_index_thread.join(); }
+
+        is_building_attribute_indices = true;
+        attribute_index_thread = std::thread(&NativeLayer::build_attribute_indices, this);
+    }
+}
+
+void NativeLayer::build_attribute_indices() {
+    while (!is_closing) {
+        PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+
+        if (pending_attribute_indices.empty()) {
+            is_building_attribute_indices = false;
+            layer_mutex.unlock();
+            return;
+        }
+
+        std::string name = pending_attribute_indices.front();
+        pending_attribute_indices.pop_front();
+
+        layer_mutex.unlock();
+
+        build_attribute_index(name);
+    }
+}
+
+void NativeLayer::build_attribute_index(const std::string &name) {
+    ScopedTrace trace("NativeLayer::build_attribute_index");
+
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+    int generation = disk_generation;
+    int field_index = layer->GetLayerDefn()->GetFieldIndex(name.c_str());
+    bool is_numeric = layer->GetLayerDefn()->GetFieldDefn(field_index)->GetType() != OFTString;
+
+    // Only the indexed field is decoded
+    CPLStringList ignored_fields;
+    ignored_fields.AddString("OGR_GEOMETRY");
+    ignored_fields.AddString("OGR_STYLE");
+
+    for (const OGRFieldDefn *field_definition : layer->GetLayerDefn()->GetFields()) {
+        if (name != field_definition->GetNameRef()) {
+            ignored_fields.AddString(field_definition->GetNameRef());
+        }
+    }
+
+    layer_mutex.unlock();
+
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+    std::vector<int64_t> ids;
+    bool has_ids = true;
+
+    bool is_done = read_disk_layer_in_chunks(&attribute_indices, [&](OGRFeature *feature) {
+        // Without IDs, the features can't be read from the index
+        if (feature->GetFID() == OGRNullFID) {
+            has_ids = false;
+        } else if (feature->IsFieldSetAndNotNull(field_index)) {
+            if (is_numeric) {
+                numbers.push_back(feature->GetFieldAsDouble(field_index));
+            } else {
+                strings.emplace_back(feature->GetFieldAsString(field_index));
+            }
+
+            ids.push_back(feature->GetFID());
+        }
+
+        OGRFeature::DestroyFeature(feature);
+        return has_ids;
+    }, ignored_fields.List());
+
+    std::unique_ptr<AttributeIndex> index;
+    if (is_done && has_ids) {
+        index = is_numeric ? std::make_unique<AttributeIndex>(std::move(numbers), std::move(ids))
+                           : std::make_unique<AttributeIndex>(std::move(strings), std::move(ids));
+    }
+
+    PerformanceCounters::lock(layer_mutex, "NativeLayer lock wait");
+
+    AttributeIndexEntry &entry = attribute_indices[name];
+
+    if (!has_ids) {
+        entry.state = UNAVAILABLE;
+    } else if (index != nullptr && generation == disk_generation) {
+        entry.index = std::move(index);
+        entry.state = READY;
+    } else if (!is_closing) {
+        // The disk layer was changed while reading it, so the index is outdated already
+        pending_attribute_indices.push_back(name);
+    }
+
+    layer_mutex.unlock();
+}
+
+bool NativeLayer::find_in_attribute_index(const std::string &filter,
+                                          std::vector<int64_t> &ids) {
+    if (attribute_indices.empty()) { return false; }
+
+    AttributeCondition condition;
+    if (!AttributeCondition::parse(filter, condition)) { return false; }
+
+    OGRFeatureDefn *definition = layer->GetLayerDefn();
+    int field_index = definition->GetFieldIndex(condition.field.c_str());
+    if (field_index < 0) { return false; }
+
+    auto entry = attribute_indices.find(definition->GetFieldDefn(field_index)->GetNameRef());
+    if (entry == attribute_indices.end() || entry->second.state != READY) { return false; }
+
+    return entry->second.index->find(condition, ids);
+}
+
 std::list<std::shared_ptr<Feature> > NativeLayer::get_features_inside_geometry(OGRGeometry *geometry, int max_amount) {
-    layer_mutex.lock();
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("NativeLayer::get_features_inside_geometry");
+    lock_layers();
 
     std::list<std::shared_ptr<Feature> > list = std::list<std::shared_ptr<Feature> >();
 
@@ -410,44 +1133,39 @@ std::list<std::shared_ptr<Feature> > NativeLayer::get_features_inside_geometry(O
     // For this geometry, we have to create a new dataset + layer + feature + geometry because layers can only be
     // intersected with other layers, and layers need a dataset.
 
-    layer->SetSpatialFilter(geometry);
-    layer->ResetReading();
+    std::function<OGRFeature *()> next_disk_feature = get_disk_features_inside_geometry(geometry);
 
     // Put the resulting features into the returned list. We add as many features as were returned
     // unless they're more than the given max_amount.
-    OGRFeature *current_feature = layer->GetNextFeature();
-    int i = 0;
+    while (static_cast<int>(list.size()) < max_amount) {
+        OGRFeature *current_feature = next_disk_feature();
+        if (current_feature == nullptr) { break; }
 
-    while (current_feature != nullptr) {
         // Add the Feature objects from the next OGRFeature in the layer to the list
         list.splice(list.end(), get_feature_for_ogrfeature(current_feature));
-
-        current_feature = layer->GetNextFeature();
-
-        // Exit condition: stop if we've already added the maximum amount of features desired by the caller
-        if (i >= max_amount) break;
     }
 
     // Reset spatial filter
     layer->SetSpatialFilter(nullptr);
 
     // Also check the RAM layer
-    // FIXME: Take care of max_amount here too
     // TODO: Code duplication (similar as in `get_features`)
     write_feature_cache_to_ram_layer();
 
     ram_layer->SetSpatialFilter(geometry);
     ram_layer->ResetReading();
 
-    current_feature = ram_layer->GetNextFeature();
+    while (static_cast<int>(list.size()) < max_amount) {
+        OGRFeature *current_feature = ram_layer->GetNextFeature();
+        if (current_feature == nullptr) { break; }
 
-    while (current_feature != nullptr) {
         // Add the Feature objects from the next OGRFeature in the layer to the list
         list.splice(list.end(), get_feature_for_ogrfeature(current_feature));
-
-        current_feature = ram_layer->GetNextFeature();
     }
 
+    // Multi-geometries may have added more Features than requested
+    if (static_cast<int>(list.size()) > max_amount) { list.resize(max_amount); }
+
     // Reset spatial filter
     ram_layer->SetSpatialFilter(nullptr);
 
@@ -492,7 +1210,450 @@ std::list<std::shared_ptr<Feature>> NativeLayer::get_features_in_square(double t
     return features;
 }
 
+namespace {
+
+/// Appends the vertices of the curve as a new ring, in reverse order if requested
+void append_ring(const OGRSimpleCurve *curve, bool reverse, FeatureColumns &columns) {
+    int point_count = curve->getNumPoints();
+
+    for (int i = 0; i < point_count; i++) {
+        int index = reverse ? point_count - 1 - i : i;
+
+        columns.coordinates.push_back(curve->getX(index));
+        columns.coordinates.push_back(curve->getY(index));
+        columns.coordinates.push_back(curve->getZ(index));
+    }
+
+    columns.ring_offsets.push_back(columns.coordinates.size() / 3);
+}
+
+/// Appends the rings of a point, line or polygon geometry and returns its type
+Feature::GeometryType append_geometry(const OGRGeometry *geometry, FeatureColumns &columns) {
+    if (geometry == nullptr || geometry->IsEmpty()) { return Feature::NONE; }
+
+    OGRwkbGeometryType type = wkbFlatten(geometry->getGeometryType());
+
+    if (type == wkbPoint) {
+        const OGRPoint *point = geometry->toPoint();
+
+        columns.coordinates.push_back(point->getX());
+        columns.coordinates.push_back(point->getY());
+        columns.coordinates.push_back(point->getZ());
+        columns.ring_offsets.push_back(columns.coordinates.size() / 3);
+
+        return Feature::POINT;
+    } else if (type == wkbLineString) {
+        append_ring(geometry->toLineString(), false, columns);
+
+        return Feature::LINE;
+    } else if (type == wkbPolygon) {
+        const OGRPolygon *polygon = geometry->toPolygon();
+        const OGRLinearRing *exterior = polygon->getExteriorRing();
+
+        // Outer rings are returned clockwise, like in PolygonFeature::get_outer_vertices, but
+        // without modifying the geometry
+        append_ring(exterior, !exterior->isClockwise(), columns);
+
+        for (int i = 0; i < polygon->getNumInteriorRings(); i++) {
+            append_ring(polygon->getInteriorRing(i), false, columns);
+        }
+
+        return Feature::POLYGON;
+    }
+
+    return Feature::NONE;
+}
+
+/// Returns the column type which holds the values of the given field
+AttributeColumn::Type get_column_type(const OGRFieldDefn *field_definition) {
+    switch (field_definition->GetType()) {
+    case OFTInteger:
+        return AttributeColumn::INTEGER;
+    case OFTInteger64:
+        return AttributeColumn::INTEGER64;
+    case OFTReal:
+        return AttributeColumn::REAL;
+    default:
+        return AttributeColumn::STRING;
+    }
+}
+
+/// Writes the value of the field with the given index (0 or an empty string if it is not set)
+/// into the given row of the column, which may also be the row after the last one
+void store_attribute(OGRFeature *feature, int index, AttributeColumn &column, size_t row) {
+    bool is_set = index >= 0 && feature->IsFieldSetAndNotNull(index);
+
+    if (column.type == AttributeColumn::INTEGER || column.type == AttributeColumn::INTEGER64) {
+        if (row == column.integers.size()) { column.integers.emplace_back(); }
+        column.integers[row] = is_set ? feature->GetFieldAsInteger64(index) : 0;
+    } else if (column.type == AttributeColumn::REAL) {
+        if (row == column.reals.size()) { column.reals.emplace_back(); }
+        column.reals[row] = is_set ? feature->GetFieldAsDouble(index) : 0.0;
+    } else {
+        if (row == column.strings.size()) { column.strings.emplace_back(); }
+        column.strings[row] = is_set ? feature->GetFieldAsString(index) : "";
+    }
+}
+
+/// Removes all rows after the first row_count ones, together with their rings and vertices
+void truncate_rows(FeatureColumns &columns, size_t row_count) {
+    if (columns.ids.size() <= row_count) { return; }
+
+    size_t ring_count = columns.row_offsets[row_count];
+    size_t vertex_count = columns.ring_offsets[ring_count];
+
+    columns.ids.resize(row_count);
+    columns.geometry_types.resize(row_count);
+    columns.row_offsets.resize(row_count + 1);
+    columns.ring_offsets.resize(ring_count + 1);
+    columns.coordinates.resize(vertex_count * 3);
+
+    // Only the vector corresponding to the type of each column is filled
+    for (AttributeColumn &column : columns.attributes) {
+        if (column.integers.size() > row_count) { column.integers.resize(row_count); }
+        if (column.reals.size() > row_count) { column.reals.resize(row_count); }
+        if (column.strings.size() > row_count) { column.strings.resize(row_count); }
+    }
+}
+
+/// Appends one value to each attribute column. field_indices contains the index of each column's
+/// field in the feature's definition, or -1 if it has no such field.
+void append_attributes(OGRFeature *feature, const std::vector<int> &field_indices,
+                       FeatureColumns &columns) {
+    for (size_t i = 0; i < columns.attributes.size(); i++) {
+        store_attribute(feature, field_indices[i], columns.attributes[i], columns.ids.size() - 1);
+    }
+}
+
+} // namespace
+
+int NativeLayer::append_feature_columns(
+    OGRFeature *feature, FeatureColumns &columns,
+    std::map<const OGRFeatureDefn *, std::vector<int>> &field_indices) {
+    // The field indices are looked up once per feature definition rather than once per feature
+    auto get_field_indices = [&](OGRFeature *ogr_feature) -> const std::vector<int> & {
+        const OGRFeatureDefn *definition = ogr_feature->GetDefnRef();
+        auto found = field_indices.find(definition);
+
+        if (found == field_indices.end()) {
+            std::vector<int> indices;
+
+            for (const AttributeColumn &column : columns.attributes) {
+                indices.push_back(definition->GetFieldIndex(column.name.c_str()));
+            }
+
+            found = field_indices.emplace(definition, std::move(indices)).first;
+        }
+
+        return found->second;
+    };
+
+    auto add_row = [&](int64_t id, const OGRGeometry *geometry, OGRFeature *attributes) {
+        columns.ids.push_back(id);
+        columns.geometry_types.push_back(append_geometry(geometry, columns));
+        columns.row_offsets.push_back(columns.ring_offsets.size() - 1);
+        append_attributes(attributes, get_field_indices(attributes), columns);
+    };
+
+    int row_count = 0;
+
+    auto cached = feature_cache.find(feature->GetFID());
+
+    if (cached != feature_cache.end()) {
+        // Cached features may have been changed, so their data is used instead of the layer's
+        for (const std::shared_ptr<Feature> &cached_feature : cached->second) {
+            if (cached_feature->is_deleted) { continue; }
+
+            add_row(cached_feature->get_id(), cached_feature->get_geometry(),
+                    cached_feature->feature);
+            row_count++;
+        }
+
+        return row_count;
+    }
+
+    const OGRGeometry *geometry = feature->GetGeometryRef();
+
+    if (geometry == nullptr) {
+        add_row(feature->GetFID(), nullptr, feature);
+        return 1;
+    }
+
+    // The same geometry types and IDs as in get_feature_for_ogrfeature
+    std::string geometry_type_name = geometry->getGeometryName();
+
+    if (geometry_type_name == "POINT" || geometry_type_name == "LINESTRING" ||
+        geometry_type_name == "POLYGON") {
+        add_row(feature->GetFID(), geometry, feature);
+        row_count++;
+    } else if (geometry_type_name == "MULTILINESTRING" || geometry_type_name == "MULTIPOLYGON") {
+        const OGRGeometryCollection *collection = geometry->toGeometryCollection();
+
+        for (int i = 0; i < collection->getNumGeometries(); i++) {
+            add_row(feature->GetFID() + 10000000 * i, collection->getGeometryRef(i), feature);
+            row_count++;
+        }
+    }
+
+    return row_count;
+}
+
+FeatureColumns NativeLayer::get_feature_columns_inside_geometry(OGRGeometry *geometry,
+                                                                int max_amount) {
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("NativeLayer::get_feature_columns_inside_geometry");
+    lock_layers();
+
+    FeatureColumns columns;
+
+    // The RAM layer has all fields, including the ones added with add_field
+    for (const OGRFieldDefn *field_definition : ram_layer->GetLayerDefn()->GetFields()) {
+        AttributeColumn column;
+        column.name = field_definition->GetNameRef();
+        column.type = get_column_type(field_definition);
+
+        columns.attributes.emplace_back(std::move(column));
+    }
+
+    std::map<const OGRFeatureDefn *, std::vector<int>> field_indices;
+    int row_count = 0;
+
+    auto read_features = [&](const std::function<OGRFeature *()> &next_feature) {
+        while (row_count < max_amount) {
+            OGRFeature *current_feature = next_feature();
+            if (current_feature == nullptr) { break; }
+
+            row_count += append_feature_columns(current_feature, columns, field_indices);
+
+            OGRFeature::DestroyFeature(current_feature);
+        }
+    };
+
+    read_features(get_disk_features_inside_geometry(geometry));
+    layer->SetSpatialFilter(nullptr);
+
+    // Make changes to cached features of the RAM layer visible to its spatial filter
+    write_feature_cache_to_ram_layer();
+
+    ram_layer->SetSpatialFilter(geometry);
+    ram_layer->ResetReading();
+
+    read_features([this]() { return ram_layer->GetNextFeature(); });
+    ram_layer->SetSpatialFilter(nullptr);
+
+    layer_mutex.unlock();
+
+    // The last multi-geometry may have added more parts than there was room for
+    if (row_count > max_amount) { truncate_rows(columns, max_amount); }
+
+    return columns;
+}
+
+FeatureColumns NativeLayer::get_feature_columns() {
+    return get_feature_columns_inside_geometry(nullptr, std::numeric_limits<int>::max());
+}
+
+FeatureColumns NativeLayer::get_feature_columns_near_position(double pos_x, double pos_y,
+                                                              double radius, int max_amount) {
+    OGRPoint center(pos_x, pos_y);
+    std::unique_ptr<OGRGeometry> circle(center.Buffer(radius));
+
+    return get_feature_columns_inside_geometry(circle.get(), max_amount);
+}
+
+FeatureColumns NativeLayer::get_feature_columns_in_square(double top_left_x, double top_left_y,
+                                                          double size_meters, int max_amount) {
+    OGRLinearRing *square_outline = new OGRLinearRing();
+    square_outline->addPoint(top_left_x, top_left_y);
+    square_outline->addPoint(top_left_x + size_meters, top_left_y);
+    square_outline->addPoint(top_left_x + size_meters, top_left_y - size_meters);
+    square_outline->addPoint(top_left_x, top_left_y - size_meters);
+    square_outline->addPoint(top_left_x, top_left_y);
+
+    OGRPolygon square;
+    square.addRingDirectly(square_outline);
+
+    return get_feature_columns_inside_geometry(&square, max_amount);
+}
+
+int NativeLayer::get_field_index(std::string name) {
+    lock_layers();
+
+    auto cached = field_index_cache.find(name);
+
+    if (cached == field_index_cache.end()) {
+        // Most features are read from the disk layer, whose definition isn't changed by
+        // remove_field. Fields which were added with add_field only exist on the RAM layer.
+        int index = layer->GetLayerDefn()->GetFieldIndex(name.c_str());
+        if (index < 0) { index = ram_layer->GetLayerDefn()->GetFieldIndex(name.c_str()); }
+        cached = field_index_cache.emplace(name, index).first;
+    }
+
+    int index = cached->second;
+
+    layer_mutex.unlock();
+
+    return index;
+}
+
+AttributeValues NativeLayer::get_attribute_values(std::string name) {
+    ScopedPerformanceTimer timer(PerformanceCounters::FEATURE_QUERY);
+    ScopedTrace trace("NativeLayer::get_attribute_values");
+    lock_layers();
+
+    AttributeValues values;
+
+    if (attribute_cache_enabled) {
+        auto cached = attribute_cache.find(name);
+
+        if (cached == attribute_cache.end()) {
+            cached = attribute_cache.emplace(name, read_attribute_values(name)).first;
+        }
+
+        values = cached->second;
+        apply_cached_changes(values, attribute_cache_rows);
+    } else {
+        std::map<int64_t, size_t> rows;
+
+        values = read_attribute_values(name);
+        apply_cached_changes(values, rows);
+    }
+
+    layer_mutex.unlock();
+
+    return values;
+}
+
+AttributeValues NativeLayer::read_attribute_values(const std::string &name) {
+    AttributeValues values;
+    values.column.name = name;
+
+    const OGRFeatureDefn *ram_definition = ram_layer->GetLayerDefn();
+    int ram_index = ram_definition->GetFieldIndex(name.c_str());
+
+    values.column.type = ram_index >= 0 ? get_column_type(ram_definition->GetFieldDefn(ram_index))
+                                        : AttributeColumn::STRING;
+
+    for (OGRLayer *current_layer : {layer, ram_layer}) {
+        const OGRFeatureDefn *definition = current_layer->GetLayerDefn();
+        int index = definition->GetFieldIndex(name.c_str());
+
+        // Only the requested field is needed, so the others and the geometry are not decoded
+        CPLStringList ignored_fields;
+        ignored_fields.AddString("OGR_GEOMETRY");
+        ignored_fields.AddString("OGR_STYLE");
+
+        for (const OGRFieldDefn *field_definition : definition->GetFields()) {
+            if (name != field_definition->GetNameRef()) {
+                ignored_fields.AddString(field_definition->GetNameRef());
+            }
+        }
+
+        current_layer->SetIgnoredFields(const_cast<const char **>(ignored_fields.List()));
+        current_layer->ResetReading();
+
+        OGRFeature *feature = current_layer->GetNextFeature();
+
+        while (feature != nullptr) {
+            values.ids.push_back(feature->GetFID());
+            store_attribute(feature, index, values.column, values.ids.size() - 1);
+
+            OGRFeature::DestroyFeature(feature);
+            feature = current_layer->GetNextFeature();
+        }
+
+        current_layer->SetIgnoredFields(nullptr);
+    }
+
+    return values;
+}
+
+void NativeLayer::apply_cached_changes(AttributeValues &values, std::map<int64_t, size_t> &rows) {
+    std::vector<bool> is_removed;
+
+    for (const auto &entry : feature_cache) {
+        if (entry.second.empty()) { continue; }
+
+        bool is_modified = false;
+        bool is_deleted = false;
+
+        for (const std::shared_ptr<Feature> &feature : entry.second) {
+            is_modified |= feature->is_modified;
+            is_deleted |= feature->is_deleted;
+        }
+
+        if (!is_modified && !is_deleted) { continue; }
+
+        if (rows.empty()) {
+            for (size_t row = 0; row < values.ids.size(); row++) {
+                rows[values.ids[row]] = row;
+            }
+        }
+
+        auto row = rows.find(entry.first);
+
+        if (is_deleted) {
+            if (row == rows.end()) { continue; }
+
+            is_removed.resize(values.ids.size());
+            is_removed[row->second] = true;
+        } else {
+            // All parts of multi-geometries share the same attributes
+            OGRFeature *feature = entry.second.front()->feature;
+            int index = feature->GetFieldIndex(values.column.name.c_str());
+
+            if (row != rows.end()) {
+                store_attribute(feature, index, values.column, row->second);
+            } else {
+                values.ids.push_back(entry.first);
+                store_attribute(feature, index, values.column, values.ids.size() - 1);
+            }
+        }
+    }
+
+    if (is_removed.empty()) { return; }
+
+    // Remove the rows of deleted features, keeping the order of the others
+    auto remove_rows = [&](auto &vector) {
+        if (vector.empty()) { return; }
+
+        size_t kept = 0;
+
+        for (size_t row = 0; row < vector.size(); row++) {
+            if (row < is_removed.size() && is_removed[row]) { continue; }
+            vector[kept++] = std::move(vector[row]);
+        }
+
+        vector.resize(kept);
+    };
+
+    remove_rows(values.column.integers);
+    remove_rows(values.column.reals);
+    remove_rows(values.column.strings);
+    remove_rows(values.ids);
+}
+
+void NativeLayer::set_attribute_cache_enabled(bool enabled) {
+    lock_layers();
+
+    attribute_cache_enabled = enabled;
+    clear_attribute_cache();
+
+    layer_mutex.unlock();
+}
+
+bool NativeLayer::is_attribute_cache_enabled() {
+    return attribute_cache_enabled;
+}
+
+void NativeLayer::clear_attribute_cache() {
+    attribute_cache.clear();
+    attribute_cache_rows.clear();
+}
+
 std::vector<std::string> NativeDataset::get_feature_layer_names() {
+    std::lock_guard<std::mutex> lock(*mutex);
+
     std::vector<std::string> names;
 
     int layer_count = dataset->GetLayerCount();
@@ -511,8 +1672,9 @@ void NativeLayer::add_field(std::string name) {
 
     OGRFieldDefn *field_definition = new OGRFieldDefn(name.c_str(), OGRFieldType::OFTString);
 
-    layer_mutex.lock();
+    lock_layers();
     ram_layer->CreateField(field_definition);
+    field_index_cache.clear();
     layer_mutex.unlock();
 
     delete field_definition;
@@ -522,8 +1684,9 @@ void NativeLayer::remove_field(std::string name) {
     // According to the docs, no feature objects may exist when altering field definitions, so clear the cache first
     clear_feature_cache();
 
-    layer_mutex.lock();
+    lock_layers();
     ram_layer->DeleteField(ram_layer->GetLayerDefn()->GetFieldIndex(name.c_str()));
+    field_index_cache.clear();
     layer_mutex.unlock();
 }
 
@@ -534,7 +1697,7 @@ bool NativeLayer::field_exists(std::string name) {
 std::list<std::string> NativeLayer::get_field_names() {
     std::list<std::string> fields;
 
-    layer_mutex.lock();
+    lock_layers();
 
     for(const OGRFieldDefn *field_definition : ram_layer->GetLayerDefn()->GetFields()) {
         fields.emplace_back(field_definition->GetNameRef());
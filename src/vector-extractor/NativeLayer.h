@@ -1,22 +1,60 @@
+#ifndef VECTOREXTRACTOR_NATIVELAYER_H
+#define VECTOREXTRACTOR_NATIVELAYER_H
+
+#include "AttributeIndex.h"
 #include "Feature.h"
+#include "FeatureColumns.h"
 #include "LineFeature.h"
+#include "PackedRTree.h"
 #include "gdal-includes.h"
 #include "util.h"
+#include <atomic>
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <thread>
+
+class FeatureCursor;
+class NativeDataset;
 
 class NativeLayer {
+    friend class FeatureCursor;
+
   public:
-    NativeLayer(OGRLayer *new_layer);
+    /// Creates a NativeLayer for a layer of the given dataset, which is kept open as long as the
+    /// NativeLayer exists. The dataset's mutex is used as the layer_mutex.
+    NativeLayer(OGRLayer *new_layer, std::shared_ptr<const NativeDataset> dataset);
 
-    ~NativeLayer() = default;
+    ~NativeLayer();
 
     bool is_valid() const;
 
+    /// Writes the cached features of the RAM layer which were changed since the last call to the
+    /// RAM layer, so that GDAL's filters and save_override see the changes. Features which are
+    /// unchanged are skipped, so this is cheap when nothing was edited.
     void write_feature_cache_to_ram_layer();
 
+    /// Writes the features which were created or changed since the last save to the disk layer,
+    /// overriding its data. They are written within one transaction if the layer supports it, in
+    /// chunks so that queries can continue in between. Waits for a background save to finish
+    /// first. Changes to parts of multi-geometries and deleted features are not saved; such parts
+    /// may be evicted from the cache afterwards like saved features. Features which GDAL fails to
+    /// write are reported on stdout and saved again next time.
     void save_override();
 
+    /// Like save_override, but saves on a background thread. Only copying the unsaved features
+    /// happens on the calling thread. Does nothing if a save is already running. Features which
+    /// are changed while saving are saved next time.
+    void save_override_in_background();
+
+    bool is_saving();
+
+    /// Returns the fraction of the features which the running save has written, or 1 if no save
+    /// is running.
+    float get_save_progress();
+
     void save_modified_layer(std::string path);
 
     ExtentData get_extent();
@@ -34,8 +72,33 @@ class NativeLayer {
 
     std::list<std::string> get_field_names();
 
-    // TODO: Add something like `forget_feature(Feature)` so that the cache can be cleared (and the
-    // memory freed) by the user
+    /// Returns the index of the field with the given name for the typed getters of Feature, or -1
+    /// if there is none. Indices are looked up once and kept until fields are added or removed.
+    /// They refer to the disk layer's definition, which is also the RAM layer's one unless fields
+    /// were removed; fields which only exist on the RAM layer have their RAM layer index.
+    int get_field_index(std::string name);
+
+    /// Returns the values of the attribute with the given name for all features which are not
+    /// deleted, including unsaved changes.
+    /// With the attribute cache enabled, the values which were read from the layers are kept, so
+    /// that following calls only need to apply the changes of cached features.
+    AttributeValues get_attribute_values(std::string name);
+
+    /// Enables or disables the attribute cache used by get_attribute_values. Disabling it frees
+    /// the cached values. The cache is also cleared when features are created or saved, and when
+    /// fields are added or removed.
+    void set_attribute_cache_enabled(bool enabled);
+
+    bool is_attribute_cache_enabled();
+
+    /// Sets how many features are kept in the feature cache when nothing else references them, so
+    /// that querying the same area again returns the same Features without reading them again.
+    /// Beyond that, the least recently used ones are evicted. Features which are still referenced,
+    /// modified, deleted or newly created (and not saved yet) are never evicted. Multi-geometries
+    /// count as one feature. Negative values disable eviction.
+    void set_max_cached_features(int max_features);
+
+    int get_max_cached_features();
 
     /// Return all features, regardless of what the geometry is (or if there even is geometry).
     /// Note that this means that no geometry will be available in those features - this should only
@@ -59,6 +122,18 @@ class NativeLayer {
                                                   double top_left_y, double size_meters,
                                                   int max_amount);
 
+    /// Return all features in a columnar layout instead of as Feature objects. Cached features are
+    /// included with their unsaved changes, but no new Features are created or cached.
+    FeatureColumns get_feature_columns();
+
+    /// Like `get_features_near_position`, but in a columnar layout (see `get_feature_columns`).
+    FeatureColumns get_feature_columns_near_position(double pos_x, double pos_y, double radius,
+                                                     int max_amount);
+
+    /// Like `get_features_in_square`, but in a columnar layout (see `get_feature_columns`).
+    FeatureColumns get_feature_columns_in_square(double top_left_x, double top_left_y,
+                                                 double size_meters, int max_amount);
+
     /// Returns the feature corresponding to the given OGRFeature: Either the cached one, or if
     /// there is none, a new one (then placed within the cache).
     /// Takes ownership of the passed OGRFeature, deleting it if it is not required thanks to a
@@ -69,21 +144,41 @@ class NativeLayer {
     std::list<std::shared_ptr<Feature> > get_feature_by_id(int id);
 
     /// Filter the features of the layer by a given SQL-like query, e.g. "attributename < 1000"
+    /// Filters on a single attribute of the disk layer (see AttributeCondition::parse) are answered
+    /// by its attribute index once it is ready, all others are evaluated by GDAL. Like GDAL's
+    /// filter, the index compares the values on disk, not unsaved changes of cached features.
     std::list<std::shared_ptr<Feature> > get_features_by_attribute_filter(std::string filter);
 
+    /// Starts building an index of the given attribute of the disk layer in the background, which
+    /// get_features_by_attribute_filter uses once it is ready. Only integer, real and string fields
+    /// can be indexed, and only on layers which support reading features by ID. The index is
+    /// rebuilt in the background after save_override; until then, GDAL evaluates the filters.
+    /// Integers are compared as doubles, so values beyond 2^53 may not be told apart.
+    void create_attribute_index(std::string name);
+
+    /// Returns true if the index of the given attribute is ready to be used
+    bool has_attribute_index(std::string name);
+
     /// Removes all entries from the feature cache. Make sure this is not called when features exist
     /// which need to remain synchronized (signals across different origins)
+    /// Changed features of the disk layer are kept until they are saved; new features are saved
+    /// from the RAM layer.
     void clear_feature_cache();
 
     bool is_feature_deleted(OGRFeature *feature);
 
+    /// The dataset of the layer. Declared first so that it is released last, after the background
+    /// threads were joined and all features were destroyed.
+    std::shared_ptr<const NativeDataset> dataset;
+
     OGRLayer *layer;
     OGRLayer *ram_layer;
 
     /// Keeps track of all features which are in use due to having been returned, in order to ensure
     /// that we don't return two different Feature instances pointing to the same data. That way,
     /// updates to features don't need to be written anywhere: they exist within the Features of the
-    /// feature cache.
+    /// feature cache. Features are only evicted once that is not observable, see
+    /// `set_max_cached_features`.
     ///
     /// A list of Feature pointers is used for the case of multi-features (e.g. MULTILINESTRING),
     /// where one OGRFeature corresponds to multiple of our Features. Usually though, each list has
@@ -96,5 +191,180 @@ class NativeLayer {
   private:
     std::list<std::shared_ptr<Feature> > get_features_inside_geometry(OGRGeometry *geometry, int max_amount);
 
-    std::mutex layer_mutex;
-};
\ No newline at end of file
+    /// Returns the features of both layers within the given geometry (or all features if it is
+    /// null) in a columnar layout, with at most max_amount rows.
+    FeatureColumns get_feature_columns_inside_geometry(OGRGeometry *geometry, int max_amount);
+
+    /// Appends the rows of the given OGRFeature to the columns, using the cached Features instead
+    /// if there are any. Does not take ownership of the OGRFeature. Returns the number of rows.
+    int append_feature_columns(OGRFeature *feature, FeatureColumns &columns,
+                               std::map<const OGRFeatureDefn *, std::vector<int>> &field_indices);
+
+    /// Returns a function which returns the next feature of the disk layer which intersects with
+    /// the given geometry (or any feature if it is null), and nullptr at the end. The caller takes
+    /// ownership of the features and must reset the disk layer's spatial filter afterwards.
+    /// Uses the spatial index if it is ready, otherwise the layer's spatial filter. The first call
+    /// with a geometry starts building the index if the layer has no fast spatial filter.
+    /// The layer_mutex must be locked while the function is used.
+    std::function<OGRFeature *()> get_disk_features_inside_geometry(OGRGeometry *geometry);
+
+    /// Copies of the unsaved features, which a save writes to the disk layer
+    struct SaveSnapshot {
+        std::vector<OGRFeature *> features;
+        std::vector<GUIntBig> saved_ids;
+
+        /// Changed parts of multi-geometries and deleted features, which aren't written
+        std::vector<GUIntBig> discarded_ids;
+    };
+
+    /// Copies the unsaved features and removes them from unsaved_ids. Must be called on the thread
+    /// which changes the features, with the layer_mutex locked.
+    SaveSnapshot take_save_snapshot();
+
+    /// Writes the features of the snapshot to the disk layer, see save_override, and destroys
+    /// them. saving must be set.
+    void write_unsaved_features(SaveSnapshot snapshot);
+
+    /// Reads all features of the disk layer in chunks of BACKGROUND_READ_CHUNK_SIZE, locking the
+    /// layer_mutex only while a chunk is read, and passes them to visit, which takes ownership.
+    /// Layers which can't resume cheaply (by fast seeking or after the last FID) are read in one
+    /// chunk.
+    /// Stops early if visit returns false or the layer is being closed. The reader is used as the
+    /// reading_cursor while the layer's read position belongs to this function.
+    /// If ignored_fields is given, those fields (as for OGRLayer::SetIgnoredFields) are not read;
+    /// they are only ignored while this function is the reading_cursor.
+    /// Returns true if all features were read. Meant for background threads.
+    bool read_disk_layer_in_chunks(const void *reader,
+                                   const std::function<bool(OGRFeature *)> &visit,
+                                   char **ignored_fields = nullptr);
+
+    /// Reads the envelopes of all features of the disk layer and builds the spatial index from
+    /// them. Runs on the spatial_index_thread.
+    void build_spatial_index();
+
+    /// Marks the attribute index as BUILDING and queues it for the attribute_index_thread, which
+    /// is started if it isn't running. The layer_mutex must be locked.
+    void queue_attribute_index(const std::string &name);
+
+    /// Builds the queued attribute indices one after the other until the queue is empty. Runs on
+    /// the attribute_index_thread.
+    void build_attribute_indices();
+
+    /// Reads the values of the attribute from the disk layer and builds its index
+    void build_attribute_index(const std::string &name);
+
+    /// Appends the IDs of the disk layer's features which match the filter to ids and returns
+    /// true if the filter can be answered by a ready attribute index. The layer_mutex must be
+    /// locked.
+    bool find_in_attribute_index(const std::string &filter, std::vector<int64_t> &ids);
+
+    /// Reads the values of the attribute from both layers, ignoring cached features
+    AttributeValues read_attribute_values(const std::string &name);
+
+    /// Applies the changes and deletions of cached features to the values. rows contains the row
+    /// of each ID; it is built if it is empty and there are any changes.
+    void apply_cached_changes(AttributeValues &values, std::map<int64_t, size_t> &rows);
+
+    /// Removes all values from the attribute cache, since they no longer match the layers
+    void clear_attribute_cache();
+
+    /// Marks the cache entry with the given ID as the most recently used one
+    void touch_cache_entry(GUIntBig id);
+
+    /// Returns true if the Features are only referenced by the cache and have no unsaved changes
+    bool is_evictable(const std::list<std::shared_ptr<Feature>> &features) const;
+
+    /// Evicts the least recently used evictable entries until there are at most
+    /// max_cached_features. Since referenced or modified entries can't be evicted, the cache is
+    /// only scanned again once it has grown by MIN_CACHE_TRIM_INTERVAL entries since the last time.
+    void trim_feature_cache();
+
+    /// Locks the layer_mutex and removes the filters which a cursor may have left on the layers.
+    void lock_layers();
+
+    /// Removes the filters of the cursor which is currently reading, if any. It will seek again
+    /// when it continues reading.
+    void release_cursor();
+
+    /// The mutex of the dataset, which is shared by all of its layers since they use the same
+    /// connection. Background threads of this layer therefore never run at the same time as
+    /// queries on other layers of the dataset.
+    std::mutex &layer_mutex;
+
+    static constexpr int DEFAULT_MAX_CACHED_FEATURES = 10000;
+    static constexpr size_t MIN_CACHE_TRIM_INTERVAL = 256;
+
+    /// Atomic since get_max_cached_features reads it without locking the layer_mutex
+    std::atomic<int> max_cached_features{DEFAULT_MAX_CACHED_FEATURES};
+    size_t cache_trim_size = DEFAULT_MAX_CACHED_FEATURES + MIN_CACHE_TRIM_INTERVAL;
+
+    /// Field indices by name, as returned by get_field_index
+    std::map<std::string, int> field_index_cache;
+
+    bool attribute_cache_enabled = false;
+
+    /// The values read by get_attribute_values by attribute name, without cached changes
+    std::map<std::string, AttributeValues> attribute_cache;
+
+    /// The row of each ID in the values of the attribute_cache, which are the same for all of them
+    std::map<int64_t, size_t> attribute_cache_rows;
+
+    /// The IDs of cached features which were changed since write_feature_cache_to_ram_layer, shared
+    /// with the features
+    std::shared_ptr<FeatureChanges> changes = std::make_shared<FeatureChanges>();
+
+    /// The IDs of the features which were created on the RAM layer
+    std::set<GUIntBig> ram_feature_ids;
+
+    /// The IDs of the features which were created on the RAM layer and have been saved since
+    std::set<GUIntBig> saved_ram_feature_ids;
+
+    /// The IDs of the feature cache's entries which were created or changed since the last save
+    std::set<GUIntBig> unsaved_ids;
+
+    /// The number of features which a save writes per lock of the layer_mutex
+    static constexpr size_t SAVE_CHUNK_SIZE = 1024;
+
+    std::thread save_thread;
+    std::atomic<bool> saving{false};
+    std::atomic<int> saved_feature_count{0};
+    std::atomic<int> save_feature_count{0};
+
+    /// The IDs of the feature cache's entries, from the most to the least recently used one
+    std::list<GUIntBig> cache_usage;
+    std::map<GUIntBig, std::list<GUIntBig>::iterator> cache_usage_positions;
+
+    /// The cursor (or the spatial index builder) whose filters and read position are currently set
+    /// on the layers
+    const void *reading_cursor = nullptr;
+
+    enum IndexState { NOT_STARTED, BUILDING, READY, UNAVAILABLE };
+
+    /// The number of features which background readers read per lock of the layer_mutex
+    static constexpr int BACKGROUND_READ_CHUNK_SIZE = 4096;
+
+    /// Envelopes of the features on the disk layer by FID, for layers without a fast spatial filter
+    std::unique_ptr<PackedRTree> spatial_index;
+    IndexState spatial_index_state = NOT_STARTED;
+    std::thread spatial_index_thread;
+
+    struct AttributeIndexEntry {
+        IndexState state;
+        std::unique_ptr<AttributeIndex> index;
+    };
+
+    /// The requested attribute indices by the field name of the disk layer
+    std::map<std::string, AttributeIndexEntry> attribute_indices;
+
+    /// The names of the attribute indices which the attribute_index_thread is going to build
+    std::list<std::string> pending_attribute_indices;
+    bool is_building_attribute_indices = false;
+    std::thread attribute_index_thread;
+
+    std::atomic<bool> is_closing{false};
+
+    /// Incremented whenever the disk layer is changed, so that an index of older data is discarded
+    int disk_generation = 0;
+};
+
+#endif // VECTOREXTRACTOR_NATIVELAYER_H
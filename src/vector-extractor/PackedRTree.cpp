@@ -0,0 +1,97 @@
+#include "PackedRTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+PackedRTree::PackedRTree(std::vector<Entry> entries) : nodes(std::move(entries)) {
+    if (nodes.empty()) { return; }
+
+    level_offsets.push_back(0);
+
+    size_t level_begin = 0;
+    size_t level_end = nodes.size();
+
+    while (true) {
+        // Sorting a level doesn't affect its children, since nodes refer to them by index
+        sort_tiles(nodes.begin() + level_begin, nodes.begin() + level_end);
+        level_offsets.push_back(level_end);
+
+        if (level_end - level_begin == 1) { break; }
+
+        // Each consecutive group of nodes gets a parent covering all of them
+        for (size_t group = level_begin; group < level_end; group += NODE_SIZE) {
+            Entry parent = nodes[group];
+            parent.id = group;
+
+            for (size_t child = group + 1; child < std::min(group + NODE_SIZE, level_end);
+                 child++) {
+                parent.min_x = std::min(parent.min_x, nodes[child].min_x);
+                parent.min_y = std::min(parent.min_y, nodes[child].min_y);
+                parent.max_x = std::max(parent.max_x, nodes[child].max_x);
+                parent.max_y = std::max(parent.max_y, nodes[child].max_y);
+            }
+
+            nodes.push_back(parent);
+        }
+
+        level_begin = level_end;
+        level_end = nodes.size();
+    }
+}
+
+void PackedRTree::sort_tiles(std::vector<Entry>::iterator begin,
+                             std::vector<Entry>::iterator end) {
+    size_t count = end - begin;
+    size_t group_count = (count + NODE_SIZE - 1) / NODE_SIZE;
+    size_t slice_count = static_cast<size_t>(std::ceil(std::sqrt(group_count)));
+    size_t slice_size = slice_count * NODE_SIZE;
+
+    // Centers are compared as sums to avoid the division
+    std::sort(begin, end, [](const Entry &a, const Entry &b) {
+        return a.min_x + a.max_x < b.min_x + b.max_x;
+    });
+
+    for (size_t slice = 0; slice < count; slice += slice_size) {
+        std::sort(begin + slice, begin + std::min(slice + slice_size, count),
+                  [](const Entry &a, const Entry &b) {
+                      return a.min_y + a.max_y < b.min_y + b.max_y;
+                  });
+    }
+}
+
+void PackedRTree::query(double min_x, double min_y, double max_x, double max_y,
+                        std::vector<int64_t> &result) const {
+    if (nodes.empty()) { return; }
+
+    // Nodes to visit as (node index, level), starting with the root
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(nodes.size() - 1, level_offsets.size() - 2);
+
+    while (!stack.empty()) {
+        auto [node, level] = stack.back();
+        stack.pop_back();
+
+        const Entry &entry = nodes[node];
+
+        if (entry.max_x < min_x || entry.min_x > max_x || entry.max_y < min_y ||
+            entry.min_y > max_y) {
+            continue;
+        }
+
+        if (level == 0) {
+            result.push_back(entry.id);
+            continue;
+        }
+
+        size_t child_begin = entry.id;
+        size_t child_end = std::min(child_begin + NODE_SIZE, level_offsets[level]);
+
+        for (size_t child = child_begin; child < child_end; child++) {
+            stack.emplace_back(child, level - 1);
+        }
+    }
+}
+
+size_t PackedRTree::size() const {
+    return level_offsets.empty() ? 0 : level_offsets[1];
+}
@@ -0,0 +1,48 @@
+#ifndef VECTOREXTRACTOR_PACKEDRTREE_H
+#define VECTOREXTRACTOR_PACKEDRTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// A static R-tree of bounding boxes, bulk-loaded with the Sort-Tile-Recursive algorithm.
+/// All nodes are stored in one flat array, level by level, so that building it needs a few sorts
+/// and querying it touches little memory. It can't be changed after being built.
+class PackedRTree {
+  public:
+    struct Entry {
+        double min_x;
+        double min_y;
+        double max_x;
+        double max_y;
+
+        /// For leaves, the ID given by the user; for inner nodes, the index of the first child
+        int64_t id;
+    };
+
+    /// Builds the tree from the given bounding boxes and their IDs.
+    explicit PackedRTree(std::vector<Entry> entries);
+
+    /// Appends the IDs of all entries whose bounding boxes intersect with the given one.
+    void query(double min_x, double min_y, double max_x, double max_y,
+               std::vector<int64_t> &result) const;
+
+    /// Returns the number of entries (not nodes) in the tree.
+    size_t size() const;
+
+  private:
+    /// The number of children per node
+    static constexpr size_t NODE_SIZE = 16;
+
+    /// Sorts the nodes in the given range so that each consecutive group of NODE_SIZE nodes
+    /// covers a small area: first into vertical slices by x, then by y within each slice.
+    static void sort_tiles(std::vector<Entry>::iterator begin, std::vector<Entry>::iterator end);
+
+    /// The leaves, followed by each level of inner nodes up to the root
+    std::vector<Entry> nodes;
+
+    /// The index of the first node of each level, followed by the total node count
+    std::vector<size_t> level_offsets;
+};
+
+#endif // VECTOREXTRACTOR_PACKEDRTREE_H
@@ -28,4 +28,9 @@ void PointFeature::set_vector(double x, double y, double z) {
     point->setY(y);
     point->setZ(z);
     feature->SetGeometry(point);
-}
\ No newline at end of file
+    mark_modified();
+}
+
+const OGRGeometry *PointFeature::get_geometry() const {
+    return point;
+}
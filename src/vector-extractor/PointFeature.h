@@ -28,6 +28,8 @@ class PointFeature : public Feature {
 
     void set_vector(double x, double y, double z);
 
+    const OGRGeometry *get_geometry() const override;
+
   private:
     OGRPoint *point;
 };
@@ -36,6 +36,13 @@ std::list<std::vector<double>> PolygonFeature::get_outer_vertices() {
 
 void PolygonFeature::set_outer_vertices(std::list<std::vector<double>> vertices) {
     OGRLinearRing *ring = polygon->getExteriorRing();
+
+    // Newly created polygons are empty and don't have an exterior ring yet
+    if (ring == nullptr) {
+        polygon->addRingDirectly(new OGRLinearRing());
+        ring = polygon->getExteriorRing();
+    }
+
     ring->setNumPoints(vertices.size());
     
     int counter = 0;
@@ -45,6 +52,7 @@ void PolygonFeature::set_outer_vertices(std::list<std::vector<double>> vertices)
     }
 
     ring->closeRings();
+    mark_modified();
 }
 
 std::list<std::list<std::vector<double>>> PolygonFeature::get_holes() {
@@ -68,3 +76,24 @@ std::list<std::list<std::vector<double>>> PolygonFeature::get_holes() {
 
     return holes;
 }
+
+void PolygonFeature::add_hole(std::list<std::vector<double>> vertices) {
+    OGRLinearRing *ring = new OGRLinearRing();
+    ring->setNumPoints(vertices.size());
+
+    int counter = 0;
+    for (const std::vector<double> &vertex : vertices) {
+        ring->setPoint(counter, vertex[0], vertex[1]);
+        counter++;
+    }
+
+    ring->closeRings();
+
+    // Takes ownership of the ring
+    polygon->addRingDirectly(ring);
+    mark_modified();
+}
+
+const OGRGeometry *PolygonFeature::get_geometry() const {
+    return polygon;
+}
@@ -28,6 +28,11 @@ class PolygonFeature : public Feature {
     /// Get all cutout shapes
     std::list<std::list<std::vector<double>>> get_holes();
 
+    /// Add a new cutout shape
+    void add_hole(std::list<std::vector<double>> vertices);
+
+    const OGRGeometry *get_geometry() const override;
+
   private:
     OGRPolygon *polygon;
 };
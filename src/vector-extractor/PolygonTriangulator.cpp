@@ -0,0 +1,741 @@
+// Based on earcut (https://github.com/mapbox/earcut), see THIRD_PARTY_LICENSES.md:
+//
+// ISC License
+//
+// Copyright (c) 2016, Mapbox
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose
+// with or without fee is hereby granted, provided that the above copyright notice
+// and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH REGARD TO
+// THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS.
+// IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+// CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA
+// OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+// ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+#include "PolygonTriangulator.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace {
+
+/// Polygons with more points than this use a z-order index for finding ears
+constexpr size_t MIN_HASHED_POINTS = 80;
+
+/// A point within a ring, as part of a circular doubly linked list
+struct Node {
+    Node(int32_t index, double x, double y) : index(index), x(x), y(y) {}
+
+    /// The index of the point within the input
+    int32_t index;
+
+    double x;
+    double y;
+
+    Node *prev = nullptr;
+    Node *next = nullptr;
+
+    /// Position on the z-order curve, and the neighbours in a list sorted by it
+    int32_t z = 0;
+    Node *prev_z = nullptr;
+    Node *next_z = nullptr;
+
+    /// True for holes consisting of a single point, which are never removed as duplicates
+    bool is_steiner = false;
+};
+
+/// Twice the signed area of the triangle; negative if it is counter-clockwise (with y upwards)
+double area(const Node *p, const Node *q, const Node *r) {
+    return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+bool equals(const Node *a, const Node *b) {
+    return a->x == b->x && a->y == b->y;
+}
+
+bool is_point_in_triangle(double ax, double ay, double bx, double by, double cx, double cy,
+                          double px, double py) {
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+           (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+           (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+int sign(double value) {
+    return (value > 0.0) - (value < 0.0);
+}
+
+/// Returns true if q lies within the bounding box of p and r (for collinear points)
+bool is_on_segment(const Node *p, const Node *q, const Node *r) {
+    return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) &&
+           q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+}
+
+bool intersects(const Node *p1, const Node *q1, const Node *p2, const Node *q2) {
+    int o1 = sign(area(p1, q1, p2));
+    int o2 = sign(area(p1, q1, q2));
+    int o3 = sign(area(p2, q2, p1));
+    int o4 = sign(area(p2, q2, q1));
+
+    if (o1 != o2 && o3 != o4) { return true; }
+
+    // Collinear cases
+    return (o1 == 0 && is_on_segment(p1, p2, q1)) || (o2 == 0 && is_on_segment(p1, q2, q1)) ||
+           (o3 == 0 && is_on_segment(p2, p1, q2)) || (o4 == 0 && is_on_segment(p2, q1, q2));
+}
+
+/// Returns true if the diagonal from a to b intersects any edge of the polygon
+bool intersects_polygon(const Node *a, const Node *b) {
+    const Node *p = a;
+
+    do {
+        if (p->index != a->index && p->next->index != a->index && p->index != b->index &&
+            p->next->index != b->index && intersects(p, p->next, a, b)) {
+            return true;
+        }
+
+        p = p->next;
+    } while (p != a);
+
+    return false;
+}
+
+/// Returns true if the diagonal from a to b starts towards the inside of the polygon at a
+bool is_locally_inside(const Node *a, const Node *b) {
+    return area(a->prev, a, a->next) < 0.0
+               ? area(a, b, a->next) >= 0.0 && area(a, a->prev, b) >= 0.0
+               : area(a, b, a->prev) < 0.0 || area(a, a->next, b) < 0.0;
+}
+
+/// Returns true if the middle of the diagonal from a to b is inside the polygon
+bool is_middle_inside(const Node *a, const Node *b) {
+    const Node *p = a;
+    bool is_inside = false;
+    double px = (a->x + b->x) / 2.0;
+    double py = (a->y + b->y) / 2.0;
+
+    do {
+        if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+            (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)) {
+            is_inside = !is_inside;
+        }
+
+        p = p->next;
+    } while (p != a);
+
+    return is_inside;
+}
+
+/// Returns true if a diagonal from a to b can split the polygon into two valid polygons
+bool is_valid_diagonal(const Node *a, const Node *b) {
+    return a->next->index != b->index && a->prev->index != b->index &&
+           !intersects_polygon(a, b) &&
+           ((is_locally_inside(a, b) && is_locally_inside(b, a) && is_middle_inside(a, b) &&
+             (area(a->prev, a, b->prev) != 0.0 || area(a, b->prev, b) != 0.0)) ||
+            (equals(a, b) && area(a->prev, a, a->next) > 0.0 &&
+             area(b->prev, b, b->next) > 0.0));
+}
+
+/// Returns true if the sector of m contains the sector of p (both being reflex-free)
+bool sector_contains_sector(const Node *m, const Node *p) {
+    return area(m->prev, m, p->prev) < 0.0 && area(p->next, m, m->next) < 0.0;
+}
+
+void remove_node(Node *p) {
+    p->next->prev = p->prev;
+    p->prev->next = p->next;
+
+    if (p->prev_z != nullptr) { p->prev_z->next_z = p->next_z; }
+    if (p->next_z != nullptr) { p->next_z->prev_z = p->prev_z; }
+}
+
+/// Triangulates one polygon. Nodes are kept in a deque so that pointers to them remain valid.
+class EarClipper {
+  public:
+    EarClipper(const PolygonRings &rings, std::vector<int32_t> &triangles)
+        : rings(rings), triangles(triangles) {}
+
+    void run() {
+        if (rings.empty() || rings[0].size() < 6) { return; }
+
+        Node *outer = create_ring(0, true);
+        if (outer == nullptr || outer->next == outer->prev) { return; }
+
+        size_t point_count = 0;
+        for (const std::vector<double> &ring : rings) {
+            point_count += ring.size() / 2;
+        }
+
+        if (rings.size() > 1) { outer = eliminate_holes(outer); }
+
+        // Large polygons use a z-order curve within their bounding box for finding ears
+        if (point_count > MIN_HASHED_POINTS) {
+            min_x = min_y = std::numeric_limits<double>::max();
+            double max_x = std::numeric_limits<double>::lowest();
+            double max_y = std::numeric_limits<double>::lowest();
+
+            const std::vector<double> &points = rings[0];
+            for (size_t i = 0; i + 1 < points.size(); i += 2) {
+                min_x = std::min(min_x, points[i]);
+                min_y = std::min(min_y, points[i + 1]);
+                max_x = std::max(max_x, points[i]);
+                max_y = std::max(max_y, points[i + 1]);
+            }
+
+            double size = std::max(max_x - min_x, max_y - min_y);
+            inverse_size = size != 0.0 ? 32767.0 / size : 0.0;
+        }
+
+        clip_ears(outer, 0);
+    }
+
+  private:
+    Node *insert_node(int32_t index, double x, double y, Node *last) {
+        Node *p = &nodes.emplace_back(index, x, y);
+
+        if (last == nullptr) {
+            p->prev = p;
+            p->next = p;
+        } else {
+            p->next = last->next;
+            p->prev = last;
+            last->next->prev = p;
+            last->next = p;
+        }
+
+        return p;
+    }
+
+    /// Creates a linked list from the ring with the given index, in the given orientation
+    Node *create_ring(size_t ring_index, bool is_clockwise) {
+        const std::vector<double> &points = rings[ring_index];
+        int32_t first_index = 0;
+
+        for (size_t i = 0; i < ring_index; i++) {
+            first_index += rings[i].size() / 2;
+        }
+
+        int32_t point_count = points.size() / 2;
+        if (point_count == 0) { return nullptr; }
+
+        double signed_area = 0.0;
+        for (int32_t i = 0, j = point_count - 1; i < point_count; j = i++) {
+            signed_area +=
+                (points[j * 2] - points[i * 2]) * (points[i * 2 + 1] + points[j * 2 + 1]);
+        }
+
+        Node *last = nullptr;
+
+        if (is_clockwise == (signed_area > 0.0)) {
+            for (int32_t i = 0; i < point_count; i++) {
+                last = insert_node(first_index + i, points[i * 2], points[i * 2 + 1], last);
+            }
+        } else {
+            for (int32_t i = point_count - 1; i >= 0; i--) {
+                last = insert_node(first_index + i, points[i * 2], points[i * 2 + 1], last);
+            }
+        }
+
+        // Closed rings end with their first point
+        if (last != nullptr && equals(last, last->next)) {
+            remove_node(last);
+            last = last->next;
+        }
+
+        return last;
+    }
+
+    /// Removes duplicate and collinear points
+    Node *filter_points(Node *start, Node *end = nullptr) {
+        if (start == nullptr) { return start; }
+        if (end == nullptr) { end = start; }
+
+        Node *p = start;
+        bool is_repeated;
+
+        do {
+            is_repeated = false;
+
+            if (!p->is_steiner && (equals(p, p->next) || area(p->prev, p, p->next) == 0.0)) {
+                remove_node(p);
+                p = end = p->prev;
+
+                if (p == p->next) { break; }
+                is_repeated = true;
+            } else {
+                p = p->next;
+            }
+        } while (is_repeated || p != end);
+
+        return end;
+    }
+
+    /// Clips ears until only one triangle remains. If no ears are found, the polygon is cleaned
+    /// up (pass 1), local self-intersections are cured (pass 2), and finally it is split in two.
+    void clip_ears(Node *ear, int pass) {
+        if (ear == nullptr) { return; }
+
+        if (pass == 0 && inverse_size != 0.0) { index_curve(ear); }
+
+        Node *stop = ear;
+
+        while (ear->prev != ear->next) {
+            Node *prev = ear->prev;
+            Node *next = ear->next;
+
+            if (inverse_size != 0.0 ? is_ear_hashed(ear) : is_ear(ear)) {
+                triangles.push_back(prev->index);
+                triangles.push_back(ear->index);
+                triangles.push_back(next->index);
+
+                remove_node(ear);
+
+                ear = next->next;
+                stop = next->next;
+                continue;
+            }
+
+            ear = next;
+
+            if (ear == stop) {
+                if (pass == 0) {
+                    clip_ears(filter_points(ear), 1);
+                } else if (pass == 1) {
+                    ear = cure_local_intersections(filter_points(ear));
+                    clip_ears(ear, 2);
+                } else if (pass == 2) {
+                    split_and_clip(ear);
+                }
+
+                break;
+            }
+        }
+    }
+
+    bool is_ear(const Node *ear) const {
+        const Node *a = ear->prev;
+        const Node *b = ear;
+        const Node *c = ear->next;
+
+        // Reflex corners can't be ears
+        if (area(a, b, c) >= 0.0) { return false; }
+
+        double x0 = std::min({a->x, b->x, c->x}), y0 = std::min({a->y, b->y, c->y});
+        double x1 = std::max({a->x, b->x, c->x}), y1 = std::max({a->y, b->y, c->y});
+
+        // No other point may be inside the ear
+        for (const Node *p = c->next; p != a; p = p->next) {
+            if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+                is_point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                area(p->prev, p, p->next) >= 0.0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool is_ear_hashed(const Node *ear) const {
+        const Node *a = ear->prev;
+        const Node *b = ear;
+        const Node *c = ear->next;
+
+        if (area(a, b, c) >= 0.0) { return false; }
+
+        double x0 = std::min({a->x, b->x, c->x}), y0 = std::min({a->y, b->y, c->y});
+        double x1 = std::max({a->x, b->x, c->x}), y1 = std::max({a->y, b->y, c->y});
+
+        // Only points within the z-order range of the ear's bounding box need to be checked
+        int32_t min_z = get_z_order(x0, y0);
+        int32_t max_z = get_z_order(x1, y1);
+
+        auto is_blocking = [&](const Node *p) {
+            return p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c &&
+                   is_point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                   area(p->prev, p, p->next) >= 0.0;
+        };
+
+        const Node *p = ear->prev_z;
+        const Node *n = ear->next_z;
+
+        // Look in both directions at once
+        while (p != nullptr && p->z >= min_z && n != nullptr && n->z <= max_z) {
+            if (is_blocking(p)) { return false; }
+            p = p->prev_z;
+
+            if (is_blocking(n)) { return false; }
+            n = n->next_z;
+        }
+
+        for (; p != nullptr && p->z >= min_z; p = p->prev_z) {
+            if (is_blocking(p)) { return false; }
+        }
+
+        for (; n != nullptr && n->z <= max_z; n = n->next_z) {
+            if (is_blocking(n)) { return false; }
+        }
+
+        return true;
+    }
+
+    /// Removes small self-intersections by cutting off the triangle around them
+    Node *cure_local_intersections(Node *start) {
+        Node *p = start;
+
+        do {
+            Node *a = p->prev;
+            Node *b = p->next->next;
+
+            if (!equals(a, b) && intersects(a, p, p->next, b) && is_locally_inside(a, b) &&
+                is_locally_inside(b, a)) {
+                triangles.push_back(a->index);
+                triangles.push_back(p->index);
+                triangles.push_back(b->index);
+
+                remove_node(p);
+                remove_node(p->next);
+
+                p = start = b;
+            }
+
+            p = p->next;
+        } while (p != start);
+
+        return filter_points(p);
+    }
+
+    /// Splits the polygon along a valid diagonal and triangulates both halves separately
+    void split_and_clip(Node *start) {
+        Node *a = start;
+
+        do {
+            for (Node *b = a->next->next; b != a->prev; b = b->next) {
+                if (a->index != b->index && is_valid_diagonal(a, b)) {
+                    Node *c = split_polygon(a, b);
+
+                    a = filter_points(a, a->next);
+                    c = filter_points(c, c->next);
+
+                    clip_ears(a, 0);
+                    clip_ears(c, 0);
+                    return;
+                }
+            }
+
+            a = a->next;
+        } while (a != start);
+    }
+
+    /// Connects each hole to the outer ring, starting with the leftmost hole
+    Node *eliminate_holes(Node *outer) {
+        std::vector<Node *> queue;
+
+        for (size_t i = 1; i < rings.size(); i++) {
+            Node *list = create_ring(i, false);
+            if (list == nullptr) { continue; }
+
+            if (list == list->next) { list->is_steiner = true; }
+
+            queue.push_back(get_leftmost(list));
+        }
+
+        std::sort(queue.begin(), queue.end(), [](const Node *a, const Node *b) {
+            return a->x != b->x ? a->x < b->x : a->y < b->y;
+        });
+
+        for (Node *hole : queue) {
+            outer = eliminate_hole(hole, outer);
+        }
+
+        return outer;
+    }
+
+    Node *eliminate_hole(Node *hole, Node *outer) {
+        Node *bridge = find_hole_bridge(hole, outer);
+        if (bridge == nullptr) { return outer; }
+
+        Node *bridge_reverse = split_polygon(bridge, hole);
+
+        filter_points(bridge_reverse, bridge_reverse->next);
+
+        return filter_points(bridge, bridge->next);
+    }
+
+    /// Finds a point on the outer ring which can be connected to the hole's leftmost point
+    Node *find_hole_bridge(Node *hole, Node *outer) {
+        Node *p = outer;
+        double hx = hole->x;
+        double hy = hole->y;
+        double qx = std::numeric_limits<double>::lowest();
+        Node *m = nullptr;
+
+        // Find the segment left of the hole point which is closest to it on a horizontal ray
+        do {
+            if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+                double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+
+                if (x <= hx && x > qx) {
+                    qx = x;
+                    m = p->x < p->next->x ? p : p->next;
+
+                    if (x == hx) { return m; }
+                }
+            }
+
+            p = p->next;
+        } while (p != outer);
+
+        if (m == nullptr) { return nullptr; }
+
+        // Other points inside the triangle of the hole point, the intersection and the segment's
+        // endpoint may block the bridge; the one with the smallest angle to the ray is used
+        Node *stop = m;
+        double mx = m->x;
+        double my = m->y;
+        double min_tangent = std::numeric_limits<double>::max();
+
+        p = m;
+
+        do {
+            if (hx >= p->x && p->x >= mx && hx != p->x &&
+                is_point_in_triangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x,
+                                     p->y)) {
+                double tangent = std::abs(hy - p->y) / (hx - p->x);
+
+                if (is_locally_inside(p, hole) &&
+                    (tangent < min_tangent ||
+                     (tangent == min_tangent &&
+                      (p->x > m->x || (p->x == m->x && sector_contains_sector(m, p)))))) {
+                    m = p;
+                    min_tangent = tangent;
+                }
+            }
+
+            p = p->next;
+        } while (p != stop);
+
+        return m;
+    }
+
+    /// Links a to b with a bridge; returns the copy of b in the newly created second polygon
+    Node *split_polygon(Node *a, Node *b) {
+        Node *a2 = &nodes.emplace_back(a->index, a->x, a->y);
+        Node *b2 = &nodes.emplace_back(b->index, b->x, b->y);
+        Node *an = a->next;
+        Node *bp = b->prev;
+
+        a->next = b;
+        b->prev = a;
+
+        a2->next = an;
+        an->prev = a2;
+
+        b2->next = a2;
+        a2->prev = b2;
+
+        bp->next = b2;
+        b2->prev = bp;
+
+        return b2;
+    }
+
+    Node *get_leftmost(Node *start) {
+        Node *p = start;
+        Node *leftmost = start;
+
+        do {
+            if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)) { leftmost = p; }
+            p = p->next;
+        } while (p != start);
+
+        return leftmost;
+    }
+
+    /// Interleaves the bits of the coordinates within the bounding box, scaled to 15 bits
+    int32_t get_z_order(double x, double y) const {
+        int32_t ix = static_cast<int32_t>((x - min_x) * inverse_size);
+        int32_t iy = static_cast<int32_t>((y - min_y) * inverse_size);
+
+        ix = (ix | (ix << 8)) & 0x00FF00FF;
+        ix = (ix | (ix << 4)) & 0x0F0F0F0F;
+        ix = (ix | (ix << 2)) & 0x33333333;
+        ix = (ix | (ix << 1)) & 0x55555555;
+
+        iy = (iy | (iy << 8)) & 0x00FF00FF;
+        iy = (iy | (iy << 4)) & 0x0F0F0F0F;
+        iy = (iy | (iy << 2)) & 0x33333333;
+        iy = (iy | (iy << 1)) & 0x55555555;
+
+        return ix | (iy << 1);
+    }
+
+    /// Computes the z-order of all points and links them in z-order
+    void index_curve(Node *start) {
+        Node *p = start;
+
+        do {
+            if (p->z == 0) { p->z = get_z_order(p->x, p->y); }
+            p->prev_z = p->prev;
+            p->next_z = p->next;
+            p = p->next;
+        } while (p != start);
+
+        p->prev_z->next_z = nullptr;
+        p->prev_z = nullptr;
+
+        sort_by_z(p);
+    }
+
+    /// Sorts the z-order list with a bottom-up merge sort
+    void sort_by_z(Node *list) {
+        int in_size = 1;
+        int merge_count;
+
+        do {
+            Node *p = list;
+            Node *tail = nullptr;
+            list = nullptr;
+            merge_count = 0;
+
+            while (p != nullptr) {
+                merge_count++;
+
+                Node *q = p;
+                int p_size = 0;
+
+                for (int i = 0; i < in_size; i++) {
+                    p_size++;
+                    q = q->next_z;
+                    if (q == nullptr) { break; }
+                }
+
+                int q_size = in_size;
+
+                while (p_size > 0 || (q_size > 0 && q != nullptr)) {
+                    Node *e;
+
+                    if (p_size != 0 && (q_size == 0 || q == nullptr || p->z <= q->z)) {
+                        e = p;
+                        p = p->next_z;
+                        p_size--;
+                    } else {
+                        e = q;
+                        q = q->next_z;
+                        q_size--;
+                    }
+
+                    if (tail != nullptr) {
+                        tail->next_z = e;
+                    } else {
+                        list = e;
+                    }
+
+                    e->prev_z = tail;
+                    tail = e;
+                }
+
+                p = q;
+            }
+
+            tail->next_z = nullptr;
+            in_size *= 2;
+        } while (merge_count > 1);
+    }
+
+    const PolygonRings &rings;
+    std::vector<int32_t> &triangles;
+
+    std::deque<Node> nodes;
+
+    double min_x = 0.0;
+    double min_y = 0.0;
+    double inverse_size = 0.0;
+};
+
+/// Returns the number of points in the ring without a closing point equal to the first one
+size_t get_open_point_count(const std::vector<double> &ring) {
+    size_t point_count = ring.size() / 2;
+
+    if (point_count > 1 && ring[0] == ring[point_count * 2 - 2] &&
+        ring[1] == ring[point_count * 2 - 1]) {
+        point_count--;
+    }
+
+    return point_count;
+}
+
+} // namespace
+
+std::vector<int32_t> PolygonTriangulator::triangulate(const PolygonRings &rings) {
+    std::vector<int32_t> triangles;
+
+    EarClipper(rings, triangles).run();
+
+    // Ears are clipped counter-clockwise; flip them so that they face upwards in Godot
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+        std::swap(triangles[i + 1], triangles[i + 2]);
+    }
+
+    return triangles;
+}
+
+TriangleMesh PolygonTriangulator::triangulate_all(const std::vector<PolygonRings> &polygons) {
+    ScopedTrace trace("PolygonTriangulator::triangulate_all");
+
+    TriangleMesh mesh;
+
+    int polygon_count = static_cast<int>(polygons.size());
+    std::vector<PolygonRings> open_polygons(polygon_count);
+    std::vector<std::vector<int32_t>> polygon_triangles(polygon_count);
+
+    parallel_for_bands(
+        polygon_count,
+        [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                // Closing points would only be unused vertices
+                for (const std::vector<double> &ring : polygons[i]) {
+                    size_t point_count = get_open_point_count(ring);
+                    open_polygons[i].emplace_back(ring.begin(), ring.begin() + point_count * 2);
+                }
+
+                polygon_triangles[i] = triangulate(open_polygons[i]);
+            }
+        },
+        16);
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+
+    for (int i = 0; i < polygon_count; i++) {
+        for (const std::vector<double> &ring : open_polygons[i]) {
+            vertex_count += ring.size() / 2;
+        }
+
+        index_count += polygon_triangles[i].size();
+    }
+
+    mesh.vertices.reserve(vertex_count * 2);
+    mesh.indices.reserve(index_count);
+    mesh.polygon_offsets.reserve(polygon_count + 1);
+
+    for (int i = 0; i < polygon_count; i++) {
+        int32_t first_vertex = mesh.vertices.size() / 2;
+
+        for (const std::vector<double> &ring : open_polygons[i]) {
+            mesh.vertices.insert(mesh.vertices.end(), ring.begin(), ring.end());
+        }
+
+        for (int32_t index : polygon_triangles[i]) {
+            mesh.indices.push_back(first_vertex + index);
+        }
+
+        mesh.polygon_offsets.push_back(mesh.indices.size());
+    }
+
+    return mesh;
+}
@@ -0,0 +1,38 @@
+#ifndef VECTOREXTRACTOR_POLYGONTRIANGULATOR_H
+#define VECTOREXTRACTOR_POLYGONTRIANGULATOR_H
+
+#include <cstdint>
+#include <vector>
+
+/// A polygon as rings of consecutive x, y pairs: the outer ring, followed by its holes.
+/// Rings may be closed (with the last point equal to the first one) or not.
+using PolygonRings = std::vector<std::vector<double>>;
+
+/// The triangles of any number of polygons, merged into one mesh.
+struct TriangleMesh {
+    /// Consecutive x, y pairs
+    std::vector<double> vertices;
+
+    /// Three vertex indices per triangle, clockwise in x, y (facing up when converted to Godot's
+    /// coordinate system)
+    std::vector<int32_t> indices;
+
+    /// The index of the first index of each polygon, followed by the total index count, e.g. for
+    /// finding the triangles of a feature
+    std::vector<int64_t> polygon_offsets{0};
+};
+
+class PolygonTriangulator {
+  public:
+    /// Triangulates the polygon by ear clipping, with the holes joined to the outer ring by
+    /// bridges. Large polygons use a z-order index for finding the ears. The result refers to the
+    /// points of all rings in order. Self-intersecting polygons result in a best-effort
+    /// triangulation rather than an error.
+    static std::vector<int32_t> triangulate(const PolygonRings &rings);
+
+    /// Triangulates all polygons in parallel and merges them into one mesh. Closing points of
+    /// rings are removed from the vertices.
+    static TriangleMesh triangulate_all(const std::vector<PolygonRings> &polygons);
+};
+
+#endif // VECTOREXTRACTOR_POLYGONTRIANGULATOR_H
@@ -0,0 +1,212 @@
+#include "RibbonBuilder.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Mitres are at most this many times as long as half the width; sharper joins are flattened
+/// instead of producing long spikes
+constexpr double MAX_MITER_RATIO = 4.0;
+
+/// Points closer to their predecessor than this (in meters) are skipped
+constexpr double MIN_POINT_DISTANCE = 1e-6;
+
+/// The part of the mesh for a single line, with vertex indices starting at 0
+struct Ribbon {
+    std::vector<double> vertices;
+    std::vector<double> normals;
+    std::vector<double> uvs;
+    std::vector<int32_t> indices;
+};
+
+void add_vertex(Ribbon &ribbon, double x, double y, double z, const double normal[3], double u,
+                double v) {
+    ribbon.vertices.insert(ribbon.vertices.end(), {x, y, z});
+    ribbon.normals.insert(ribbon.normals.end(), {normal[0], normal[1], normal[2]});
+    ribbon.uvs.insert(ribbon.uvs.end(), {u, v});
+}
+
+Ribbon build_ribbon(const RibbonLine &line, bool extend_ends) {
+    Ribbon ribbon;
+
+    if (line.width <= 0.0) { return ribbon; }
+
+    // Remove duplicate points, which have no direction
+    std::vector<double> points;
+    points.reserve(line.points.size());
+
+    for (size_t i = 0; i + 2 < line.points.size(); i += 3) {
+        size_t size = points.size();
+
+        if (size > 0 && std::hypot(line.points[i] - points[size - 3],
+                                   line.points[i + 1] - points[size - 2]) < MIN_POINT_DISTANCE) {
+            continue;
+        }
+
+        points.insert(points.end(), {line.points[i], line.points[i + 1], line.points[i + 2]});
+    }
+
+    int point_count = points.size() / 3;
+    if (point_count < 2) { return ribbon; }
+
+    double half_width = line.width / 2.0;
+
+    // The normalized direction and length of each segment in x, y
+    std::vector<double> directions((point_count - 1) * 2);
+    std::vector<double> lengths(point_count - 1);
+
+    for (int i = 0; i < point_count - 1; i++) {
+        double dx = points[(i + 1) * 3] - points[i * 3];
+        double dy = points[(i + 1) * 3 + 1] - points[i * 3 + 1];
+
+        lengths[i] = std::hypot(dx, dy);
+        directions[i * 2] = dx / lengths[i];
+        directions[i * 2 + 1] = dy / lengths[i];
+    }
+
+    ribbon.vertices.reserve(point_count * 6);
+    ribbon.normals.reserve(point_count * 6);
+    ribbon.uvs.reserve(point_count * 4);
+    ribbon.indices.reserve((point_count - 1) * 6);
+
+    double distance = 0.0;
+
+    for (int i = 0; i < point_count; i++) {
+        int previous_segment = std::max(i - 1, 0);
+        int next_segment = std::min(i, point_count - 2);
+
+        // The left normals of the adjacent segments (which are the same at the ends)
+        double previous_left_x = -directions[previous_segment * 2 + 1];
+        double previous_left_y = directions[previous_segment * 2];
+        double next_left_x = -directions[next_segment * 2 + 1];
+        double next_left_y = directions[next_segment * 2];
+
+        // The mitre points halfway between both normals and is scaled so that the ribbon keeps
+        // its width along both segments
+        double miter_x = previous_left_x + next_left_x;
+        double miter_y = previous_left_y + next_left_y;
+        double miter_length = std::hypot(miter_x, miter_y);
+        double offset = half_width;
+
+        if (miter_length < MIN_POINT_DISTANCE) {
+            // The line turns back onto itself
+            miter_x = next_left_x;
+            miter_y = next_left_y;
+        } else {
+            miter_x /= miter_length;
+            miter_y /= miter_length;
+
+            double cos_angle = miter_x * next_left_x + miter_y * next_left_y;
+            offset = half_width / std::max(cos_angle, 1.0 / MAX_MITER_RATIO);
+        }
+
+        double x = points[i * 3];
+        double y = points[i * 3 + 1];
+        double z = points[i * 3 + 2];
+
+        if (i > 0) { distance += lengths[i - 1]; }
+        double v = distance;
+
+        if (extend_ends && i == 0) {
+            x -= directions[0] * half_width;
+            y -= directions[1] * half_width;
+            v -= half_width;
+        } else if (extend_ends && i == point_count - 1) {
+            x += directions[next_segment * 2] * half_width;
+            y += directions[next_segment * 2 + 1] * half_width;
+            v += half_width;
+        }
+
+        // The normal is perpendicular to the mitre and to the slope of the line at this point
+        int previous_point = std::max(i - 1, 0);
+        int next_point = std::min(i + 1, point_count - 1);
+
+        double along_x = points[next_point * 3] - points[previous_point * 3];
+        double along_y = points[next_point * 3 + 1] - points[previous_point * 3 + 1];
+        double along_z = points[next_point * 3 + 2] - points[previous_point * 3 + 2];
+
+        double normal[3] = {-along_z * miter_y, along_z * miter_x,
+                            along_x * miter_y - along_y * miter_x};
+        double normal_length = std::hypot(normal[0], normal[1], normal[2]);
+
+        if (normal_length > 0.0) {
+            for (double &component : normal) {
+                component /= normal_length;
+            }
+        } else {
+            normal[0] = 0.0;
+            normal[1] = 0.0;
+            normal[2] = 1.0;
+        }
+
+        add_vertex(ribbon, x + miter_x * offset, y + miter_y * offset, z, normal, 0.0, v);
+        add_vertex(ribbon, x - miter_x * offset, y - miter_y * offset, z, normal, 1.0, v);
+
+        if (i > 0) {
+            int32_t previous_left = (i - 1) * 2;
+            int32_t previous_right = previous_left + 1;
+            int32_t left = i * 2;
+            int32_t right = left + 1;
+
+            // Clockwise in x, y, like the triangles of PolygonTriangulator
+            ribbon.indices.insert(ribbon.indices.end(),
+                                  {previous_left, left, previous_right, left, right,
+                                   previous_right});
+        }
+    }
+
+    return ribbon;
+}
+
+} // namespace
+
+RibbonMesh RibbonBuilder::build(const std::vector<RibbonLine> &lines, bool extend_ends) {
+    ScopedTrace trace("RibbonBuilder::build");
+
+    RibbonMesh mesh;
+
+    int line_count = static_cast<int>(lines.size());
+    std::vector<Ribbon> ribbons(line_count);
+
+    parallel_for_bands(
+        line_count,
+        [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                ribbons[i] = build_ribbon(lines[i], extend_ends);
+            }
+        },
+        64);
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+
+    for (const Ribbon &ribbon : ribbons) {
+        vertex_count += ribbon.vertices.size() / 3;
+        index_count += ribbon.indices.size();
+    }
+
+    mesh.vertices.reserve(vertex_count * 3);
+    mesh.normals.reserve(vertex_count * 3);
+    mesh.uvs.reserve(vertex_count * 2);
+    mesh.indices.reserve(index_count);
+    mesh.line_offsets.reserve(line_count + 1);
+
+    for (const Ribbon &ribbon : ribbons) {
+        int32_t first_vertex = mesh.vertices.size() / 3;
+
+        mesh.vertices.insert(mesh.vertices.end(), ribbon.vertices.begin(), ribbon.vertices.end());
+        mesh.normals.insert(mesh.normals.end(), ribbon.normals.begin(), ribbon.normals.end());
+        mesh.uvs.insert(mesh.uvs.end(), ribbon.uvs.begin(), ribbon.uvs.end());
+
+        for (int32_t index : ribbon.indices) {
+            mesh.indices.push_back(first_vertex + index);
+        }
+
+        mesh.line_offsets.push_back(mesh.indices.size());
+    }
+
+    return mesh;
+}
@@ -0,0 +1,45 @@
+#ifndef VECTOREXTRACTOR_RIBBONBUILDER_H
+#define VECTOREXTRACTOR_RIBBONBUILDER_H
+
+#include <cstdint>
+#include <vector>
+
+/// A line which is turned into a ribbon of the given width, e.g. a road.
+struct RibbonLine {
+    /// Consecutive x, y, z triples in projected meters
+    std::vector<double> points;
+
+    double width;
+};
+
+/// The ribbons of any number of lines, merged into one mesh.
+struct RibbonMesh {
+    /// Consecutive x, y, z triples in projected meters
+    std::vector<double> vertices;
+
+    /// One x, y, z normal per vertex, pointing upwards from the ribbon's surface
+    std::vector<double> normals;
+
+    /// One u, v pair per vertex: u is 0 on the left and 1 on the right side of the line, v is the
+    /// distance along the line in meters
+    std::vector<double> uvs;
+
+    /// Three vertex indices per triangle, clockwise in x, y (facing up when converted to Godot's
+    /// coordinate system)
+    std::vector<int32_t> indices;
+
+    /// The index of the first index of each line, followed by the total index count
+    std::vector<int64_t> line_offsets{0};
+};
+
+class RibbonBuilder {
+  public:
+    /// Builds a ribbon along each line, in parallel, and merges them into one mesh.
+    /// Consecutive points are joined with mitres, which are limited in length at sharp angles.
+    /// Ends are cut perpendicular to the line. If extend_ends is true, they are moved outwards by
+    /// half the width, so that ribbons which end at the same point (e.g. roads at an intersection)
+    /// overlap instead of leaving a gap.
+    static RibbonMesh build(const std::vector<RibbonLine> &lines, bool extend_ends);
+};
+
+#endif // VECTOREXTRACTOR_RIBBONBUILDER_H
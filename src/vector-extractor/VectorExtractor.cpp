@@ -15,6 +15,13 @@ std::shared_ptr<NativeDataset> VectorExtractor::open_dataset(const char *path, b
     return std::make_shared<NativeDataset> (path, write_access);
 }
 
+std::shared_ptr<NativeDataset> VectorExtractor::create_memory_dataset(const char *name) {
+    GDALDriver *driver = (GDALDriver *)GDALGetDriverByName("Memory");
+    GDALDataset *dataset = driver->Create(name, 0, 0, 0, GDT_Unknown, nullptr);
+
+    return std::make_shared<NativeDataset>(dataset, name);
+}
+
 CoordinateTransform::CoordinateTransform(int from, int to) {
     // Workaround for https://github.com/OSGeo/gdal/issues/1546
     source_reference.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
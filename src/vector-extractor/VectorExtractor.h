@@ -18,6 +18,10 @@ class VectorExtractor {
     /// Returns the GDALDataset at the given path, or null.
     /// TODO: This could also be in the RasterExtractor, it's not raster- or vector-specific...
     static std::shared_ptr<NativeDataset> open_dataset(const char *path, bool write_access);
+
+    /// Returns a new, empty dataset which only exists in memory, e.g. for generated features.
+    /// The name takes the place of the path.
+    static std::shared_ptr<NativeDataset> create_memory_dataset(const char *name);
 };
 
 class CoordinateTransform {